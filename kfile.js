@@ -23,5 +23,8 @@ if (platform === Platform.Windows) {
 	project.addIncludeDir('sources/libs/dxc/inc');
 	project.addLib('sources/libs/dxc/lib/x64/dxcompiler');
 }
+else if (platform === Platform.Linux || platform === Platform.FreeBSD) {
+	project.addLib('pthread');
+}
 
 resolve(project);
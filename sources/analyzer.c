@@ -2,7 +2,11 @@
 
 #include "array.h"
 #include "errors.h"
+#include "jobs.h"
 
+#include "libs/stb_ds.h"
+
+#include <stdlib.h>
 #include <string.h>
 
 static render_pipelines all_render_pipelines;
@@ -15,107 +19,196 @@ static raytracing_pipelines all_raytracing_pipelines;
 // a pipeline group is a collection of pipelines that share shaders
 static raytracing_pipeline_groups all_raytracing_pipeline_groups;
 
-static void find_referenced_global_for_var(variable v, global_array *globals, bool read, bool write) {
-	for (global_id j = 0; get_global(j) != NULL && get_global(j)->type != NO_TYPE; ++j) {
-		global *g = get_global(j);
+// The call graph and everything that is collected along it is built lazily per function and kept until analyzer_reset. The
+// backends query it from their export jobs so the queries hold the jobs lock.
+typedef struct function_analysis {
+	bool         callees_found;
+	function_id *callees; // called functions that have code, each once in order of the first call
 
-		if (v.index == g->var_index) {
-			bool found = false;
-			for (size_t k = 0; k < globals->size; ++k) {
-				if (globals->globals[k] == j) {
-					found = true;
+	bool         referenced_functions_found;
+	function_id *referenced_functions; // all functions reachable from the function in depth-first preorder, without the function itself
 
-					if (read) {
-						globals->readable[k] = true;
-					}
+	bool     referenced_types_found;
+	type_id *referenced_types;
 
-					if (write) {
-						globals->writable[k] = true;
-					}
+	global_array *referenced_globals;
+} function_analysis;
+
+static function_analysis *analyses      = NULL;
+static uint32_t          *visited       = NULL; // per function, matches visit_generation when visited
+static size_t             analyses_size = 0;
+
+static uint32_t visit_generation = 0;
+
+void analyzer_reset(void) {
+	for (size_t analysis_index = 0; analysis_index < analyses_size; ++analysis_index) {
+		arrfree(analyses[analysis_index].callees);
+		arrfree(analyses[analysis_index].referenced_functions);
+		arrfree(analyses[analysis_index].referenced_types);
+		free(analyses[analysis_index].referenced_globals);
+	}
+
+	free(analyses);
+	free(visited);
+	analyses         = NULL;
+	visited          = NULL;
+	analyses_size    = 0;
+	visit_generation = 0;
+}
+
+static function_analysis *get_analysis(function_id id) {
+	if (id >= analyses_size) {
+		size_t functions_count = 0;
+		while (get_function((function_id)functions_count) != NULL) {
+			functions_count += 1;
+		}
+
+		debug_context context = {0};
+		check(id < functions_count, context, "Encountered a weird function id");
+
+		function_analysis *new_analyses = realloc(analyses, functions_count * sizeof(function_analysis));
+		uint32_t          *new_visited  = realloc(visited, functions_count * sizeof(uint32_t));
+		check(new_analyses != NULL && new_visited != NULL, context, "Could not allocate the call graph");
+		memset(&new_analyses[analyses_size], 0, (functions_count - analyses_size) * sizeof(function_analysis));
+		memset(&new_visited[analyses_size], 0, (functions_count - analyses_size) * sizeof(uint32_t));
+
+		analyses      = new_analyses;
+		visited       = new_visited;
+		analyses_size = functions_count;
+	}
+
+	return &analyses[id];
+}
 
+static function_id *find_callees(function_id id) {
+	function_analysis *analysis = get_analysis(id);
+	if (analysis->callees_found) {
+		return analysis->callees;
+	}
+
+	analysis->callees_found = true;
+
+	function *f = get_function(id);
+	if (f->block == NULL) {
+		// built-in
+		return NULL;
+	}
+
+	uint8_t *data = f->code.o;
+	size_t   size = f->code.size;
+
+	size_t index = 0;
+	while (index < size) {
+		opcode *o = (opcode *)&data[index];
+		if (o->type == OPCODE_CALL && o->op_call.callee != NO_FUNCTION && get_function(o->op_call.callee)->block != NULL) {
+			bool found = false;
+			for (size_t callee_index = 0; callee_index < arrlenu(analysis->callees); ++callee_index) {
+				if (analysis->callees[callee_index] == o->op_call.callee) {
+					found = true;
 					break;
 				}
 			}
 			if (!found) {
-				globals->globals[globals->size]  = j;
-				globals->readable[globals->size] = read;
-				globals->writable[globals->size] = write;
-				globals->size += 1;
+				arrput(analysis->callees, o->op_call.callee);
 			}
-			return;
 		}
+
+		index += o->size;
 	}
+
+	return analysis->callees;
 }
 
-void find_referenced_globals(function *f, global_array *globals) {
+static void visit_callees(function_id id, function_id **functions) {
+	function_id *callees = find_callees(id);
+	for (size_t callee_index = 0; callee_index < arrlenu(callees); ++callee_index) {
+		function_id callee = callees[callee_index];
+		if (visited[callee] != visit_generation) {
+			visited[callee] = visit_generation;
+			arrput(*functions, callee);
+			visit_callees(callee, functions);
+		}
+	}
+}
+
+static function_id *find_all_referenced_functions(function_id id) {
+	function_analysis *analysis = get_analysis(id);
+	if (!analysis->referenced_functions_found) {
+		visit_generation += 1;
+		visited[id] = visit_generation;
+
+		function_id *functions = NULL;
+		visit_callees(id, &functions);
+
+		analysis->referenced_functions       = functions;
+		analysis->referenced_functions_found = true;
+	}
+
+	return analysis->referenced_functions;
+}
+
+void find_referenced_functions(function *f, function **functions, size_t *functions_size) {
 	if (f->block == NULL) {
 		// built-in
 		return;
 	}
 
-	function *functions[256];
-	size_t    functions_size = 0;
+	jobs_lock();
 
-	functions[functions_size] = f;
-	functions_size += 1;
+	function_id *referenced = find_all_referenced_functions(get_function_id(f));
 
-	find_referenced_functions(f, functions, &functions_size);
+	for (size_t referenced_index = 0; referenced_index < arrlenu(referenced); ++referenced_index) {
+		function *referenced_function = get_function(referenced[referenced_index]);
 
-	for (size_t l = 0; l < functions_size; ++l) {
-		uint8_t *data = functions[l]->code.o;
-		size_t   size = functions[l]->code.size;
-
-		size_t index = 0;
-		while (index < size) {
-			opcode *o = (opcode *)&data[index];
-			switch (o->type) {
-			case OPCODE_MULTIPLY:
-			case OPCODE_DIVIDE:
-			case OPCODE_ADD:
-			case OPCODE_SUB:
-			case OPCODE_EQUALS:
-			case OPCODE_NOT_EQUALS:
-			case OPCODE_GREATER:
-			case OPCODE_GREATER_EQUAL:
-			case OPCODE_LESS:
-			case OPCODE_LESS_EQUAL: {
-				find_referenced_global_for_var(o->op_binary.left, globals, false, false);
-				find_referenced_global_for_var(o->op_binary.right, globals, false, false);
-				break;
-			}
-			case OPCODE_LOAD_ACCESS_LIST: {
-				find_referenced_global_for_var(o->op_load_access_list.from, globals, true, false);
-				break;
-			}
-			case OPCODE_STORE_ACCESS_LIST:
-			case OPCODE_SUB_AND_STORE_ACCESS_LIST:
-			case OPCODE_ADD_AND_STORE_ACCESS_LIST:
-			case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
-			case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST: {
-				find_referenced_global_for_var(o->op_store_access_list.to, globals, false, true);
+		bool found = false;
+		for (size_t j = 0; j < *functions_size; ++j) {
+			if (functions[j]->name == referenced_function->name) {
+				found = true;
 				break;
 			}
-			case OPCODE_CALL: {
-				for (uint8_t i = 0; i < o->op_call.parameters_size; ++i) {
-					find_referenced_global_for_var(o->op_call.parameters[i], globals, false, false);
-				}
-				break;
+		}
+		if (!found) {
+			functions[*functions_size] = referenced_function;
+			*functions_size += 1;
+		}
+	}
+
+	jobs_unlock();
+}
+
+static void add_referenced_global(global_array *globals, global_id g, bool read, bool write) {
+	for (size_t k = 0; k < globals->size; ++k) {
+		if (globals->globals[k] == g) {
+			if (read) {
+				globals->readable[k] = true;
 			}
-			default:
-				break;
+
+			if (write) {
+				globals->writable[k] = true;
 			}
 
-			index += o->size;
+			return;
 		}
 	}
+
+	globals->globals[globals->size]  = g;
+	globals->readable[globals->size] = read;
+	globals->writable[globals->size] = write;
+	globals->size += 1;
 }
 
-void find_referenced_functions(function *f, function **functions, size_t *functions_size) {
-	if (f->block == NULL) {
-		// built-in
-		return;
+static void find_referenced_global_for_var(variable v, global_array *globals, bool read, bool write) {
+	for (global_id j = 0; get_global(j) != NULL && get_global(j)->type != NO_TYPE; ++j) {
+		global *g = get_global(j);
+
+		if (v.index == g->var_index) {
+			add_referenced_global(globals, j, read, write);
+			return;
+		}
 	}
+}
 
+static void find_referenced_globals_in_code(function *f, global_array *globals) {
 	uint8_t *data = f->code.o;
 	size_t   size = f->code.size;
 
@@ -123,29 +216,35 @@ void find_referenced_functions(function *f, function **functions, size_t *functi
 	while (index < size) {
 		opcode *o = (opcode *)&data[index];
 		switch (o->type) {
+		case OPCODE_MULTIPLY:
+		case OPCODE_DIVIDE:
+		case OPCODE_ADD:
+		case OPCODE_SUB:
+		case OPCODE_EQUALS:
+		case OPCODE_NOT_EQUALS:
+		case OPCODE_GREATER:
+		case OPCODE_GREATER_EQUAL:
+		case OPCODE_LESS:
+		case OPCODE_LESS_EQUAL: {
+			find_referenced_global_for_var(o->op_binary.left, globals, false, false);
+			find_referenced_global_for_var(o->op_binary.right, globals, false, false);
+			break;
+		}
+		case OPCODE_LOAD_ACCESS_LIST: {
+			find_referenced_global_for_var(o->op_load_access_list.from, globals, true, false);
+			break;
+		}
+		case OPCODE_STORE_ACCESS_LIST:
+		case OPCODE_SUB_AND_STORE_ACCESS_LIST:
+		case OPCODE_ADD_AND_STORE_ACCESS_LIST:
+		case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
+		case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST: {
+			find_referenced_global_for_var(o->op_store_access_list.to, globals, false, true);
+			break;
+		}
 		case OPCODE_CALL: {
-			for (function_id i = 0; get_function(i) != NULL; ++i) {
-				function *f = get_function(i);
-				if (f->name == o->op_call.func) {
-					if (f->block == NULL) {
-						// built-in
-						break;
-					}
-
-					bool found = false;
-					for (size_t j = 0; j < *functions_size; ++j) {
-						if (functions[j]->name == o->op_call.func) {
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						functions[*functions_size] = f;
-						*functions_size += 1;
-						find_referenced_functions(f, functions, functions_size);
-					}
-					break;
-				}
+			for (uint8_t i = 0; i < o->op_call.parameters_size; ++i) {
+				find_referenced_global_for_var(o->op_call.parameters[i], globals, false, false);
 			}
 			break;
 		}
@@ -157,6 +256,40 @@ void find_referenced_functions(function *f, function **functions, size_t *functi
 	}
 }
 
+void find_referenced_globals(function *f, global_array *globals) {
+	if (f->block == NULL) {
+		// built-in
+		return;
+	}
+
+	jobs_lock();
+
+	function_id        id       = get_function_id(f);
+	function_analysis *analysis = get_analysis(id);
+
+	if (analysis->referenced_globals == NULL) {
+		global_array *referenced = (global_array *)calloc(1, sizeof(global_array));
+		debug_context context    = {0};
+		check(referenced != NULL, context, "Could not allocate referenced globals");
+
+		find_referenced_globals_in_code(f, referenced);
+
+		function_id *functions = find_all_referenced_functions(id);
+		for (size_t function_index = 0; function_index < arrlenu(functions); ++function_index) {
+			find_referenced_globals_in_code(get_function(functions[function_index]), referenced);
+		}
+
+		analysis->referenced_globals = referenced;
+	}
+
+	global_array *referenced = analysis->referenced_globals;
+	for (size_t global_index = 0; global_index < referenced->size; ++global_index) {
+		add_referenced_global(globals, referenced->globals[global_index], referenced->readable[global_index], referenced->writable[global_index]);
+	}
+
+	jobs_unlock();
+}
+
 void find_used_builtins(function *f) {
 	if (f->block == NULL) {
 		// built-in
@@ -195,18 +328,13 @@ void find_used_builtins(function *f) {
 				f->used_builtins.vertex_id = true;
 			}
 
-			for (function_id i = 0; get_function(i) != NULL; ++i) {
-				function *called = get_function(i);
-				if (called->name == o->op_call.func) {
-					find_used_builtins(f);
-
-					f->used_builtins.dispatch_thread_id |= called->used_builtins.dispatch_thread_id;
-					f->used_builtins.group_thread_id |= called->used_builtins.group_thread_id;
-					f->used_builtins.group_id |= called->used_builtins.group_id;
-					f->used_builtins.vertex_id |= called->used_builtins.vertex_id;
+			if (o->op_call.callee != NO_FUNCTION) {
+				function *called = get_function(o->op_call.callee);
 
-					break;
-				}
+				f->used_builtins.dispatch_thread_id |= called->used_builtins.dispatch_thread_id;
+				f->used_builtins.group_thread_id |= called->used_builtins.group_thread_id;
+				f->used_builtins.group_id |= called->used_builtins.group_id;
+				f->used_builtins.vertex_id |= called->used_builtins.vertex_id;
 			}
 			break;
 		}
@@ -252,7 +380,7 @@ void find_used_capabilities(function *f) {
 		switch (o->type) {
 		case OPCODE_STORE_ACCESS_LIST: {
 			variable to      = o->op_store_access_list.to;
-			type_id  to_type = to.type.type;
+			type_id  to_type = to.type;
 
 			if (is_texture(to_type)) {
 				assert(get_type(to_type)->array_size == 0);
@@ -267,7 +395,7 @@ void find_used_capabilities(function *f) {
 		}
 		case OPCODE_LOAD_ACCESS_LIST: {
 			variable from      = o->op_load_access_list.from;
-			type_id  from_type = from.type.type;
+			type_id  from_type = from.type;
 
 			if (is_texture(from_type)) {
 				f->used_capabilities.image_read = true;
@@ -306,16 +434,11 @@ void find_used_capabilities(function *f) {
 				g->usage |= GLOBAL_USAGE_TEXTURE_SAMPLE;
 			}
 
-			for (function_id i = 0; get_function(i) != NULL; ++i) {
-				function *called = get_function(i);
-				if (called->name == func_name) {
-					find_used_capabilities(f);
-
-					f->used_capabilities.image_read |= called->used_capabilities.image_read;
-					f->used_capabilities.image_write |= called->used_capabilities.image_write;
+			if (o->op_call.callee != NO_FUNCTION) {
+				function *called = get_function(o->op_call.callee);
 
-					break;
-				}
+				f->used_capabilities.image_read |= called->used_capabilities.image_read;
+				f->used_capabilities.image_write |= called->used_capabilities.image_write;
 			}
 			break;
 		}
@@ -338,47 +461,73 @@ static void add_found_type(type_id t, type_id *types, size_t *types_size) {
 	*types_size += 1;
 }
 
+static void add_referenced_type(type_id **types, type_id t) {
+	for (size_t i = 0; i < arrlenu(*types); ++i) {
+		if ((*types)[i] == t) {
+			return;
+		}
+	}
+
+	arrput(*types, t);
+}
+
+static void find_referenced_types_in_function(function *func, type_id **types) {
+	debug_context context = {0};
+	for (uint8_t parameter_index = 0; parameter_index < func->parameters_size; ++parameter_index) {
+		check(func->parameter_types[parameter_index].type != NO_TYPE, context, "Function parameter type not found");
+		add_referenced_type(types, func->parameter_types[parameter_index].type);
+	}
+	check(func->return_type.type != NO_TYPE, context, "Function return type missing");
+	add_referenced_type(types, func->return_type.type);
+
+	uint8_t *data = func->code.o;
+	size_t   size = func->code.size;
+
+	size_t index = 0;
+	while (index < size) {
+		opcode *o = (opcode *)&data[index];
+		switch (o->type) {
+		case OPCODE_VAR:
+			add_referenced_type(types, o->op_var.var.type);
+			break;
+		default:
+			break;
+		}
+
+		index += o->size;
+	}
+}
+
 void find_referenced_types(function *f, type_id *types, size_t *types_size) {
 	if (f->block == NULL) {
 		// built-in
 		return;
 	}
 
-	function *functions[256];
-	size_t    functions_size = 0;
+	jobs_lock();
 
-	functions[functions_size] = f;
-	functions_size += 1;
+	function_id        id       = get_function_id(f);
+	function_analysis *analysis = get_analysis(id);
 
-	find_referenced_functions(f, functions, &functions_size);
+	if (!analysis->referenced_types_found) {
+		type_id *referenced = NULL;
 
-	for (size_t function_index = 0; function_index < functions_size; ++function_index) {
-		function     *func    = functions[function_index];
-		debug_context context = {0};
-		for (uint8_t parameter_index = 0; parameter_index < func->parameters_size; ++parameter_index) {
-			check(func->parameter_types[parameter_index].type != NO_TYPE, context, "Function parameter type not found");
-			add_found_type(func->parameter_types[parameter_index].type, types, types_size);
-		}
-		check(func->return_type.type != NO_TYPE, context, "Function return type missing");
-		add_found_type(func->return_type.type, types, types_size);
+		find_referenced_types_in_function(f, &referenced);
 
-		uint8_t *data = functions[function_index]->code.o;
-		size_t   size = functions[function_index]->code.size;
+		function_id *functions = find_all_referenced_functions(id);
+		for (size_t function_index = 0; function_index < arrlenu(functions); ++function_index) {
+			find_referenced_types_in_function(get_function(functions[function_index]), &referenced);
+		}
 
-		size_t index = 0;
-		while (index < size) {
-			opcode *o = (opcode *)&data[index];
-			switch (o->type) {
-			case OPCODE_VAR:
-				add_found_type(o->op_var.var.type.type, types, types_size);
-				break;
-			default:
-				break;
-			}
+		analysis->referenced_types       = referenced;
+		analysis->referenced_types_found = true;
+	}
 
-			index += o->size;
-		}
+	for (size_t type_index = 0; type_index < arrlenu(analysis->referenced_types); ++type_index) {
+		add_found_type(analysis->referenced_types[type_index], types, types_size);
 	}
+
+	jobs_unlock();
 }
 
 static bool has_set(descriptor_sets *sets, descriptor_set *set) {
@@ -941,9 +1090,9 @@ void find_sampler_use() {
 			switch (o->type) {
 			case OPCODE_CALL:
 				if (o->op_call.func == add_name("sample") || o->op_call.func == add_name("sample_lod")) {
-					if (is_depth(get_type(o->op_call.parameters[0].type.type)->tex_format)) {
+					if (is_depth(get_type(o->op_call.parameters[0].type)->tex_format)) {
 
-						type *sampler_type = get_type(o->op_call.parameters[1].type.type);
+						type *sampler_type = get_type(o->op_call.parameters[1].type);
 
 						global *g = find_global_by_var(o->op_call.parameters[1]);
 						assert(g != NULL);
@@ -960,7 +1109,47 @@ void find_sampler_use() {
 	}
 }
 
+static void add_entry_point(function **functions, size_t *functions_size, function *f) {
+	if (f == NULL) {
+		return;
+	}
+
+	for (size_t function_index = 0; function_index < *functions_size; ++function_index) {
+		if (functions[function_index] == f) {
+			return;
+		}
+	}
+
+	functions[*functions_size] = f;
+	*functions_size += 1;
+}
+
+void find_entry_points(function **functions, size_t *functions_size) {
+	for (size_t pipeline_index = 0; pipeline_index < all_render_pipelines.size; ++pipeline_index) {
+		render_pipeline *pipeline = &all_render_pipelines.values[pipeline_index];
+		add_entry_point(functions, functions_size, pipeline->vertex_shader);
+		add_entry_point(functions, functions_size, pipeline->amplification_shader);
+		add_entry_point(functions, functions_size, pipeline->mesh_shader);
+		add_entry_point(functions, functions_size, pipeline->fragment_shader);
+	}
+
+	for (size_t shader_index = 0; shader_index < all_compute_shaders.size; ++shader_index) {
+		add_entry_point(functions, functions_size, all_compute_shaders.values[shader_index]);
+	}
+
+	for (size_t pipeline_index = 0; pipeline_index < all_raytracing_pipelines.size; ++pipeline_index) {
+		raytracing_pipeline *pipeline = &all_raytracing_pipelines.values[pipeline_index];
+		add_entry_point(functions, functions_size, pipeline->gen_shader);
+		add_entry_point(functions, functions_size, pipeline->miss_shader);
+		add_entry_point(functions, functions_size, pipeline->closest_shader);
+		add_entry_point(functions, functions_size, pipeline->intersection_shader);
+		add_entry_point(functions, functions_size, pipeline->any_shader);
+	}
+}
+
 void analyze(void) {
+	analyzer_reset();
+
 	find_all_render_pipelines();
 	find_render_pipeline_groups();
 
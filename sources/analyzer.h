@@ -49,6 +49,8 @@ typedef descriptor_sets descriptor_set_group;
 
 static_array(descriptor_set_group, descriptor_set_groups, 256);
 
+// The referenced functions, types and globals are collected along the call graph once per function and then appended to the
+// given arrays, skipping entries that are already there
 void find_referenced_functions(function *f, function **functions, size_t *functions_size);
 void find_referenced_types(function *f, type_id *types, size_t *types_size);
 void find_referenced_globals(function *f, global_array *globals);
@@ -60,6 +62,12 @@ descriptor_set_group *get_descriptor_set_group(uint32_t descriptor_set_group_ind
 descriptor_set_group *find_descriptor_set_group_for_pipe_type(type *t);
 descriptor_set_group *find_descriptor_set_group_for_function(function *f);
 
+// appends every shader of the render, compute and raytracing pipelines once, valid after analyze
+void find_entry_points(function **functions, size_t *functions_size);
+
 void analyze(void);
 
+// drops the call graph and everything collected along it, has to be called whenever function code changes
+void analyzer_reset(void);
+
 #endif
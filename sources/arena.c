@@ -0,0 +1,68 @@
+#include "arena.h"
+
+#include "errors.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct arena_chunk {
+	struct arena_chunk *previous;
+	size_t              size;
+	size_t              capacity;
+	max_align_t         data[];
+} arena_chunk;
+
+struct arena {
+	arena_chunk *current;
+};
+
+static arena_chunk *allocate_chunk(size_t capacity, arena_chunk *previous) {
+	arena_chunk  *chunk   = (arena_chunk *)malloc(sizeof(arena_chunk) + capacity);
+	debug_context context = {0};
+	check(chunk != NULL, context, "Could not allocate arena memory");
+	chunk->previous = previous;
+	chunk->size     = 0;
+	chunk->capacity = capacity;
+	return chunk;
+}
+
+arena *arena_create(void) {
+	arena        *a       = (arena *)malloc(sizeof(arena));
+	debug_context context = {0};
+	check(a != NULL, context, "Could not allocate arena");
+	a->current = NULL;
+	return a;
+}
+
+void *arena_alloc(arena *a, size_t size) {
+	size = (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+
+	if (a->current == NULL || a->current->size + size > a->current->capacity) {
+		a->current = allocate_chunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE, a->current);
+	}
+
+	uint8_t *memory = (uint8_t *)a->current->data + a->current->size;
+	a->current->size += size;
+	return memory;
+}
+
+void *arena_grow(arena *a, void *data, size_t size, size_t capacity, size_t element_size) {
+	void *new_data = arena_alloc(a, capacity * element_size);
+	if (size > 0) {
+		memcpy(new_data, data, size * element_size);
+	}
+	return new_data;
+}
+
+void arena_destroy(arena *a) {
+	arena_chunk *chunk = a->current;
+	while (chunk != NULL) {
+		arena_chunk *previous = chunk->previous;
+		free(chunk);
+		chunk = previous;
+	}
+	free(a);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+
+// Bump allocator, everything allocated from an arena is freed together in arena_destroy
+typedef struct arena arena;
+
+arena *arena_create(void);
+
+void *arena_alloc(arena *a, size_t size);
+
+// returns memory for capacity elements, keeping the first size elements of data
+void *arena_grow(arena *a, void *data, size_t size, size_t capacity, size_t element_size);
+
+void arena_destroy(arena *a);
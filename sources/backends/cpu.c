@@ -244,41 +244,41 @@ static void write_globals(char *code, size_t *offset, char *header_code, size_t
 	}
 }
 
-static const char *type_to_mini(type_ref t) {
-	if (t.type == int_id) {
+static const char *type_to_mini(type_id t) {
+	if (t == int_id) {
 		return "_i1";
 	}
-	else if (t.type == int2_id) {
+	else if (t == int2_id) {
 		return "_i2";
 	}
-	else if (t.type == int3_id) {
+	else if (t == int3_id) {
 		return "_i3";
 	}
-	else if (t.type == int4_id) {
+	else if (t == int4_id) {
 		return "_i4";
 	}
-	else if (t.type == uint_id) {
+	else if (t == uint_id) {
 		return "_u1";
 	}
-	else if (t.type == uint2_id) {
+	else if (t == uint2_id) {
 		return "_u2";
 	}
-	else if (t.type == uint3_id) {
+	else if (t == uint3_id) {
 		return "_u3";
 	}
-	else if (t.type == uint4_id) {
+	else if (t == uint4_id) {
 		return "_u4";
 	}
-	else if (t.type == float_id) {
+	else if (t == float_id) {
 		return "_f1";
 	}
-	else if (t.type == float2_id) {
+	else if (t == float2_id) {
 		return "_f2";
 	}
-	else if (t.type == float3_id) {
+	else if (t == float3_id) {
 		return "_f3";
 	}
-	else if (t.type == float4_id) {
+	else if (t == float4_id) {
 		return "_f4";
 	}
 	else {
@@ -483,49 +483,49 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 			switch (o->type) {
 			case OPCODE_ADD: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_add", type_string(o->op_binary.result.type.type, simd_width),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_add", type_string(o->op_binary.result.type, simd_width),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu64 ", _%" PRIu64 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu32 ", _%" PRIu32 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_SUB: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_sub", type_string(o->op_binary.result.type.type, simd_width),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_sub", type_string(o->op_binary.result.type, simd_width),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu64 ", _%" PRIu64 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu32 ", _%" PRIu32 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_MULTIPLY: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_mult", type_string(o->op_binary.result.type.type, simd_width),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_mult", type_string(o->op_binary.result.type, simd_width),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu64 ", _%" PRIu64 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu32 ", _%" PRIu32 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_DIVIDE: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_div", type_string(o->op_binary.result.type.type, simd_width),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_div", type_string(o->op_binary.result.type, simd_width),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu64 ", _%" PRIu64 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x%i(_%" PRIu32 ", _%" PRIu32 ");\n", simd_width, o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LOAD_FLOAT_CONSTANT:
 				indent(code, offset, indentation);
 				if (simd_width == 1) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = %ff;\n", type_string(o->op_load_float_constant.to.type.type, simd_width),
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = %ff;\n", type_string(o->op_load_float_constant.to.type, simd_width),
 					                   o->op_load_float_constant.to.index, o->op_load_float_constant.number);
 				}
 				else if (simd_width == 4) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_float32x4_load_all(%ff);\n",
-					                   type_string(o->op_load_float_constant.to.type.type, simd_width), o->op_load_float_constant.to.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_float32x4_load_all(%ff);\n",
+					                   type_string(o->op_load_float_constant.to.type, simd_width), o->op_load_float_constant.to.index,
 					                   o->op_load_float_constant.number);
 				}
 				break;
@@ -536,7 +536,7 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 				}
 				else if (simd_width == 4) {
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = kore_int32x4_load_all(%i);\n", type_string(o->op_load_int_constant.to.type.type, simd_width),
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = kore_int32x4_load_all(%i);\n", type_string(o->op_load_int_constant.to.type, simd_width),
 					            o->op_load_int_constant.to.index, o->op_load_int_constant.number);
 				}
 				break;
@@ -545,25 +545,25 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = group_id;\n", type_string(o->op_call.var.type.type, simd_width), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = group_id;\n", type_string(o->op_call.var.type, simd_width), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = group_thread_id;\n", type_string(o->op_call.var.type.type, simd_width),
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = group_thread_id;\n", type_string(o->op_call.var.type, simd_width),
 					                   o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = dispatch_thread_id;\n", type_string(o->op_call.var.type.type, simd_width),
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = dispatch_thread_id;\n", type_string(o->op_call.var.type, simd_width),
 					                   o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = group_index;\n", type_string(o->op_call.var.type.type, simd_width), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = group_index;\n", type_string(o->op_call.var.type, simd_width), o->op_call.var.index);
 				}
 				else {
 					const char *function_name = get_name(o->op_call.func);
@@ -582,7 +582,7 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 
 					indent(code, offset, indentation);
 
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_%s", type_string(o->op_call.var.type.type, simd_width),
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_%s", type_string(o->op_call.var.type, simd_width),
 					                   o->op_call.var.index, function_name);
 
 					for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
@@ -593,9 +593,9 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 					*offset += sprintf(&code[*offset], "_x%i(", simd_width);
 
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&code[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&code[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&code[*offset], ");\n");
@@ -614,20 +614,20 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 
 				indent(code, offset, indentation);
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
 				for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _%" PRIu64, type_string(o->op_load_access_list.to.type.type, simd_width),
+						*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _%" PRIu32, type_string(o->op_load_access_list.to.type, simd_width),
 						                   o->op_load_access_list.to.index, o->op_load_access_list.from.index);
-						*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+						*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 						break;
 					case ACCESS_MEMBER:
 						*offset += sprintf(&code[*offset], ".%s", get_name(o->op_load_access_list.access_list[i].access_member.name));
 
 						if (simd_width == 1) {
-							*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _%" PRIu64, type_string(o->op_load_access_list.to.type.type, simd_width),
+							*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _%" PRIu32, type_string(o->op_load_access_list.to.type, simd_width),
 							                   o->op_load_access_list.to.index, o->op_load_access_list.from.index);
 
 							if (global_var_index != 0) {
@@ -639,13 +639,13 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 						}
 						else if (simd_width == 4) {
 							if (global_var_index != 0) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_float32x4_load_all(_%" PRIu64,
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_float32x4_load_all(_%" PRIu32,
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index,
 								                   o->op_load_access_list.from.index);
 								*offset += sprintf(&code[*offset], "->%s", get_name(o->op_load_access_list.access_list[i].access_member.name));
 							}
 							else {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _%" PRIu64, type_string(o->op_load_access_list.to.type.type, simd_width),
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _%" PRIu32, type_string(o->op_load_access_list.to.type, simd_width),
 								                   o->op_load_access_list.to.index, o->op_load_access_list.from.index);
 								*offset += sprintf(&code[*offset], ".%s", get_name(o->op_load_access_list.access_list[i].access_member.name));
 							}
@@ -655,39 +655,39 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 					case ACCESS_SWIZZLE: {
 						swizzle *swizzle = &o->op_load_access_list.access_list[i].access_swizzle.swizzle;
 
-						if (o->op_load_access_list.from.type.type == uint2_id) {
+						if (o->op_load_access_list.from.type == uint2_id) {
 							assert(swizzle->size == 1); // TODO
 
 							if (swizzle->size == 1 && swizzle->indices[0] == 0) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_swizzle_x_u2_x%i(_%" PRIu64 ");\n",
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index, simd_width,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_swizzle_x_u2_x%i(_%" PRIu32 ");\n",
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index, simd_width,
 								                   o->op_load_access_list.from.index);
 							}
 							else if (swizzle->size == 1 && swizzle->indices[0] == 1) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_swizzle_y_u2_x%i(_%" PRIu64 ");\n",
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index, simd_width,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_swizzle_y_u2_x%i(_%" PRIu32 ");\n",
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index, simd_width,
 								                   o->op_load_access_list.from.index);
 							}
 							else {
 								assert(false); // TODO
 							}
 						}
-						else if (o->op_load_access_list.from.type.type == uint3_id) {
+						else if (o->op_load_access_list.from.type == uint3_id) {
 							assert(swizzle->size == 1); // TODO
 
 							if (swizzle->size == 2 && swizzle->indices[0] == 0 && swizzle->indices[1] == 1) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_swizzle_xy_u3_x%i(_%" PRIu64 ");\n",
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index, simd_width,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_swizzle_xy_u3_x%i(_%" PRIu32 ");\n",
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index, simd_width,
 								                   o->op_load_access_list.from.index);
 							}
 							else if (swizzle->size == 1 && swizzle->indices[0] == 0) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_swizzle_x_u3_x%i(_%" PRIu64 ");\n",
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index, simd_width,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_swizzle_x_u3_x%i(_%" PRIu32 ");\n",
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index, simd_width,
 								                   o->op_load_access_list.from.index);
 							}
 							else if (swizzle->size == 1 && swizzle->indices[0] == 1) {
-								*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_swizzle_y_u3_x%i(_%" PRIu64 ");\n",
-								                   type_string(o->op_load_access_list.to.type.type, simd_width), o->op_load_access_list.to.index, simd_width,
+								*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_swizzle_y_u3_x%i(_%" PRIu32 ");\n",
+								                   type_string(o->op_load_access_list.to.type, simd_width), o->op_load_access_list.to.index, simd_width,
 								                   o->op_load_access_list.from.index);
 							}
 							else {
@@ -717,14 +717,14 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 				else if (simd_width == 4) {
 					for (int simd_index = 0; simd_index < 4; ++simd_index) {
 						indent(code, offset, indentation);
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_store_access_list.to.index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_store_access_list.to.index);
 
-						type *s = get_type(o->op_store_access_list.to.type.type);
+						type *s = get_type(o->op_store_access_list.to.type);
 
 						for (size_t i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 							switch (o->op_store_access_list.access_list[i].kind) {
 							case ACCESS_ELEMENT:
-								*offset += sprintf(&code[*offset], "[kore_int32x4_get(_%" PRIu64 ", %i)]",
+								*offset += sprintf(&code[*offset], "[kore_int32x4_get(_%" PRIu32 ", %i)]",
 								                   o->op_store_access_list.access_list[i].access_element.index.index, simd_index);
 								break;
 							case ACCESS_MEMBER:
@@ -750,25 +750,25 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 
 						switch (o->type) {
 						case OPCODE_STORE_ACCESS_LIST:
-							*offset += sprintf(&code[*offset], " = _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+							*offset += sprintf(&code[*offset], " = _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 
 							*offset += sprintf(&code[*offset],
-							                   " = kore_cpu_compute_create_float4(kore_float32x4_get(_%" PRIu64 ".x, %i), kore_float32x4_get(_%" PRIu64
-							                   ".y, %i), kore_float32x4_get(_%" PRIu64 ".z, %i), kore_float32x4_get(_%" PRIu64 ".w, %i));\n",
+							                   " = kore_cpu_compute_create_float4(kore_float32x4_get(_%" PRIu32 ".x, %i), kore_float32x4_get(_%" PRIu32
+							                   ".y, %i), kore_float32x4_get(_%" PRIu32 ".z, %i), kore_float32x4_get(_%" PRIu32 ".w, %i));\n",
 							                   o->op_store_access_list.from.index, simd_index, o->op_store_access_list.from.index, simd_index,
 							                   o->op_store_access_list.from.index, simd_index, o->op_store_access_list.from.index, simd_index);
 							break;
 						case OPCODE_SUB_AND_STORE_ACCESS_LIST:
-							*offset += sprintf(&code[*offset], " -= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+							*offset += sprintf(&code[*offset], " -= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 							break;
 						case OPCODE_ADD_AND_STORE_ACCESS_LIST:
-							*offset += sprintf(&code[*offset], " += _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+							*offset += sprintf(&code[*offset], " += _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 							break;
 						case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
-							*offset += sprintf(&code[*offset], " /= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+							*offset += sprintf(&code[*offset], " /= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 							break;
 						case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
-							*offset += sprintf(&code[*offset], " *= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+							*offset += sprintf(&code[*offset], " *= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 							break;
 						default:
 							assert(false);
@@ -781,7 +781,7 @@ static void write_functions(char *code, const char *name, size_t *offset, functi
 			case OPCODE_RETURN: {
 				if (o->size > offsetof(opcode, op_return)) {
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "return _%" PRIu64 ";\n", o->op_return.var.index);
+					*offset += sprintf(&code[*offset], "return _%" PRIu32 ";\n", o->op_return.var.index);
 				}
 				else {
 					indent(code, offset, indentation);
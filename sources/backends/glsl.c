@@ -1,9 +1,11 @@
 #include "glsl.h"
 
 #include "../analyzer.h"
+#include "../cache.h"
 #include "../compiler.h"
 #include "../errors.h"
 #include "../functions.h"
+#include "../jobs.h"
 #include "../parser.h"
 #include "../shader_stage.h"
 #include "../types.h"
@@ -281,12 +283,12 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 
 					indent(code, offset, indentation);
 
-					if (is_depth(get_type(image_var.type.type)->tex_format)) {
-						*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = texture(_%" PRIu64 ", _%" PRIu64 ").r;\n", type_string(o->op_call.var.type.type),
+					if (is_depth(get_type(image_var.type)->tex_format)) {
+						*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = texture(_%" PRIu32 ", _%" PRIu32 ").r;\n", type_string(o->op_call.var.type),
 						                   o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[2].index);
 					}
 					else {
-						*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = texture(_%" PRIu64 ", _%" PRIu64 ");\n", type_string(o->op_call.var.type.type),
+						*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = texture(_%" PRIu32 ", _%" PRIu32 ");\n", type_string(o->op_call.var.type),
 						                   o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[2].index);
 					}
 				}
@@ -294,28 +296,28 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 					debug_context context = {0};
 					check(o->op_call.parameters_size == 4, context, "sample_lod requires four parameters");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = textureLod(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n",
-					                   type_string(o->op_call.var.type.type), o->op_call.var.index, o->op_call.parameters[0].index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = textureLod(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n",
+					                   type_string(o->op_call.var.type), o->op_call.var.index, o->op_call.parameters[0].index,
 					                   o->op_call.parameters[2].index, o->op_call.parameters[3].index);
 				}
 				else if (o->op_call.func == add_name("group_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = gl_WorkGroupID;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = gl_WorkGroupID;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = gl_LocalInvocationID;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = gl_LocalInvocationID;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = gl_GlobalInvocationID;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = gl_GlobalInvocationID;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = gl_LocalInvocationIndex;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = gl_LocalInvocationIndex;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else {
 					const char *function_name = get_name(o->op_call.func);
@@ -330,11 +332,11 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 					}
 
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = %s(", type_string(o->op_call.var.type.type), o->op_call.var.index, function_name);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = %s(", type_string(o->op_call.var.type), o->op_call.var.index, function_name);
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&code[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&code[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&code[*offset], ");\n");
@@ -356,7 +358,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 				bool from_is_input = false;
 				if (f == main) {
 					for (size_t input_index = 0; input_index < inputs_count; ++input_index) {
-						if (o->op_load_access_list.from.type.type == inputs[input_index]) {
+						if (o->op_load_access_list.from.type == inputs[input_index]) {
 							from_is_input = true;
 							break;
 						}
@@ -364,20 +366,20 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 				}
 
 				if (from_is_input) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = %s", type_string(o->op_load_access_list.to.type.type),
-					                   o->op_load_access_list.to.index, type_string(o->op_load_access_list.from.type.type));
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = %s", type_string(o->op_load_access_list.to.type),
+					                   o->op_load_access_list.to.index, type_string(o->op_load_access_list.from.type));
 				}
 				else {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _%" PRIu64, type_string(o->op_load_access_list.to.type.type),
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _%" PRIu32, type_string(o->op_load_access_list.to.type),
 					                   o->op_load_access_list.to.index, o->op_load_access_list.from.index);
 				}
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
 				for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+						*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 						break;
 					case ACCESS_MEMBER:
 						if (global_var_index != 0 || (from_is_input && i == 0)) {
@@ -416,25 +418,25 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 						type *t = get_type(f->return_type.type);
 
 						indent(code, offset, indentation + 1);
-						*offset += sprintf(&code[*offset], "gl_Position.x = _%" PRIu64 ".%s.x;\n", o->op_return.var.index, get_name(t->members.m[0].name));
+						*offset += sprintf(&code[*offset], "gl_Position.x = _%" PRIu32 ".%s.x;\n", o->op_return.var.index, get_name(t->members.m[0].name));
 						indent(code, offset, indentation + 1);
 						if (flip) {
 							*offset +=
-							    sprintf(&code[*offset], "gl_Position.y = -1.0 * _%" PRIu64 ".%s.y;\n", o->op_return.var.index, get_name(t->members.m[0].name));
+							    sprintf(&code[*offset], "gl_Position.y = -1.0 * _%" PRIu32 ".%s.y;\n", o->op_return.var.index, get_name(t->members.m[0].name));
 						}
 						else {
-							*offset += sprintf(&code[*offset], "gl_Position.y = _%" PRIu64 ".%s.y;\n", o->op_return.var.index, get_name(t->members.m[0].name));
+							*offset += sprintf(&code[*offset], "gl_Position.y = _%" PRIu32 ".%s.y;\n", o->op_return.var.index, get_name(t->members.m[0].name));
 						}
 						indent(code, offset, indentation + 1);
 						*offset +=
-						    sprintf(&code[*offset], "gl_Position.z = (_%" PRIu64 ".%s.z * 2.0) - _%" PRIu64 ".%s.w; // OpenGL clip space z is from -w to w\n",
+						    sprintf(&code[*offset], "gl_Position.z = (_%" PRIu32 ".%s.z * 2.0) - _%" PRIu32 ".%s.w; // OpenGL clip space z is from -w to w\n",
 						            o->op_return.var.index, get_name(t->members.m[0].name), o->op_return.var.index, get_name(t->members.m[0].name));
 						indent(code, offset, indentation + 1);
-						*offset += sprintf(&code[*offset], "gl_Position.w = _%" PRIu64 ".%s.w;\n", o->op_return.var.index, get_name(t->members.m[0].name));
+						*offset += sprintf(&code[*offset], "gl_Position.w = _%" PRIu32 ".%s.w;\n", o->op_return.var.index, get_name(t->members.m[0].name));
 
 						for (size_t j = 1; j < t->members.size; ++j) {
 							indent(code, offset, indentation + 1);
-							*offset += sprintf(&code[*offset], "%s_%s = _%" PRIu64 ".%s;\n", get_name(t->name), get_name(t->members.m[j].name),
+							*offset += sprintf(&code[*offset], "%s_%s = _%" PRIu32 ".%s;\n", get_name(t->name), get_name(t->members.m[j].name),
 							                   o->op_return.var.index, get_name(t->members.m[j].name));
 						}
 
@@ -448,7 +450,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 						*offset += sprintf(&code[*offset], "{\n");
 						for (uint32_t j = 0; j < get_type(f->return_type.type)->array_size; ++j) {
 							indent(code, offset, indentation + 1);
-							*offset += sprintf(&code[*offset], "_kong_colors[%i] = _%" PRIu64 "[%i];\n", j, o->op_return.var.index, j);
+							*offset += sprintf(&code[*offset], "_kong_colors[%i] = _%" PRIu32 "[%i];\n", j, o->op_return.var.index, j);
 						}
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "return;\n");
@@ -459,7 +461,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 						indent(code, offset, indentation);
 						*offset += sprintf(&code[*offset], "{\n");
 						indent(code, offset, indentation + 1);
-						*offset += sprintf(&code[*offset], "_kong_color = _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&code[*offset], "_kong_color = _%" PRIu32 ";\n", o->op_return.var.index);
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "return;\n");
 						indent(code, offset, indentation);
@@ -467,7 +469,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, type
 					}
 					else {
 						indent(code, offset, indentation);
-						*offset += sprintf(&code[*offset], "return _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&code[*offset], "return _%" PRIu32 ";\n", o->op_return.var.index);
 					}
 				}
 				else {
@@ -591,6 +593,47 @@ static void glsl_export_compute(char *directory, function *main) {
 	write_code(glsl, directory, filename, var_name);
 }
 
+typedef struct glsl_export_job {
+	char        *directory;
+	function    *main;
+	shader_stage stage;
+	bool         flip;
+} glsl_export_job;
+
+static void glsl_export_job_run(void *data, size_t index) {
+	glsl_export_job *job = &((glsl_export_job *)data)[index];
+
+	switch (job->stage) {
+	case SHADER_STAGE_VERTEX:
+		glsl_export_vertex(job->directory, job->main, job->flip);
+		break;
+	case SHADER_STAGE_FRAGMENT:
+		glsl_export_fragment(job->directory, job->main);
+		break;
+	case SHADER_STAGE_COMPUTE:
+		glsl_export_compute(job->directory, job->main);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+static void add_export_job(glsl_export_job *jobs, size_t *jobs_size, glsl_export_job job) {
+	char filename[512];
+	if (job.flip) {
+		sprintf(filename, "kong_%s_flip", get_name(job.main->name));
+	}
+	else {
+		sprintf(filename, "kong_%s", get_name(job.main->name));
+	}
+
+	if (!cache_check(filename, job.main, job.stage)) {
+		jobs[*jobs_size] = job;
+		*jobs_size += 1;
+	}
+}
+
 void glsl_export(char *directory) {
 	int cbuffer_index = 0;
 	int texture_index = 0;
@@ -646,16 +689,26 @@ void glsl_export(char *directory) {
 		}
 	}
 
+	glsl_export_job jobs[256 * 4];
+	size_t          jobs_size = 0;
+
 	for (size_t i = 0; i < vertex_shaders_size; ++i) {
-		glsl_export_vertex(directory, vertex_shaders[i], false);
-		glsl_export_vertex(directory, vertex_shaders[i], true);
+		glsl_export_job job = {.directory = directory, .main = vertex_shaders[i], .stage = SHADER_STAGE_VERTEX, .flip = false};
+		add_export_job(jobs, &jobs_size, job);
+
+		job.flip = true;
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	for (size_t i = 0; i < fragment_shaders_size; ++i) {
-		glsl_export_fragment(directory, fragment_shaders[i]);
+		glsl_export_job job = {.directory = directory, .main = fragment_shaders[i], .stage = SHADER_STAGE_FRAGMENT};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	for (size_t i = 0; i < compute_shaders_size; ++i) {
-		glsl_export_compute(directory, compute_shaders[i]);
+		glsl_export_job job = {.directory = directory, .main = compute_shaders[i], .stage = SHADER_STAGE_COMPUTE};
+		add_export_job(jobs, &jobs_size, job);
 	}
+
+	jobs_run(glsl_export_job_run, jobs, jobs_size);
 }
@@ -1,10 +1,12 @@
 #include "hlsl.h"
 
 #include "../analyzer.h"
+#include "../cache.h"
 #include "../array.h"
 #include "../compiler.h"
 #include "../errors.h"
 #include "../functions.h"
+#include "../jobs.h"
 #include "../parser.h"
 #include "../sets.h"
 #include "../shader_stage.h"
@@ -767,7 +769,9 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 					debug_context context = {0};
 					check(o->op_call.parameters_size == 3, context, "trace_ray requires three parameters");
 
-					type_id payload_type = o->op_call.parameters[2].type.type;
+					type_id payload_type = o->op_call.parameters[2].type;
+
+					jobs_lock();
 
 					bool found = false;
 					for (size_t payload_index = 0; payload_index < payload_types_count; ++payload_index) {
@@ -781,6 +785,8 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 						payload_types[payload_types_count] = payload_type;
 						payload_types_count += 1;
 					}
+
+					jobs_unlock();
 				}
 			}
 			default:
@@ -1141,25 +1147,25 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 				}
 
 				indent(hlsl, offset, indentation);
-				*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _%" PRIu64, type_string(o->op_load_access_list.to.type.type),
+				*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _%" PRIu32, type_string(o->op_load_access_list.to.type),
 				                   o->op_load_access_list.to.index, o->op_load_access_list.from.index);
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
 				for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT: {
-						type *from_type = get_type(o->op_load_access_list.from.type.type);
+						type *from_type = get_type(o->op_load_access_list.from.type);
 
 						if (from_type->array_size == UINT32_MAX && get_type(from_type->base)->tex_kind != TEXTURE_KIND_NONE) {
-							*offset += sprintf(&hlsl[*offset], "[NonUniformResourceIndex(_%" PRIu64 ")]",
+							*offset += sprintf(&hlsl[*offset], "[NonUniformResourceIndex(_%" PRIu32 ")]",
 							                   o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						else if (global_var_index != 0 && i == 0 && get_type(from_type->base)->built_in) {
-							*offset += sprintf(&hlsl[*offset], "[_%" PRIu64 "].data", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&hlsl[*offset], "[_%" PRIu32 "].data", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						else {
-							*offset += sprintf(&hlsl[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&hlsl[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						break;
 					}
@@ -1210,9 +1216,9 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 				}
 
 				indent(hlsl, offset, indentation);
-				*offset += sprintf(&hlsl[*offset], "_%" PRIu64, o->op_store_access_list.to.index);
+				*offset += sprintf(&hlsl[*offset], "_%" PRIu32, o->op_store_access_list.to.index);
 
-				type *s = get_type(o->op_store_access_list.to.type.type);
+				type *s = get_type(o->op_store_access_list.to.type);
 
 				for (size_t i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 					switch (o->op_store_access_list.access_list[i].kind) {
@@ -1220,10 +1226,10 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 						type *from_type = get_type(s->base);
 
 						if (global_var_index != 0 && i == 0 && from_type->built_in) {
-							*offset += sprintf(&hlsl[*offset], "[_%" PRIu64 "].data", o->op_store_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&hlsl[*offset], "[_%" PRIu32 "].data", o->op_store_access_list.access_list[i].access_element.index.index);
 						}
 						else {
-							*offset += sprintf(&hlsl[*offset], "[_%" PRIu64 "]", o->op_store_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&hlsl[*offset], "[_%" PRIu32 "]", o->op_store_access_list.access_list[i].access_element.index.index);
 						}
 						break;
 					}
@@ -1249,19 +1255,19 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 
 				switch (o->type) {
 				case OPCODE_STORE_ACCESS_LIST:
-					*offset += sprintf(&hlsl[*offset], " = _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&hlsl[*offset], " = _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_SUB_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&hlsl[*offset], " -= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&hlsl[*offset], " -= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_ADD_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&hlsl[*offset], " += _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&hlsl[*offset], " += _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&hlsl[*offset], " /= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&hlsl[*offset], " /= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&hlsl[*offset], " *= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&hlsl[*offset], " *= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				default:
 					assert(false);
@@ -1277,7 +1283,7 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 						indent(hlsl, offset, indentation + 1);
 						*offset += sprintf(&hlsl[*offset], "_kong_colors_out _kong_colors;\n");
 						for (uint32_t j = 0; j < get_type(f->return_type.type)->array_size; ++j) {
-							*offset += sprintf(&hlsl[*offset], "\t\t_kong_colors._%i = _%" PRIu64 "[%i];\n", j, o->op_return.var.index, j);
+							*offset += sprintf(&hlsl[*offset], "\t\t_kong_colors._%i = _%" PRIu32 "[%i];\n", j, o->op_return.var.index, j);
 						}
 						indent(hlsl, offset, indentation + 1);
 						*offset += sprintf(&hlsl[*offset], "return _kong_colors;\n");
@@ -1286,7 +1292,7 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 					}
 					else {
 						indent(hlsl, offset, indentation);
-						*offset += sprintf(&hlsl[*offset], "return _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&hlsl[*offset], "return _%" PRIu32 ";\n", o->op_return.var.index);
 					}
 				}
 				else {
@@ -1301,14 +1307,14 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 				break;
 			}
 			case OPCODE_MULTIPLY: {
-				if (o->op_binary.left.type.type == float4x4_id || o->op_binary.left.type.type == float3x3_id) {
+				if (o->op_binary.left.type == float4x4_id || o->op_binary.left.type == float3x3_id) {
 					indent(hlsl, offset, indentation);
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = mul(_%" PRIu64 ", _%" PRIu64 ");\n", type_string(o->op_binary.result.type.type),
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = mul(_%" PRIu32 ", _%" PRIu32 ");\n", type_string(o->op_binary.result.type),
 					                   o->op_binary.result.index, o->op_binary.right.index, o->op_binary.left.index);
 				}
 				else {
 					indent(hlsl, offset, indentation);
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _%" PRIu64 " * _%" PRIu64 ";\n", type_string(o->op_binary.result.type.type),
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _%" PRIu32 " * _%" PRIu32 ";\n", type_string(o->op_binary.result.type),
 					                   o->op_binary.result.index, o->op_binary.left.index, o->op_binary.right.index);
 				}
 				break;
@@ -1319,114 +1325,114 @@ static void write_functions(char *hlsl, size_t *offset, shader_stage stage, func
 				if (o->op_call.func == add_name("sample")) {
 					check(o->op_call.parameters_size == 3, context, "sample requires three parameters");
 					*offset +=
-					    sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _%" PRIu64 ".Sample(_%" PRIu64 ", _%" PRIu64 ");\n", type_string(o->op_call.var.type.type),
+					    sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _%" PRIu32 ".Sample(_%" PRIu32 ", _%" PRIu32 ");\n", type_string(o->op_call.var.type),
 					            o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[1].index, o->op_call.parameters[2].index);
 				}
 				else if (o->op_call.func == add_name("sample_lod")) {
 					check(o->op_call.parameters_size == 4, context, "sample_lod requires four parameters");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _%" PRIu64 ".SampleLevel(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n",
-					                   type_string(o->op_call.var.type.type), o->op_call.var.index, o->op_call.parameters[0].index,
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _%" PRIu32 ".SampleLevel(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n",
+					                   type_string(o->op_call.var.type), o->op_call.var.index, o->op_call.parameters[0].index,
 					                   o->op_call.parameters[1].index, o->op_call.parameters[2].index, o->op_call.parameters[3].index);
 				}
 				else if (o->op_call.func == add_name("group_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _kong_group_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _kong_group_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _kong_group_thread_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _kong_group_thread_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _kong_dispatch_thread_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _kong_dispatch_thread_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _kong_group_index;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _kong_group_index;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("instance_id")) {
 					check(o->op_call.parameters_size == 0, context, "instance_id can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = InstanceID();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = InstanceID();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("vertex_id")) {
 					check(o->op_call.parameters_size == 0, context, "vertex_id can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = _kong_vertex_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = _kong_vertex_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("world_ray_direction")) {
 					check(o->op_call.parameters_size == 0, context, "world_ray_direction can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = WorldRayDirection();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = WorldRayDirection();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("world_ray_origin")) {
 					check(o->op_call.parameters_size == 0, context, "world_ray_origin can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = WorldRayOrigin();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = WorldRayOrigin();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("ray_length")) {
 					check(o->op_call.parameters_size == 0, context, "ray_length can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = RayTCurrent();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = RayTCurrent();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("ray_index")) {
 					check(o->op_call.parameters_size == 0, context, "ray_index can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = DispatchRaysIndex();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = DispatchRaysIndex();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("ray_dimensions")) {
 					check(o->op_call.parameters_size == 0, context, "ray_dimensions can not have a parameter");
 					*offset +=
-					    sprintf(&hlsl[*offset], "%s _%" PRIu64 " = DispatchRaysDimensions();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&hlsl[*offset], "%s _%" PRIu32 " = DispatchRaysDimensions();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("object_to_world3x3")) {
 					check(o->op_call.parameters_size == 0, context, "object_to_world3x3 can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = (float3x3)ObjectToWorld4x3();\n", type_string(o->op_call.var.type.type),
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = (float3x3)ObjectToWorld4x3();\n", type_string(o->op_call.var.type),
 					                   o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("primitive_index")) {
 					check(o->op_call.parameters_size == 0, context, "primitive_index can not have a parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = PrimitiveIndex();\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = PrimitiveIndex();\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("saturate3")) {
 					check(o->op_call.parameters_size == 1, context, "saturate3 requires one parameter");
-					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = saturate(_%" PRIu64 ");\n", type_string(o->op_call.var.type.type),
+					*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = saturate(_%" PRIu32 ");\n", type_string(o->op_call.var.type),
 					                   o->op_call.var.index, o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("trace_ray")) {
 					check(o->op_call.parameters_size == 3, context, "trace_ray requires three parameters");
-					*offset += sprintf(&hlsl[*offset], "TraceRay(_%" PRIu64 ", RAY_FLAG_NONE, 0xFF, 0, 0, 0, _%" PRIu64 ", _%" PRIu64 ");\n",
+					*offset += sprintf(&hlsl[*offset], "TraceRay(_%" PRIu32 ", RAY_FLAG_NONE, 0xFF, 0, 0, 0, _%" PRIu32 ", _%" PRIu32 ");\n",
 					                   o->op_call.parameters[0].index, o->op_call.parameters[1].index, o->op_call.parameters[2].index);
 				}
 				else if (o->op_call.func == add_name("dispatch_mesh")) {
 					check(o->op_call.parameters_size == 4, context, "dispatch_mesh requires four parameters");
 					*offset +=
-					    sprintf(&hlsl[*offset], "DispatchMesh(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n", o->op_call.parameters[0].index,
+					    sprintf(&hlsl[*offset], "DispatchMesh(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n", o->op_call.parameters[0].index,
 					            o->op_call.parameters[1].index, o->op_call.parameters[2].index, o->op_call.parameters[3].index);
 				}
 				else if (o->op_call.func == add_name("set_mesh_output_counts")) {
 					check(o->op_call.parameters_size == 2, context, "set_mesh_output_counts requires two parameters");
-					*offset += sprintf(&hlsl[*offset], "SetMeshOutputCounts(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_call.parameters[0].index,
+					*offset += sprintf(&hlsl[*offset], "SetMeshOutputCounts(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_call.parameters[0].index,
 					                   o->op_call.parameters[1].index);
 				}
 				else if (o->op_call.func == add_name("set_mesh_triangle")) {
 					check(o->op_call.parameters_size == 2, context, "set_mesh_triangle requires two parameters");
-					*offset += sprintf(&hlsl[*offset], "_kong_mesh_tris[_%" PRIu64 "] = _%" PRIu64 ";\n", o->op_call.parameters[0].index,
+					*offset += sprintf(&hlsl[*offset], "_kong_mesh_tris[_%" PRIu32 "] = _%" PRIu32 ";\n", o->op_call.parameters[0].index,
 					                   o->op_call.parameters[1].index);
 				}
 				else if (o->op_call.func == add_name("set_mesh_vertex")) {
 					check(o->op_call.parameters_size == 2, context, "set_mesh_vertex requires two parameters");
-					*offset += sprintf(&hlsl[*offset], "_kong_mesh_vertices[_%" PRIu64 "] = _%" PRIu64 ";\n", o->op_call.parameters[0].index,
+					*offset += sprintf(&hlsl[*offset], "_kong_mesh_vertices[_%" PRIu32 "] = _%" PRIu32 ";\n", o->op_call.parameters[0].index,
 					                   o->op_call.parameters[1].index);
 				}
 				else {
-					if (o->op_call.var.type.type == void_id) {
+					if (o->op_call.var.type == void_id) {
 						*offset += sprintf(&hlsl[*offset], "%s(", function_string(o->op_call.func));
 					}
 					else {
-						*offset += sprintf(&hlsl[*offset], "%s _%" PRIu64 " = %s(", type_string(o->op_call.var.type.type), o->op_call.var.index,
+						*offset += sprintf(&hlsl[*offset], "%s _%" PRIu32 " = %s(", type_string(o->op_call.var.type), o->op_call.var.index,
 						                   function_string(o->op_call.func));
 					}
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&hlsl[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&hlsl[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&hlsl[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&hlsl[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&hlsl[*offset], ");\n");
@@ -1711,7 +1717,58 @@ static void hlsl_export_all_ray_shaders(char *directory, bool debug) {
 	write_bytecode(hlsl, directory, filename, var_name, output, output_size);
 }
 
+typedef struct hlsl_export_job {
+	char        *directory;
+	api_kind     d3d;
+	function    *main;
+	shader_stage stage;
+	bool         debug;
+} hlsl_export_job;
+
+static void hlsl_export_job_run(void *data, size_t index) {
+	hlsl_export_job *job = &((hlsl_export_job *)data)[index];
+
+	switch (job->stage) {
+	case SHADER_STAGE_VERTEX:
+		hlsl_export_vertex(job->directory, job->d3d, job->main, job->debug);
+		break;
+	case SHADER_STAGE_AMPLIFICATION:
+		hlsl_export_amplification(job->directory, job->main, job->debug);
+		break;
+	case SHADER_STAGE_MESH:
+		hlsl_export_mesh(job->directory, job->main, job->debug);
+		break;
+	case SHADER_STAGE_FRAGMENT:
+		hlsl_export_fragment(job->directory, job->d3d, job->main, job->debug);
+		break;
+	case SHADER_STAGE_COMPUTE:
+		hlsl_export_compute(job->directory, job->d3d, job->main, job->debug);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+static void add_export_job(hlsl_export_job *jobs, size_t *jobs_size, hlsl_export_job job) {
+	char filename[512];
+	sprintf(filename, "kong_%s", get_name(job.main->name));
+
+	if (!cache_check(filename, job.main, job.stage)) {
+		jobs[*jobs_size] = job;
+		*jobs_size += 1;
+	}
+}
+
 void hlsl_export(char *directory, api_kind d3d, bool debug) {
+	raygen_shaders_size          = 0;
+	raymiss_shaders_size         = 0;
+	rayclosesthit_shaders_size   = 0;
+	rayintersection_shaders_size = 0;
+	rayanyhit_shaders_size       = 0;
+	all_descriptor_sets_count    = 0;
+	payload_types_count          = 0;
+
 	static_array(function *, shaders, 256);
 
 	shaders vertex_shaders;
@@ -1904,28 +1961,39 @@ void hlsl_export(char *directory, api_kind d3d, bool debug) {
 		}
 	}
 
+	hlsl_export_job jobs[256 * 5];
+	size_t          jobs_size = 0;
+
 	for (size_t i = 0; i < vertex_shaders.size; ++i) {
-		hlsl_export_vertex(directory, d3d, vertex_shaders.values[i], debug);
+		hlsl_export_job job = {.directory = directory, .d3d = d3d, .main = vertex_shaders.values[i], .stage = SHADER_STAGE_VERTEX, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	if (d3d == API_DIRECT3D12) {
 		for (size_t i = 0; i < amplification_shaders.size; ++i) {
-			hlsl_export_amplification(directory, amplification_shaders.values[i], debug);
+			hlsl_export_job job = {
+			    .directory = directory, .d3d = d3d, .main = amplification_shaders.values[i], .stage = SHADER_STAGE_AMPLIFICATION, .debug = debug};
+			add_export_job(jobs, &jobs_size, job);
 		}
 
 		for (size_t i = 0; i < mesh_shaders.size; ++i) {
-			hlsl_export_mesh(directory, mesh_shaders.values[i], debug);
+			hlsl_export_job job = {.directory = directory, .d3d = d3d, .main = mesh_shaders.values[i], .stage = SHADER_STAGE_MESH, .debug = debug};
+			add_export_job(jobs, &jobs_size, job);
 		}
 	}
 
 	for (size_t i = 0; i < fragment_shaders.size; ++i) {
-		hlsl_export_fragment(directory, d3d, fragment_shaders.values[i], debug);
+		hlsl_export_job job = {.directory = directory, .d3d = d3d, .main = fragment_shaders.values[i], .stage = SHADER_STAGE_FRAGMENT, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	for (size_t i = 0; i < compute_shaders_size; ++i) {
-		hlsl_export_compute(directory, d3d, compute_shaders[i], debug);
+		hlsl_export_job job = {.directory = directory, .d3d = d3d, .main = compute_shaders[i], .stage = SHADER_STAGE_COMPUTE, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
+	jobs_run(hlsl_export_job_run, jobs, jobs_size);
+
 	if (d3d == API_DIRECT3D12) {
 		hlsl_export_all_ray_shaders(directory, debug);
 	}
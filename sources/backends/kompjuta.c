@@ -293,41 +293,41 @@ static void write_globals(char *code, size_t *offset, char *header_code, size_t
 	}
 }
 
-static const char *type_to_mini(type_ref t) {
-	if (t.type == int_id) {
+static const char *type_to_mini(type_id t) {
+	if (t == int_id) {
 		return "_i1";
 	}
-	else if (t.type == int2_id) {
+	else if (t == int2_id) {
 		return "_i2";
 	}
-	else if (t.type == int3_id) {
+	else if (t == int3_id) {
 		return "_i3";
 	}
-	else if (t.type == int4_id) {
+	else if (t == int4_id) {
 		return "_i4";
 	}
-	else if (t.type == uint_id) {
+	else if (t == uint_id) {
 		return "_u1";
 	}
-	else if (t.type == uint2_id) {
+	else if (t == uint2_id) {
 		return "_u2";
 	}
-	else if (t.type == uint3_id) {
+	else if (t == uint3_id) {
 		return "_u3";
 	}
-	else if (t.type == uint4_id) {
+	else if (t == uint4_id) {
 		return "_u4";
 	}
-	else if (t.type == float_id) {
+	else if (t == float_id) {
 		return "_f1";
 	}
-	else if (t.type == float2_id) {
+	else if (t == float2_id) {
 		return "_f2";
 	}
-	else if (t.type == float3_id) {
+	else if (t == float3_id) {
 		return "_f3";
 	}
-	else if (t.type == float4_id) {
+	else if (t == float4_id) {
 		return "_f4";
 	}
 	else {
@@ -493,73 +493,73 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 			switch (o->type) {
 			case OPCODE_ADD: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_add", type_string_simd(o->op_binary.result.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_add", type_string_simd(o->op_binary.result.type),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x32(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x32(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_SUB: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_sub", type_string_simd(o->op_binary.result.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_sub", type_string_simd(o->op_binary.result.type),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x32(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x32(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_MULTIPLY: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_mult", type_string_simd(o->op_binary.result.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_mult", type_string_simd(o->op_binary.result.type),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x32(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x32(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_DIVIDE: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_cpu_compute_div", type_string_simd(o->op_binary.result.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_cpu_compute_div", type_string_simd(o->op_binary.result.type),
 				                   o->op_binary.result.index);
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.left.type));
 				*offset += sprintf(&code[*offset], "%s", type_to_mini(o->op_binary.right.type));
-				*offset += sprintf(&code[*offset], "_x32(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "_x32(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LOAD_FLOAT_CONSTANT:
 				indent(code, offset, indentation);
 				*offset +=
-				    sprintf(&code[*offset], "%s _%" PRIu64 " = __riscv_vfmv_v_f_f32m1(%ff, _vector_length);\n",
-				            type_string_simd(o->op_load_float_constant.to.type.type), o->op_load_float_constant.to.index, o->op_load_float_constant.number);
+				    sprintf(&code[*offset], "%s _%" PRIu32 " = __riscv_vfmv_v_f_f32m1(%ff, _vector_length);\n",
+				            type_string_simd(o->op_load_float_constant.to.type), o->op_load_float_constant.to.index, o->op_load_float_constant.number);
 				break;
 			case OPCODE_LOAD_INT_CONSTANT:
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_int32x4_load_all(%i);\n", type_string_simd(o->op_load_int_constant.to.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_int32x4_load_all(%i);\n", type_string_simd(o->op_load_int_constant.to.type),
 				                   o->op_load_int_constant.to.index, o->op_load_int_constant.number);
 				break;
 			case OPCODE_CALL: {
 				if (o->op_call.func == add_name("group_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = group_id;\n", type_string_simd(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = group_id;\n", type_string_simd(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = group_thread_id;\n", type_string_simd(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = group_thread_id;\n", type_string_simd(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = dispatch_thread_id;\n", type_string_simd(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = dispatch_thread_id;\n", type_string_simd(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = group_index;\n", type_string_simd(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = group_index;\n", type_string_simd(o->op_call.var.type), o->op_call.var.index);
 				}
 				else {
 					const char *function_name = get_name(o->op_call.func);
@@ -578,7 +578,7 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 
 					indent(code, offset, indentation);
 
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = kore_riscv_%s", type_string_simd(o->op_call.var.type.type), o->op_call.var.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = kore_riscv_%s", type_string_simd(o->op_call.var.type), o->op_call.var.index,
 					                   function_name);
 
 					for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
@@ -589,9 +589,9 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 					*offset += sprintf(&code[*offset], "_x32(");
 
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&code[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&code[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&code[*offset], ");\n");
@@ -613,27 +613,27 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 				}
 
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = __riscv_vlse32_v_f32m1(", type_string_simd(o->op_load_access_list.to.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = __riscv_vlse32_v_f32m1(", type_string_simd(o->op_load_access_list.to.type),
 				                   o->op_load_access_list.to.index);
 
-				*offset += sprintf(&code[*offset], "&_%" PRIu64 "[0]", o->op_load_access_list.from.index);
+				*offset += sprintf(&code[*offset], "&_%" PRIu32 "[0]", o->op_load_access_list.from.index);
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
 				for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT: {
-						type *from_type = get_type(o->op_load_access_list.from.type.type);
+						type *from_type = get_type(o->op_load_access_list.from.type);
 
 						if (from_type->array_size == UINT32_MAX && get_type(from_type->base)->tex_kind != TEXTURE_KIND_NONE) {
-							*offset += sprintf(&code[*offset], "[NonUniformResourceIndex(_%" PRIu64 ")]",
+							*offset += sprintf(&code[*offset], "[NonUniformResourceIndex(_%" PRIu32 ")]",
 							                   o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						else if (global_var_index != 0 && i == 0 && get_type(from_type->base)->built_in) {
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "].data", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "].data", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						else {
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						break;
 					}
@@ -661,7 +661,7 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 					s = get_type(o->op_load_access_list.access_list[i].type);
 				}
 
-				*offset += sprintf(&code[*offset], ", sizeof(%s), _vector_length);\n", type_string(o->op_load_access_list.from.type.type));
+				*offset += sprintf(&code[*offset], ", sizeof(%s), _vector_length);\n", type_string(o->op_load_access_list.from.type));
 
 				break;
 			}
@@ -671,14 +671,14 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 			case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
 			case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_store_access_list.to.index);
+				*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_store_access_list.to.index);
 
-				type *s = get_type(o->op_store_access_list.to.type.type);
+				type *s = get_type(o->op_store_access_list.to.type);
 
 				for (size_t i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 					switch (o->op_store_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						*offset += sprintf(&code[*offset], "[kore_int32x4_get(_%" PRIu64 ", %i)]",
+						*offset += sprintf(&code[*offset], "[kore_int32x4_get(_%" PRIu32 ", %i)]",
 						                   o->op_store_access_list.access_list[i].access_element.index.index, 0);
 						break;
 					case ACCESS_MEMBER:
@@ -703,19 +703,19 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 
 				switch (o->type) {
 				case OPCODE_STORE_ACCESS_LIST:
-					*offset += sprintf(&code[*offset], " = _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&code[*offset], " = _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_SUB_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&code[*offset], " -= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&code[*offset], " -= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_ADD_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&code[*offset], " += _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&code[*offset], " += _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&code[*offset], " /= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&code[*offset], " /= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
-					*offset += sprintf(&code[*offset], " *= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+					*offset += sprintf(&code[*offset], " *= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 					break;
 				default:
 					assert(false);
@@ -727,7 +727,7 @@ static void write_functions(char *code, const char *main_name, size_t *offset, s
 			case OPCODE_RETURN: {
 				if (o->size > offsetof(opcode, op_return)) {
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "*_output = _%" PRIu64 ";\n", o->op_return.var.index);
+					*offset += sprintf(&code[*offset], "*_output = _%" PRIu32 ";\n", o->op_return.var.index);
 					indent(code, offset, indentation);
 					*offset += sprintf(&code[*offset], "return;\n");
 				}
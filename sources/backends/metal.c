@@ -315,14 +315,14 @@ static bool var_name(variable var, char *output_name) {
 	}
 
 	if (g == NULL || has_attribute(&g->attributes, add_name("indexed"))) {
-		sprintf(output_name, "_%" PRIu64, var.index);
+		sprintf(output_name, "_%" PRIu32, var.index);
 	}
 	else if (g->sets[0]->name == add_name("root_constants")) {
 		sprintf(output_name, "root_constants");
 		return true;
 	}
 	else {
-		sprintf(output_name, "argument_buffer0._%" PRIu64, var.index);
+		sprintf(output_name, "argument_buffer0._%" PRIu32, var.index);
 	}
 
 	return false;
@@ -476,9 +476,9 @@ static void write_functions(char *code, size_t *offset) {
 				bool root_constant = var_name(o->op_load_access_list.from, from_name);
 
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = ", type_string(o->op_load_access_list.to.type.type), o->op_load_access_list.to.index);
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = ", type_string(o->op_load_access_list.to.type), o->op_load_access_list.to.index);
 
-				type_id s = o->op_load_access_list.from.type.type;
+				type_id s = o->op_load_access_list.from.type;
 
 				for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
@@ -487,11 +487,11 @@ static void write_functions(char *code, size_t *offset) {
 							*offset += sprintf(&code[*offset], "%s", from_name);
 						}
 
-						if (is_texture(o->op_load_access_list.from.type.type) && i == 0) {
-							*offset += sprintf(&code[*offset], ".read(_%" PRIu64 ")", o->op_load_access_list.access_list[i].access_element.index.index);
+						if (is_texture(o->op_load_access_list.from.type) && i == 0) {
+							*offset += sprintf(&code[*offset], ".read(_%" PRIu32 ")", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						else {
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 						}
 						break;
 					case ACCESS_MEMBER:
@@ -548,17 +548,17 @@ static void write_functions(char *code, size_t *offset) {
 
 				*offset += sprintf(&code[*offset], "%s", to_name);
 
-				type *s = get_type(o->op_store_access_list.to.type.type);
+				type *s = get_type(o->op_store_access_list.to.type);
 
 				for (size_t i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 					switch (o->op_store_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						if (is_texture(o->op_store_access_list.to.type.type)) {
-							*offset += sprintf(&code[*offset], ".write(_%" PRIu64 ", _%" PRIu64 ");\n", o->op_store_access_list.from.index,
+						if (is_texture(o->op_store_access_list.to.type)) {
+							*offset += sprintf(&code[*offset], ".write(_%" PRIu32 ", _%" PRIu32 ");\n", o->op_store_access_list.from.index,
 							                   o->op_store_access_list.access_list[i].access_element.index.index);
 						}
 						else {
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_store_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_store_access_list.access_list[i].access_element.index.index);
 						}
 						break;
 					case ACCESS_MEMBER:
@@ -581,22 +581,22 @@ static void write_functions(char *code, size_t *offset) {
 					s = get_type(o->op_store_access_list.access_list[i].type);
 				}
 
-				if (!is_texture(o->op_store_access_list.to.type.type)) {
+				if (!is_texture(o->op_store_access_list.to.type)) {
 					switch (o->type) {
 					case OPCODE_STORE_ACCESS_LIST:
-						*offset += sprintf(&code[*offset], " = _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+						*offset += sprintf(&code[*offset], " = _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 						break;
 					case OPCODE_SUB_AND_STORE_ACCESS_LIST:
-						*offset += sprintf(&code[*offset], " -= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+						*offset += sprintf(&code[*offset], " -= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 						break;
 					case OPCODE_ADD_AND_STORE_ACCESS_LIST:
-						*offset += sprintf(&code[*offset], " += _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+						*offset += sprintf(&code[*offset], " += _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 						break;
 					case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
-						*offset += sprintf(&code[*offset], " /= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+						*offset += sprintf(&code[*offset], " /= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 						break;
 					case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
-						*offset += sprintf(&code[*offset], " *= _%" PRIu64 ";\n", o->op_store_access_list.from.index);
+						*offset += sprintf(&code[*offset], " *= _%" PRIu32 ";\n", o->op_store_access_list.from.index);
 						break;
 					default:
 						assert(false);
@@ -615,7 +615,7 @@ static void write_functions(char *code, size_t *offset) {
 						*offset += sprintf(&code[*offset], "_kong_colors_out _kong_colors;\n");
 						for (uint32_t j = 0; j < get_type(f->return_type.type)->array_size; ++j) {
 							indent(code, offset, indentation + 1);
-							*offset += sprintf(&code[*offset], "_kong_colors._%i = _%" PRIu64 "[%i];\n", j, o->op_return.var.index, j);
+							*offset += sprintf(&code[*offset], "_kong_colors._%i = _%" PRIu32 "[%i];\n", j, o->op_return.var.index, j);
 						}
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "return _kong_colors;\n");
@@ -628,7 +628,7 @@ static void write_functions(char *code, size_t *offset) {
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "_kong_color_out _kong_color;\n");
 						indent(code, offset, indentation + 1);
-						*offset += sprintf(&code[*offset], "_kong_color._0 = _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&code[*offset], "_kong_color._0 = _%" PRIu32 ";\n", o->op_return.var.index);
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "return _kong_color;\n");
 						indent(code, offset, indentation);
@@ -636,7 +636,7 @@ static void write_functions(char *code, size_t *offset) {
 					}
 					else {
 						indent(code, offset, indentation);
-						*offset += sprintf(&code[*offset], "return _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&code[*offset], "return _%" PRIu32 ";\n", o->op_return.var.index);
 					}
 				}
 				else {
@@ -660,24 +660,24 @@ static void write_functions(char *code, size_t *offset) {
 
 					variable image_var = o->op_call.parameters[0];
 
-					if (get_type(o->op_call.parameters[0].type.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
+					if (get_type(o->op_call.parameters[0].type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
 						*offset +=
 						    sprintf(&code[*offset],
-						            "%s _%" PRIu64 " = argument_buffer0._%" PRIu64 ".sample(argument_buffer0._%" PRIu64 ", _%" PRIu64 ".xy, _%" PRIu64 ".z);\n",
-						            type_string(o->op_call.var.type.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
+						            "%s _%" PRIu32 " = argument_buffer0._%" PRIu32 ".sample(argument_buffer0._%" PRIu32 ", _%" PRIu32 ".xy, _%" PRIu32 ".z);\n",
+						            type_string(o->op_call.var.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
 						            o->op_call.parameters[2].index, o->op_call.parameters[2].index);
 					}
 					else {
-						if (is_depth(get_type(image_var.type.type)->tex_format)) {
+						if (is_depth(get_type(image_var.type)->tex_format)) {
 							*offset += sprintf(&code[*offset],
-							                   "%s _%" PRIu64 " = argument_buffer0._%" PRIu64 ".sample(argument_buffer0._%" PRIu64 ", _%" PRIu64 ").r;\n",
-							                   type_string(o->op_call.var.type.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
+							                   "%s _%" PRIu32 " = argument_buffer0._%" PRIu32 ".sample(argument_buffer0._%" PRIu32 ", _%" PRIu32 ").r;\n",
+							                   type_string(o->op_call.var.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
 							                   o->op_call.parameters[2].index);
 						}
 						else {
 							*offset += sprintf(&code[*offset],
-							                   "%s _%" PRIu64 " = argument_buffer0._%" PRIu64 ".sample(argument_buffer0._%" PRIu64 ", _%" PRIu64 ");\n",
-							                   type_string(o->op_call.var.type.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
+							                   "%s _%" PRIu32 " = argument_buffer0._%" PRIu32 ".sample(argument_buffer0._%" PRIu32 ", _%" PRIu32 ");\n",
+							                   type_string(o->op_call.var.type), o->op_call.var.index, image_var.index, o->op_call.parameters[1].index,
 							                   o->op_call.parameters[2].index);
 						}
 					}
@@ -687,51 +687,51 @@ static void write_functions(char *code, size_t *offset) {
 
 					*offset +=
 					    sprintf(&code[*offset],
-					            "%s _%" PRIu64 " = argument_buffer0._%" PRIu64 ".sample(argument_buffer0._%" PRIu64 ", _%" PRIu64 ", level(_%" PRIu64 "));\n",
-					            type_string(o->op_call.var.type.type), o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[1].index,
+					            "%s _%" PRIu32 " = argument_buffer0._%" PRIu32 ".sample(argument_buffer0._%" PRIu32 ", _%" PRIu32 ", level(_%" PRIu32 "));\n",
+					            type_string(o->op_call.var.type), o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[1].index,
 					            o->op_call.parameters[2].index, o->op_call.parameters[3].index);
 				}
 				else if (o->op_call.func == add_name("group_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _kong_group_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _kong_group_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = _kong_group_thread_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = _kong_group_thread_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = _kong_dispatch_thread_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = _kong_dispatch_thread_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _kong_group_index;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _kong_group_index;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("vertex_id")) {
 					check(o->op_call.parameters_size == 0, context, "vertex_id can not have a parameter");
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = _kong_vertex_id;\n", type_string(o->op_call.var.type.type), o->op_call.var.index);
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = _kong_vertex_id;\n", type_string(o->op_call.var.type), o->op_call.var.index);
 				}
 				else if (o->op_call.func == add_name("lerp")) {
 					*offset +=
-					    sprintf(&code[*offset], "%s _%" PRIu64 " = mix(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n", type_string(o->op_call.var.type.type),
+					    sprintf(&code[*offset], "%s _%" PRIu32 " = mix(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n", type_string(o->op_call.var.type),
 					            o->op_call.var.index, o->op_call.parameters[0].index, o->op_call.parameters[1].index, o->op_call.parameters[2].index);
 				}
 				else if (o->op_call.func == add_name("frac")) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = fract(_%" PRIu64 ");\n", type_string(o->op_call.var.type.type), o->op_call.var.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = fract(_%" PRIu32 ");\n", type_string(o->op_call.var.type), o->op_call.var.index,
 					                   o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("ddx")) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = dfdx(_%" PRIu64 ");\n", type_string(o->op_call.var.type.type), o->op_call.var.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = dfdx(_%" PRIu32 ");\n", type_string(o->op_call.var.type), o->op_call.var.index,
 					                   o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("ddy")) {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = dfdy(_%" PRIu64 ");\n", type_string(o->op_call.var.type.type), o->op_call.var.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = dfdy(_%" PRIu32 ");\n", type_string(o->op_call.var.type), o->op_call.var.index,
 					                   o->op_call.parameters[0].index);
 				}
 				else {
-					*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = %s(", type_string(o->op_call.var.type.type), o->op_call.var.index,
+					*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = %s(", type_string(o->op_call.var.type), o->op_call.var.index,
 					                   function_string(o->op_call.func));
 
 					bool is_built_in = true;
@@ -751,9 +751,9 @@ static void write_functions(char *code, size_t *offset) {
 					}
 
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&code[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&code[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&code[*offset], ");\n");
@@ -762,7 +762,7 @@ static void write_functions(char *code, size_t *offset) {
 			}
 			case OPCODE_MOD: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "%s _%" PRIu64 " = fmod(_%" PRIu64 ", _%" PRIu64 ");\n", type_string(o->op_binary.result.type.type),
+				*offset += sprintf(&code[*offset], "%s _%" PRIu32 " = fmod(_%" PRIu32 ", _%" PRIu32 ");\n", type_string(o->op_binary.result.type),
 				                   o->op_binary.result.index, o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
@@ -804,6 +804,12 @@ static void metal_export_everything(char *directory) {
 }
 
 void metal_export(char *directory) {
+	vertex_inputs_size      = 0;
+	fragment_inputs_size    = 0;
+	vertex_functions_size   = 0;
+	fragment_functions_size = 0;
+	compute_functions_size  = 0;
+
 	int cbuffer_index = 0;
 	int texture_index = 0;
 	int sampler_index = 0;
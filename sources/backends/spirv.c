@@ -1,10 +1,13 @@
 #include "spirv.h"
 
 #include "../analyzer.h"
+#include "../cache.h"
 #include "../compiler.h"
 #include "../errors.h"
 #include "../functions.h"
 #include "../hashmap.h"
+#include "../ir.h"
+#include "../jobs.h"
 #include "../log.h"
 #include "../parser.h"
 #include "../shader_stage.h"
@@ -26,38 +29,64 @@ typedef struct spirv_id {
 typedef struct instructions_buffer {
 	uint32_t *instructions;
 	size_t    offset;
+	size_t    capacity;
 } instructions_buffer;
 
+static void instructions_buffer_reserve(instructions_buffer *instructions, size_t words) {
+	size_t size = instructions->offset + words;
+	if (size <= instructions->capacity) {
+		return;
+	}
+
+	size_t capacity = instructions->capacity == 0 ? 1024 : instructions->capacity;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	uint32_t     *new_instructions = (uint32_t *)realloc(instructions->instructions, capacity * sizeof(uint32_t));
+	debug_context context          = {0};
+	check(new_instructions != NULL, context, "Could not allocate SPIR-V instructions");
+	instructions->instructions = new_instructions;
+	instructions->capacity     = capacity;
+}
+
+static void instructions_buffer_free(instructions_buffer *instructions) {
+	free(instructions->instructions);
+	instructions->instructions = NULL;
+	instructions->offset       = 0;
+	instructions->capacity     = 0;
+}
+
 static void write_buffer(FILE *file, uint8_t *output, size_t output_size) {
 	for (size_t i = 0; i < output_size; ++i) {
 		// based on the encoding described in https://github.com/adobe/bin2c
 		if (output[i] == '!' || output[i] == '#' || (output[i] >= '%' && output[i] <= '>') || (output[i] >= 'A' && output[i] <= '[') ||
 		    (output[i] >= ']' && output[i] <= '~')) {
-			fprintf(file, "%c", output[i]);
+			putc(output[i], file);
 		}
 		else if (output[i] == '\a') {
-			fprintf(file, "\\a");
+			fputs("\\a", file);
 		}
 		else if (output[i] == '\b') {
-			fprintf(file, "\\b");
+			fputs("\\b", file);
 		}
 		else if (output[i] == '\t') {
-			fprintf(file, "\\t");
+			fputs("\\t", file);
 		}
 		else if (output[i] == '\v') {
-			fprintf(file, "\\v");
+			fputs("\\v", file);
 		}
 		else if (output[i] == '\f') {
-			fprintf(file, "\\f");
+			fputs("\\f", file);
 		}
 		else if (output[i] == '\r') {
-			fprintf(file, "\\r");
+			fputs("\\r", file);
 		}
 		else if (output[i] == '\"') {
-			fprintf(file, "\\\"");
+			fputs("\\\"", file);
 		}
 		else if (output[i] == '\\') {
-			fprintf(file, "\\\\");
+			fputs("\\\\", file);
 		}
 		else {
 			fprintf(file, "\\%03o", output[i]);
@@ -68,26 +97,24 @@ static void write_buffer(FILE *file, uint8_t *output, size_t output_size) {
 static void write_bytecode(char *directory, const char *filename, const char *name, instructions_buffer *header, instructions_buffer *decorations,
                            instructions_buffer *base_types, instructions_buffer *constants, instructions_buffer *aggregate_types,
                            instructions_buffer *global_vars, instructions_buffer *instructions, bool debug) {
-	uint8_t *output_header      = (uint8_t *)header->instructions;
-	size_t   output_header_size = header->offset * 4;
-
-	uint8_t *output_decorations      = (uint8_t *)decorations->instructions;
-	size_t   output_decorations_size = decorations->offset * 4;
-
-	uint8_t *output_base_types      = (uint8_t *)base_types->instructions;
-	size_t   output_base_types_size = base_types->offset * 4;
-
-	uint8_t *output_constants      = (uint8_t *)constants->instructions;
-	size_t   output_constants_size = constants->offset * 4;
+	instructions_buffer *sections[] = {header, decorations, base_types, constants, aggregate_types, global_vars, instructions};
 
-	uint8_t *output_aggregate_types      = (uint8_t *)aggregate_types->instructions;
-	size_t   output_aggregate_types_size = aggregate_types->offset * 4;
+	size_t output_size = 0;
+	for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+		output_size += sections[i]->offset * 4;
+	}
 
-	uint8_t *output_global_vars      = (uint8_t *)global_vars->instructions;
-	size_t   output_global_vars_size = global_vars->offset * 4;
+	uint8_t      *output  = (uint8_t *)malloc(output_size);
+	debug_context context = {0};
+	check(output != NULL, context, "Could not allocate SPIR-V output");
 
-	uint8_t *output_instructions      = (uint8_t *)instructions->instructions;
-	size_t   output_instructions_size = instructions->offset * 4;
+	size_t output_offset = 0;
+	for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+		if (sections[i]->offset > 0) {
+			memcpy(&output[output_offset], sections[i]->instructions, sections[i]->offset * 4);
+			output_offset += sections[i]->offset * 4;
+		}
+	}
 
 	char full_filename[512];
 
@@ -108,18 +135,10 @@ static void write_bytecode(char *directory, const char *filename, const char *na
 		fprintf(file, "#include \"%s.h\"\n\n", filename);
 
 		fprintf(file, "uint8_t *%s = \"", name);
-		write_buffer(file, output_header, output_header_size);
-		write_buffer(file, output_decorations, output_decorations_size);
-		write_buffer(file, output_base_types, output_base_types_size);
-		write_buffer(file, output_constants, output_constants_size);
-		write_buffer(file, output_aggregate_types, output_aggregate_types_size);
-		write_buffer(file, output_global_vars, output_global_vars_size);
-		write_buffer(file, output_instructions, output_instructions_size);
+		write_buffer(file, output, output_size);
 		fprintf(file, "\";\n");
 
-		fprintf(file, "size_t %s_size = %zu;\n\n", name,
-		        output_header_size + output_decorations_size + output_base_types_size + output_constants_size + output_aggregate_types_size +
-		            output_global_vars_size + output_instructions_size);
+		fprintf(file, "size_t %s_size = %zu;\n\n", name, output_size);
 
 		fclose(file);
 	}
@@ -132,13 +151,7 @@ static void write_bytecode(char *directory, const char *filename, const char *na
 		sprintf(full_filename, "%s/%s.spirv", directory, filename);
 
 		FILE *file = fopen(full_filename, "wb");
-		fwrite(output_header, 1, output_header_size, file);
-		fwrite(output_decorations, 1, output_decorations_size, file);
-		fwrite(output_base_types, 1, output_base_types_size, file);
-		fwrite(output_constants, 1, output_constants_size, file);
-		fwrite(output_aggregate_types, 1, output_aggregate_types_size, file);
-		fwrite(output_global_vars, 1, output_global_vars_size, file);
-		fwrite(output_instructions, 1, output_instructions_size, file);
+		fwrite(output, 1, output_size, file);
 		fclose(file);
 
 		char command[1024];
@@ -151,13 +164,15 @@ static void write_bytecode(char *directory, const char *filename, const char *na
 			kong_log(LOG_LEVEL_WARNING, "Could not run spirv_val.");
 		}
 		else if (exit_code != 0) {
-			debug_context context = {0};
 			error(context, "spirv_val check of %s failed with exit code %u.", filename, exit_code);
 		}
 	}
+
+	free(output);
 }
 
 typedef enum spirv_opcode {
+	SPIRV_OPCODE_UNDEF                     = 1,
 	SPIRV_OPCODE_EXT_INST_IMPORT           = 11,
 	SPIRV_OPCODE_EXT_INST                  = 12,
 	SPIRV_OPCODE_MEMORY_MODEL              = 14,
@@ -189,8 +204,10 @@ typedef enum spirv_opcode {
 	SPIRV_OPCODE_ACCESS_CHAIN              = 65,
 	SPIRV_OPCODE_DECORATE                  = 71,
 	SPIRV_OPCODE_MEMBER_DECORATE           = 72,
+	SPIRV_OPCODE_VECTOR_SHUFFLE            = 79,
 	SPIRV_OPCODE_COMPOSITE_CONSTRUCT       = 80,
 	SPIRV_OPCODE_COMPOSITE_EXTRACT         = 81,
+	SPIRV_OPCODE_COMPOSITE_INSERT          = 82,
 	SPIRV_OPCODE_SAMPLED_IMAGE             = 86,
 	SPIRV_OPCODE_IMAGE_SAMPLE_IMPLICIT_LOD = 87,
 	SPIRV_OPCODE_IMAGE_SAMPLE_EXPLICIT_LOD = 88,
@@ -240,6 +257,7 @@ typedef enum spirv_opcode {
 	SPIRV_OPCODE_BITWISE_AND               = 199,
 	SPIRV_OPCODE_DPDX                      = 207,
 	SPIRV_OPCODE_DPDY                      = 208,
+	SPIRV_OPCODE_PHI                       = 245,
 	SPIRV_OPCODE_LOOP_MERGE                = 246,
 	SPIRV_OPCODE_SELECTION_MERGE           = 247,
 	SPIRV_OPCODE_LABEL                     = 248,
@@ -400,13 +418,19 @@ typedef enum image_format {
 	IMAGE_FORMAT_RGBA8_SNORM = 5,
 } image_format;
 
-static uint32_t operands_buffer[4096];
+static KONG_THREAD_LOCAL uint32_t operands_buffer[4096];
+
+static void write_word(instructions_buffer *instructions, uint32_t word) {
+	instructions_buffer_reserve(instructions, 1);
+	instructions->instructions[instructions->offset++] = word;
+}
 
 static void write_simple_instruction(instructions_buffer *instructions, spirv_opcode o) {
-	instructions->instructions[instructions->offset++] = (1 << 16) | (uint16_t)o;
+	write_word(instructions, (1 << 16) | (uint16_t)o);
 }
 
 static void write_instruction(instructions_buffer *instructions, uint16_t word_count, spirv_opcode o, uint32_t *operands) {
+	instructions_buffer_reserve(instructions, word_count);
 	instructions->instructions[instructions->offset++] = (word_count << 16) | (uint16_t)o;
 	for (uint16_t i = 0; i < word_count - 1; ++i) {
 		instructions->instructions[instructions->offset++] = operands[i];
@@ -414,25 +438,25 @@ static void write_instruction(instructions_buffer *instructions, uint16_t word_c
 }
 
 static void write_magic_number(instructions_buffer *instructions) {
-	instructions->instructions[instructions->offset++] = 0x07230203;
+	write_word(instructions, 0x07230203);
 }
 
 static void write_version_number(instructions_buffer *instructions) {
-	instructions->instructions[instructions->offset++] = 0x00010000;
+	write_word(instructions, 0x00010000);
 }
 
 static void write_generator_magic_number(instructions_buffer *instructions) {
-	instructions->instructions[instructions->offset++] = 44;
+	write_word(instructions, 44);
 }
 
-static uint32_t next_index = 1;
+static KONG_THREAD_LOCAL uint32_t next_index = 1;
 
 static void write_bound(instructions_buffer *instructions) {
-	instructions->instructions[instructions->offset++] = next_index;
+	write_word(instructions, next_index);
 }
 
 static void write_instruction_schema(instructions_buffer *instructions) {
-	instructions->instructions[instructions->offset++] = 0; // reserved in SPIR-V for later use, currently always zero
+	write_word(instructions, 0); // reserved in SPIR-V for later use, currently always zero
 }
 
 static void write_capability(instructions_buffer *instructions, capability c) {
@@ -633,44 +657,44 @@ static spirv_id write_type_pointer_preallocated(instructions_buffer *instruction
 	return pointer_type;
 }
 
-static spirv_id void_type;
-static spirv_id void_function_type;
-static spirv_id spirv_float_type;
-static spirv_id spirv_float2_type;
-static spirv_id spirv_float3_type;
-static spirv_id spirv_float4_type;
-static spirv_id spirv_int_type;
-static spirv_id spirv_int2_type;
-static spirv_id spirv_int3_type;
-static spirv_id spirv_int4_type;
-static spirv_id spirv_uint_type;
-static spirv_id spirv_uint2_type;
-static spirv_id spirv_uint3_type;
-static spirv_id spirv_uint4_type;
-static spirv_id spirv_bool_type;
-static spirv_id spirv_sampler_type;
-static spirv_id spirv_sampler_pointer_type;
-static spirv_id spirv_image_type;
-static spirv_id spirv_image_pointer_type;
-static spirv_id spirv_image2darray_type;
-static spirv_id spirv_image2darray_pointer_type;
-static spirv_id spirv_imagecube_type;
-static spirv_id spirv_imagecube_pointer_type;
-static spirv_id spirv_readwrite_image_type;
-static spirv_id spirv_readwrite_image_pointer_type;
-static spirv_id spirv_sampled_image_type;
-static spirv_id spirv_sampled_image2darray_type;
-static spirv_id spirv_sampled_imagecube_type;
-static spirv_id spirv_float3x3_type;
-static spirv_id spirv_float4x4_type;
-
-static spirv_id glsl_import;
-
-static spirv_id dispatch_thread_id_variable;
-static spirv_id group_thread_id_variable;
-static spirv_id group_id_variable;
-static spirv_id work_group_size_variable;
-static spirv_id vertex_id_variable;
+static KONG_THREAD_LOCAL spirv_id void_type;
+static KONG_THREAD_LOCAL spirv_id void_function_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float2_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float3_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float4_type;
+static KONG_THREAD_LOCAL spirv_id spirv_int_type;
+static KONG_THREAD_LOCAL spirv_id spirv_int2_type;
+static KONG_THREAD_LOCAL spirv_id spirv_int3_type;
+static KONG_THREAD_LOCAL spirv_id spirv_int4_type;
+static KONG_THREAD_LOCAL spirv_id spirv_uint_type;
+static KONG_THREAD_LOCAL spirv_id spirv_uint2_type;
+static KONG_THREAD_LOCAL spirv_id spirv_uint3_type;
+static KONG_THREAD_LOCAL spirv_id spirv_uint4_type;
+static KONG_THREAD_LOCAL spirv_id spirv_bool_type;
+static KONG_THREAD_LOCAL spirv_id spirv_sampler_type;
+static KONG_THREAD_LOCAL spirv_id spirv_sampler_pointer_type;
+static KONG_THREAD_LOCAL spirv_id spirv_image_type;
+static KONG_THREAD_LOCAL spirv_id spirv_image_pointer_type;
+static KONG_THREAD_LOCAL spirv_id spirv_image2darray_type;
+static KONG_THREAD_LOCAL spirv_id spirv_image2darray_pointer_type;
+static KONG_THREAD_LOCAL spirv_id spirv_imagecube_type;
+static KONG_THREAD_LOCAL spirv_id spirv_imagecube_pointer_type;
+static KONG_THREAD_LOCAL spirv_id spirv_readwrite_image_type;
+static KONG_THREAD_LOCAL spirv_id spirv_readwrite_image_pointer_type;
+static KONG_THREAD_LOCAL spirv_id spirv_sampled_image_type;
+static KONG_THREAD_LOCAL spirv_id spirv_sampled_image2darray_type;
+static KONG_THREAD_LOCAL spirv_id spirv_sampled_imagecube_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float3x3_type;
+static KONG_THREAD_LOCAL spirv_id spirv_float4x4_type;
+
+static KONG_THREAD_LOCAL spirv_id glsl_import;
+
+static KONG_THREAD_LOCAL spirv_id dispatch_thread_id_variable;
+static KONG_THREAD_LOCAL spirv_id group_thread_id_variable;
+static KONG_THREAD_LOCAL spirv_id group_id_variable;
+static KONG_THREAD_LOCAL spirv_id work_group_size_variable;
+static KONG_THREAD_LOCAL spirv_id vertex_id_variable;
 
 typedef struct complex_type {
 	type_id  type;
@@ -678,7 +702,7 @@ typedef struct complex_type {
 	uint16_t storage;
 } complex_type;
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	complex_type key;
 	spirv_id     value;
 } *type_map = NULL;
@@ -731,7 +755,7 @@ static spirv_id convert_pointer_type_to_spirv_id(type_id type, storage_class sto
 	return spirv_index;
 }
 
-static spirv_id output_struct_pointer_type = {0};
+static KONG_THREAD_LOCAL spirv_id output_struct_pointer_type = {0};
 
 static void write_base_types(instructions_buffer *buffer) {
 	void_type = write_type_void(buffer);
@@ -833,7 +857,7 @@ typedef struct pointer_relation {
 } pointer_relation;
 
 static_array(pointer_relation, written_pointers, 256);
-static written_pointers written_pointer_relations;
+static KONG_THREAD_LOCAL written_pointers written_pointer_relations;
 
 static void write_types(instructions_buffer *buffer, function *main) {
 	type_id types[256];
@@ -924,6 +948,11 @@ static spirv_id write_constant_bool(instructions_buffer *instructions, spirv_id
 	return write_constant(instructions, spirv_bool_type, value_id, uint32_value);
 }
 
+static void write_undefined_value(instructions_buffer *instructions, spirv_id type, spirv_id value_id) {
+	uint32_t operands[] = {type.id, value_id.id};
+	write_instruction(instructions, WORD_COUNT(operands), SPIRV_OPCODE_UNDEF, operands);
+}
+
 static void write_constant_composite_preallocated3(instructions_buffer *instructions, spirv_id result_type, spirv_id result, spirv_id consituent0,
                                                    spirv_id consituent1, spirv_id consituent2) {
 	uint32_t operands[] = {result_type.id, result.id, consituent0.id, consituent1.id, consituent2.id};
@@ -1033,6 +1062,14 @@ static void write_op_branch(instructions_buffer *instructions, spirv_id target)
 	write_instruction(instructions, WORD_COUNT(operands), SPIRV_OPCODE_BRANCH, operands);
 }
 
+// returns the word offset of value2 so the value coming in over the back edge of a loop can be filled in later
+static size_t write_op_phi_preallocated(instructions_buffer *instructions, spirv_id type, spirv_id result, spirv_id value1, spirv_id parent1, spirv_id value2,
+                                        spirv_id parent2) {
+	uint32_t operands[] = {type.id, result.id, value1.id, parent1.id, value2.id, parent2.id};
+	write_instruction(instructions, WORD_COUNT(operands), SPIRV_OPCODE_PHI, operands);
+	return instructions->offset - 2;
+}
+
 static void write_op_loop_merge(instructions_buffer *instructions, spirv_id merge_block, spirv_id continue_target, loop_control control) {
 	uint32_t operands[] = {merge_block.id, continue_target.id, (uint32_t)control};
 	write_instruction(instructions, WORD_COUNT(operands), SPIRV_OPCODE_LOOP_MERGE, operands);
@@ -1060,7 +1097,7 @@ typedef struct int_constant_container {
 	spirv_id         value;
 } int_constant_container;
 
-static struct hash_map *int_constants = NULL;
+static KONG_THREAD_LOCAL struct hash_map *int_constants = NULL;
 
 static spirv_id get_int_constant(int value) {
 	int_constant_container *container = (int_constant_container *)hash_map_get(int_constants, value);
@@ -1076,7 +1113,7 @@ static spirv_id get_int_constant(int value) {
 	return container->value;
 }
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	uint32_t key;
 	spirv_id value;
 } *uint_constants = NULL;
@@ -1090,7 +1127,7 @@ static spirv_id get_uint_constant(uint32_t value) {
 	return index;
 }
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	float    key;
 	spirv_id value;
 } *float_constants = NULL;
@@ -1104,7 +1141,7 @@ static spirv_id get_float_constant(float value) {
 	return index;
 }
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	bool     key;
 	spirv_id value;
 } *bool_constants = NULL;
@@ -1118,6 +1155,21 @@ static spirv_id get_bool_constant(bool value) {
 	return index;
 }
 
+static KONG_THREAD_LOCAL struct {
+	uint32_t key;
+	spirv_id value;
+} *undefined_values = NULL;
+
+// the value of a variable that is read before it is written, keyed by the spirv type
+static spirv_id get_undefined_value(spirv_id type) {
+	spirv_id index = hmget(undefined_values, type.id);
+	if (index.id == 0) {
+		index = allocate_index();
+		hmput(undefined_values, type.id, index);
+	}
+	return index;
+}
+
 static spirv_id write_op_access_chain(instructions_buffer *instructions, spirv_id result_type, spirv_id base, spirv_id *indices, uint16_t indices_size) {
 	spirv_id pointer = allocate_index();
 
@@ -1170,6 +1222,37 @@ static spirv_id write_op_composite_extract(instructions_buffer *instructions, sp
 	return result;
 }
 
+static spirv_id write_op_composite_insert(instructions_buffer *instructions, spirv_id type, spirv_id object, spirv_id composite, uint32_t *indices,
+                                          uint16_t indices_size) {
+	spirv_id result = allocate_index();
+
+	operands_buffer[0] = type.id;
+	operands_buffer[1] = result.id;
+	operands_buffer[2] = object.id;
+	operands_buffer[3] = composite.id;
+	for (uint16_t i = 0; i < indices_size; ++i) {
+		operands_buffer[i + 4] = indices[i];
+	}
+	write_instruction(instructions, 5 + indices_size, SPIRV_OPCODE_COMPOSITE_INSERT, operands_buffer);
+	return result;
+}
+
+// components below the size of vector1 pick from vector1, the ones above from vector2
+static spirv_id write_op_vector_shuffle(instructions_buffer *instructions, spirv_id type, spirv_id vector1, spirv_id vector2, uint32_t *components,
+                                        uint32_t components_size) {
+	spirv_id result = allocate_index();
+
+	operands_buffer[0] = type.id;
+	operands_buffer[1] = result.id;
+	operands_buffer[2] = vector1.id;
+	operands_buffer[3] = vector2.id;
+	for (uint32_t i = 0; i < components_size; ++i) {
+		operands_buffer[i + 4] = components[i];
+	}
+	write_instruction(instructions, 5 + components_size, SPIRV_OPCODE_VECTOR_SHUFFLE, operands_buffer);
+	return result;
+}
+
 static spirv_id write_op_f_ord_less_than(instructions_buffer *instructions, spirv_id type, spirv_id operand1, spirv_id operand2) {
 	spirv_id result = allocate_index();
 
@@ -1699,7 +1782,7 @@ static spirv_id write_op_dpdy(instructions_buffer *instructions, spirv_id type,
 	return result;
 }
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	uint64_t key;
 	spirv_id value;
 } *index_map = NULL;
@@ -1713,6 +1796,16 @@ static spirv_id convert_kong_index_to_spirv_id(uint64_t index) {
 	return id;
 }
 
+// indices of local and internal variables are only unique within a function, only the globals are kept for the next one
+static void forget_function_indices(void) {
+	uint64_t first_function_index = first_function_variable_index();
+	for (ptrdiff_t i = hmlen(index_map) - 1; i >= 0; --i) {
+		if (index_map[i].key >= first_function_index) {
+			(void)hmdel(index_map, index_map[i].key);
+		}
+	}
+}
+
 static bool is_global_const(uint64_t index) {
 	for (global_id i = 0; get_global(i) != NULL; ++i) {
 		global *g = get_global(i);
@@ -1723,35 +1816,341 @@ static bool is_global_const(uint64_t index) {
 	return false;
 }
 
+// Locals of scalar, vector and matrix types that are only ever accessed as a whole or through a single swizzle do not get a function
+// variable. Their current value is kept in index_map and merges of control flow get phis so drivers do not have to run mem2reg.
+typedef struct ssa_variable {
+	uint64_t index;
+	type_id  type;
+	size_t   declaration; // code offset, variables declared in a loop start over in every iteration
+	size_t   last_read;   // code offset, stretched to the end of every loop around the declaration the variable is read in
+} ssa_variable;
+
+static KONG_THREAD_LOCAL ssa_variable *ssa_variables = NULL;
+
+static KONG_THREAD_LOCAL struct {
+	uint64_t key;
+	uint32_t value;
+} *ssa_slots = NULL;
+
+typedef struct ssa_phi {
+	uint32_t slot;
+	size_t   back_edge_offset;
+} ssa_phi;
+
+static bool is_ssa_variable(uint64_t index) {
+	return hmgeti(ssa_slots, index) >= 0;
+}
+
+static bool is_ssa_type(type_id t) {
+	return is_matrix(t) || (is_vector_or_scalar(t) && (t == bool_id || vector_base_type(t) != bool_id));
+}
+
+static bool is_single_swizzle(access *access_list, uint16_t access_list_size) {
+	return access_list_size == 1 && access_list[0].kind == ACCESS_SWIZZLE;
+}
+
+static void add_ssa_variable(uint64_t index, type_id type, size_t declaration) {
+	ssa_variable v = {
+	    .index       = index,
+	    .type        = type,
+	    .declaration = declaration,
+	    .last_read   = 0,
+	};
+	hmput(ssa_slots, index, (uint32_t)arrlenu(ssa_variables));
+	arrput(ssa_variables, v);
+}
+
+static void reject_ssa_variable(bool *rejected, uint64_t index) {
+	ptrdiff_t slot = hmgeti(ssa_slots, index);
+	if (slot >= 0) {
+		rejected[ssa_slots[slot].value] = true;
+	}
+}
+
+static size_t find_while_end(uint8_t *data, size_t size, size_t while_start) {
+	uint32_t end_id = ((opcode *)&data[while_start])->op_while_start.end_id;
+
+	for (size_t index = while_start; index < size; index += ((opcode *)&data[index])->size) {
+		opcode *o = (opcode *)&data[index];
+		if (o->type == OPCODE_WHILE_END && o->op_while_end.end_id == end_id) {
+			return index;
+		}
+	}
+
+	assert(false);
+	return size;
+}
+
+// set by --spirv-ssa until the SSA values and phis have been through spirv-val, without it every local is an OpVariable
+static bool ssa_enabled = false;
+
+static void find_ssa_variables(function *f, uint64_t *parameter_ids, type_id *parameter_types, uint8_t parameters_size) {
+	hmfree(ssa_slots);
+	arrfree(ssa_variables);
+
+	if (!ssa_enabled) {
+		return;
+	}
+
+	uint8_t *data = f->code.o;
+	size_t   size = f->code.size;
+
+	for (uint8_t parameter_index = 0; parameter_index < parameters_size; ++parameter_index) {
+		if (is_ssa_type(parameter_types[parameter_index])) {
+			add_ssa_variable(parameter_ids[parameter_index], parameter_types[parameter_index], 0);
+		}
+	}
+
+	for (size_t index = 0; index < size; index += ((opcode *)&data[index])->size) {
+		opcode *o = (opcode *)&data[index];
+		if (o->type == OPCODE_VAR && is_ssa_type(o->op_var.var.type)) {
+			add_ssa_variable(o->op_var.var.index, o->op_var.var.type, index);
+		}
+	}
+
+	size_t count = arrlenu(ssa_variables);
+	if (count == 0) {
+		return;
+	}
+
+	// everything else needs a pointer
+	bool *rejected = (bool *)calloc(count, sizeof(bool));
+	assert(rejected != NULL);
+
+	for (size_t index = 0; index < size; index += ((opcode *)&data[index])->size) {
+		opcode *o = (opcode *)&data[index];
+		switch (o->type) {
+		case OPCODE_LOAD_ACCESS_LIST:
+			if (!is_single_swizzle(o->op_load_access_list.access_list, o->op_load_access_list.access_list_size)) {
+				reject_ssa_variable(rejected, o->op_load_access_list.from.index);
+			}
+			break;
+		case OPCODE_STORE_ACCESS_LIST:
+		case OPCODE_ADD_AND_STORE_ACCESS_LIST:
+		case OPCODE_SUB_AND_STORE_ACCESS_LIST:
+		case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
+		case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
+			if (!is_single_swizzle(o->op_store_access_list.access_list, o->op_store_access_list.access_list_size) ||
+			    (o->type != OPCODE_STORE_ACCESS_LIST && o->op_store_access_list.access_list[0].access_swizzle.swizzle.size > 1)) {
+				reject_ssa_variable(rejected, o->op_store_access_list.to.index);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	ssa_variable *candidates = ssa_variables;
+	ssa_variables            = NULL;
+	hmfree(ssa_slots);
+
+	for (size_t slot = 0; slot < count; ++slot) {
+		if (!rejected[slot]) {
+			add_ssa_variable(candidates[slot].index, candidates[slot].type, candidates[slot].declaration);
+		}
+	}
+
+	arrfree(candidates);
+	free(rejected);
+
+	count = arrlenu(ssa_variables);
+	if (count == 0) {
+		return;
+	}
+
+	size_t *first_reads = (size_t *)malloc(count * sizeof(size_t));
+	assert(first_reads != NULL);
+	for (size_t slot = 0; slot < count; ++slot) {
+		first_reads[slot] = SIZE_MAX;
+	}
+
+	for (size_t index = 0; index < size; index += ((opcode *)&data[index])->size) {
+		ir_operands operands;
+		ir_operands_of((opcode *)&data[index], &operands);
+
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			ptrdiff_t slot = hmgeti(ssa_slots, operands.uses[use_index]->index);
+			if (slot >= 0) {
+				uint32_t v = ssa_slots[slot].value;
+				if (first_reads[v] == SIZE_MAX) {
+					first_reads[v] = index;
+				}
+				ssa_variables[v].last_read = index;
+			}
+		}
+	}
+
+	// a variable that is read in a loop is needed again when the loop starts over
+	for (size_t index = 0; index < size; index += ((opcode *)&data[index])->size) {
+		if (((opcode *)&data[index])->type == OPCODE_WHILE_START) {
+			size_t end = find_while_end(data, size, index);
+			for (size_t slot = 0; slot < count; ++slot) {
+				if (ssa_variables[slot].declaration <= index && first_reads[slot] <= end && ssa_variables[slot].last_read >= index &&
+				    ssa_variables[slot].last_read < end) {
+					ssa_variables[slot].last_read = end;
+				}
+			}
+		}
+	}
+
+	free(first_reads);
+}
+
+static spirv_id get_ssa_value(size_t slot) {
+	return hmget(index_map, ssa_variables[slot].index);
+}
+
+static void set_ssa_value(size_t slot, spirv_id value) {
+	hmput(index_map, ssa_variables[slot].index, value);
+}
+
+static void push_ssa_values(spirv_id **values) {
+	for (size_t slot = 0; slot < arrlenu(ssa_variables); ++slot) {
+		arrput(*values, get_ssa_value(slot));
+	}
+}
+
+static void pop_ssa_values(spirv_id **values) {
+	size_t start = arrlenu(*values) - arrlenu(ssa_variables);
+	for (size_t slot = 0; slot < arrlenu(ssa_variables); ++slot) {
+		set_ssa_value(slot, (*values)[start + slot]);
+	}
+	arrsetlen(*values, start);
+}
+
+// joins the values from the end of the block of an if with the ones pushed before the if
+static void write_ssa_if_merge(instructions_buffer *instructions, spirv_id **values, spirv_id header_label, spirv_id block_label, bool block_reaches_merge,
+                               size_t merge) {
+	size_t start = arrlenu(*values) - arrlenu(ssa_variables);
+
+	for (size_t slot = 0; slot < arrlenu(ssa_variables); ++slot) {
+		spirv_id before = (*values)[start + slot];
+		spirv_id after  = get_ssa_value(slot);
+
+		if (!block_reaches_merge || ssa_variables[slot].last_read <= merge) {
+			set_ssa_value(slot, before);
+		}
+		else if (after.id != before.id) {
+			spirv_id phi = allocate_index();
+			write_op_phi_preallocated(instructions, convert_type_to_spirv_id(ssa_variables[slot].type), phi, after, block_label, before, header_label);
+			set_ssa_value(slot, phi);
+		}
+	}
+
+	arrsetlen(*values, start);
+}
+
+// variables that are written in the loop and read again get a phi in the loop header, the values coming in over the back edge are
+// filled in by patch_ssa_loop_phis when the end of the loop is reached
+static void write_ssa_loop_phis(instructions_buffer *instructions, uint8_t *data, size_t size, size_t while_start, spirv_id preheader_label,
+                                spirv_id continue_label, ssa_phi **phis) {
+	size_t count = arrlenu(ssa_variables);
+	if (count == 0) {
+		return;
+	}
+
+	bool *written = (bool *)calloc(count, sizeof(bool));
+	assert(written != NULL);
+
+	size_t end = find_while_end(data, size, while_start);
+	for (size_t index = while_start; index < end; index += ((opcode *)&data[index])->size) {
+		ir_operands operands;
+		ir_operands_of((opcode *)&data[index], &operands);
+
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+			ptrdiff_t slot = hmgeti(ssa_slots, operands.definitions[definition_index]->index);
+			if (slot >= 0) {
+				written[ssa_slots[slot].value] = true;
+			}
+		}
+	}
+
+	for (size_t slot = 0; slot < count; ++slot) {
+		if (written[slot] && ssa_variables[slot].declaration <= while_start && ssa_variables[slot].last_read > while_start) {
+			spirv_id type   = convert_type_to_spirv_id(ssa_variables[slot].type);
+			spirv_id phi    = allocate_index();
+			size_t   offset = write_op_phi_preallocated(instructions, type, phi, get_ssa_value(slot), preheader_label, phi, continue_label);
+			ssa_phi  p      = {.slot = (uint32_t)slot, .back_edge_offset = offset};
+			arrput(*phis, p);
+			set_ssa_value(slot, phi);
+		}
+	}
+
+	free(written);
+}
+
+static void patch_ssa_loop_phis(instructions_buffer *instructions, ssa_phi **phis, size_t phis_start) {
+	for (size_t phi_index = phis_start; phi_index < arrlenu(*phis); ++phi_index) {
+		instructions->instructions[(*phis)[phi_index].back_edge_offset] = get_ssa_value((*phis)[phi_index].slot).id;
+	}
+	arrsetlen(*phis, phis_start);
+}
+
+static spirv_id write_compound_assignment(instructions_buffer *instructions, opcode *o, type_id t, spirv_id to, spirv_id from) {
+	spirv_id result = {0};
+
+	switch (o->type) {
+	case OPCODE_ADD_AND_STORE_ACCESS_LIST:
+		if (vector_base_type(t) == float_id) {
+			result = write_op_f_add(instructions, convert_type_to_spirv_id(t), to, from);
+		}
+		else {
+			result = write_op_i_add(instructions, convert_type_to_spirv_id(t), to, from);
+		}
+		break;
+	case OPCODE_SUB_AND_STORE_ACCESS_LIST:
+		if (vector_base_type(t) == float_id) {
+			result = write_op_f_sub(instructions, convert_type_to_spirv_id(t), to, from);
+		}
+		else {
+			result = write_op_i_sub(instructions, convert_type_to_spirv_id(t), to, from);
+		}
+		break;
+	case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
+		result = write_op_f_mul(instructions, convert_type_to_spirv_id(t), to, from);
+		break;
+	case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
+		result = write_op_f_div(instructions, convert_type_to_spirv_id(t), to, from);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	return result;
+}
+
 static spirv_id get_var(instructions_buffer *instructions, variable param) {
 	spirv_id id = convert_kong_index_to_spirv_id(param.index);
-	if (param.kind != VARIABLE_INTERNAL && !is_global_const(param.index)) {
-		id = write_op_load(instructions, convert_type_to_spirv_id(param.type.type), id);
+	if (param.kind != VARIABLE_INTERNAL && !is_global_const(param.index) && !is_ssa_variable(param.index)) {
+		id = write_op_load(instructions, convert_type_to_spirv_id(param.type), id);
 	}
 	return id;
 }
 
-static struct {
+static KONG_THREAD_LOCAL struct {
 	name_id  key;
 	spirv_id value;
 } *function_map = NULL;
 
-static spirv_id per_vertex_var    = {0};
-static spirv_id output_vars[256]  = {0};
-static type_id  output_types[256] = {0};
-static size_t   output_vars_count = 0;
+static KONG_THREAD_LOCAL spirv_id per_vertex_var    = {0};
+static KONG_THREAD_LOCAL spirv_id output_vars[256]  = {0};
+static KONG_THREAD_LOCAL type_id  output_types[256] = {0};
+static KONG_THREAD_LOCAL size_t   output_vars_count = 0;
 
-static spirv_id input_vars[256]  = {0};
-static type_id  input_types[256] = {0};
-static size_t   input_vars_count = 0;
+static KONG_THREAD_LOCAL spirv_id input_vars[256]  = {0};
+static KONG_THREAD_LOCAL type_id  input_types[256] = {0};
+static KONG_THREAD_LOCAL size_t   input_vars_count = 0;
 
-static uint32_t vertex_parameter_indices[256];
-static uint32_t vertex_parameter_member_indices[256];
+static KONG_THREAD_LOCAL uint32_t vertex_parameter_indices[256];
+static KONG_THREAD_LOCAL uint32_t vertex_parameter_member_indices[256];
 
 static void write_function(instructions_buffer *instructions, function *f, spirv_id result_type, spirv_id fun_type, spirv_id fun_id, shader_stage stage,
                            bool main, type_id output) {
 	write_op_function_preallocated(instructions, result_type, FUNCTION_CONTROL_NONE, fun_type, fun_id);
 
+	forget_function_indices();
+
 	spirv_id parameter_value_ids[256] = {0};
 	if (!main) {
 		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
@@ -1762,7 +2161,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		}
 	}
 
-	write_op_label(instructions);
+	spirv_id current_label = write_op_label(instructions);
 
 	debug_context context = {0};
 	check(f->block != NULL, context, "Function block missing");
@@ -1786,6 +2185,8 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		check(parameter_ids[parameter_index] != 0, context, "Parameter not found");
 	}
 
+	find_ssa_variables(f, parameter_ids, parameter_types, main ? 0 : f->parameters_size);
+
 	// create variable for the input parameter
 	spirv_id spirv_parameter_ids[256] = {0};
 	uint32_t spirv_parameter_ids_size = 0;
@@ -1807,9 +2208,14 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 	}
 	else {
 		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
-			spirv_parameter_ids[spirv_parameter_ids_size] = convert_kong_index_to_spirv_id(parameter_ids[parameter_index]);
-			write_op_variable_preallocated(instructions, convert_pointer_type_to_spirv_id(parameter_types[parameter_index], STORAGE_CLASS_FUNCTION),
-			                               spirv_parameter_ids[spirv_parameter_ids_size], STORAGE_CLASS_FUNCTION);
+			if (is_ssa_variable(parameter_ids[parameter_index])) {
+				hmput(index_map, parameter_ids[parameter_index], parameter_value_ids[parameter_index]);
+			}
+			else {
+				spirv_parameter_ids[spirv_parameter_ids_size] = convert_kong_index_to_spirv_id(parameter_ids[parameter_index]);
+				write_op_variable_preallocated(instructions, convert_pointer_type_to_spirv_id(parameter_types[parameter_index], STORAGE_CLASS_FUNCTION),
+				                               spirv_parameter_ids[spirv_parameter_ids_size], STORAGE_CLASS_FUNCTION);
+			}
 			spirv_parameter_ids_size++;
 		}
 	}
@@ -1820,9 +2226,14 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		opcode *o = (opcode *)&data[index];
 		switch (o->type) {
 		case OPCODE_VAR: {
-			spirv_id result =
-			    write_op_variable(instructions, convert_pointer_type_to_spirv_id(o->op_var.var.type.type, STORAGE_CLASS_FUNCTION), STORAGE_CLASS_FUNCTION);
-			hmput(index_map, o->op_var.var.index, result);
+			if (is_ssa_variable(o->op_var.var.index)) {
+				hmput(index_map, o->op_var.var.index, get_undefined_value(convert_type_to_spirv_id(o->op_var.var.type)));
+			}
+			else {
+				spirv_id result =
+				    write_op_variable(instructions, convert_pointer_type_to_spirv_id(o->op_var.var.type, STORAGE_CLASS_FUNCTION), STORAGE_CLASS_FUNCTION);
+				hmput(index_map, o->op_var.var.index, result);
+			}
 			break;
 		}
 		default:
@@ -1855,15 +2266,23 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 	}
 	else {
 		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
-			write_op_store(instructions, spirv_parameter_ids[parameter_index], parameter_value_ids[parameter_index]);
+			if (!is_ssa_variable(parameter_ids[parameter_index])) {
+				write_op_store(instructions, spirv_parameter_ids[parameter_index], parameter_value_ids[parameter_index]);
+			}
 		}
 	}
 
 	bool     ends_with_return         = false;
 	uint64_t next_block_branch_id[16] = {0};
 	uint64_t next_block_label_id[16]  = {0};
+	spirv_id if_header_labels[16]     = {0};
 	uint8_t  nested_if_count          = 0;
 
+	spirv_id *if_values        = NULL; // stb_ds array, the ssa values from before every if that is open
+	spirv_id *loop_exit_values = NULL; // stb_ds array, the ssa values when the condition of every open loop was checked
+	ssa_phi  *loop_phis        = NULL; // stb_ds array
+	size_t   *loop_phis_starts = NULL; // stb_ds array
+
 	index = 0;
 	while (index < size) {
 		ends_with_return = false;
@@ -1875,7 +2294,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_LOAD_ACCESS_LIST: {
 			uint16_t indices_size = o->op_load_access_list.access_list_size;
 
-			if (get_type(o->op_load_access_list.from.type.type)->tex_kind == TEXTURE_KIND_2D) {
+			if (get_type(o->op_load_access_list.from.type)->tex_kind == TEXTURE_KIND_2D) {
 				assert(indices_size == 1);
 				assert(o->op_load_access_list.access_list[0].kind == ACCESS_ELEMENT);
 
@@ -1888,12 +2307,16 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 				hmput(index_map, o->op_load_access_list.to.index, value);
 			}
-			else if (o->op_load_access_list.from.kind == VARIABLE_INTERNAL) {
+			else if (o->op_load_access_list.from.kind == VARIABLE_INTERNAL || is_ssa_variable(o->op_load_access_list.from.index)) {
 				uint32_t indices[256];
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
-				for (uint16_t i = 0; i < indices_size; ++i) {
+				access  *last    = &o->op_load_access_list.access_list[indices_size - 1];
+				bool     shuffle = last->kind == ACCESS_SWIZZLE && last->access_swizzle.swizzle.size > 1;
+				uint16_t extract = shuffle ? indices_size - 1 : indices_size;
+
+				for (uint16_t i = 0; i < extract; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
 						assert(false);
@@ -1927,8 +2350,21 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 					s = get_type(o->op_load_access_list.access_list[i].type);
 				}
 
-				spirv_id value = write_op_composite_extract(instructions, convert_type_to_spirv_id(o->op_load_access_list.to.type.type),
-				                                            convert_kong_index_to_spirv_id(o->op_load_access_list.from.index), indices, indices_size);
+				spirv_id value;
+
+				if (shuffle) {
+					value = convert_kong_index_to_spirv_id(o->op_load_access_list.from.index);
+					if (extract > 0) {
+						value = write_op_composite_extract(instructions, convert_type_to_spirv_id(o->op_load_access_list.access_list[extract - 1].type), value,
+						                                   indices, extract);
+					}
+					value = write_op_vector_shuffle(instructions, convert_type_to_spirv_id(o->op_load_access_list.to.type), value, value,
+					                                last->access_swizzle.swizzle.indices, last->access_swizzle.swizzle.size);
+				}
+				else {
+					value = write_op_composite_extract(instructions, convert_type_to_spirv_id(o->op_load_access_list.to.type),
+					                                   convert_kong_index_to_spirv_id(o->op_load_access_list.from.index), indices, indices_size);
+				}
 
 				hmput(index_map, o->op_load_access_list.to.index, value);
 			}
@@ -1937,9 +2373,13 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				int         plain_indices[256];
 				access_kind access_kinds[256];
 
-				type *s = get_type(o->op_load_access_list.from.type.type);
+				type *s = get_type(o->op_load_access_list.from.type);
 
-				for (uint16_t i = 0; i < indices_size; ++i) {
+				access  *last    = &o->op_load_access_list.access_list[indices_size - 1];
+				bool     shuffle = last->kind == ACCESS_SWIZZLE && last->access_swizzle.swizzle.size > 1;
+				uint16_t chain   = shuffle ? indices_size - 1 : indices_size;
+
+				for (uint16_t i = 0; i < chain; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
 						access_kinds[i]  = ACCESS_SWIZZLE;
@@ -1979,40 +2419,54 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 					s = get_type(o->op_load_access_list.access_list[i].type);
 				}
 
-				type_id access_kong_type = find_access_type(plain_indices, access_kinds, indices_size, o->op_load_access_list.from.type.type);
-				assert(access_kong_type != NO_TYPE);
+				spirv_id value;
 
-				spirv_id access_type = {0};
+				if (chain > 0 || !shuffle) {
+					type_id access_kong_type = shuffle ? o->op_load_access_list.access_list[chain - 1].type
+					                                   : find_access_type(plain_indices, access_kinds, chain, o->op_load_access_list.from.type);
+					assert(access_kong_type != NO_TYPE);
 
-				switch (o->op_load_access_list.from.kind) {
-				case VARIABLE_LOCAL:
-					access_type = convert_pointer_type_to_spirv_id(access_kong_type, STORAGE_CLASS_FUNCTION);
-					break;
-				case VARIABLE_GLOBAL: {
-					bool root_constant = false;
+					spirv_id access_type = {0};
+
+					switch (o->op_load_access_list.from.kind) {
+					case VARIABLE_LOCAL:
+						access_type = convert_pointer_type_to_spirv_id(access_kong_type, STORAGE_CLASS_FUNCTION);
+						break;
+					case VARIABLE_GLOBAL: {
+						bool root_constant = false;
 
-					for (global_id global_index = 0; get_global(global_index) != NULL && get_global(global_index)->type != NO_TYPE; ++global_index) {
-						global *g = get_global(global_index);
+						for (global_id global_index = 0; get_global(global_index) != NULL && get_global(global_index)->type != NO_TYPE; ++global_index) {
+							global *g = get_global(global_index);
 
-						if (o->op_load_access_list.from.index == g->var_index) {
-							root_constant = find_attribute(&g->attributes, add_name("root_constants")) != NULL;
-							break;
+							if (o->op_load_access_list.from.index == g->var_index) {
+								root_constant = find_attribute(&g->attributes, add_name("root_constants")) != NULL;
+								break;
+							}
 						}
+
+						access_type = convert_pointer_type_to_spirv_id(access_kong_type, root_constant ? STORAGE_CLASS_PUSH_CONSTANT : STORAGE_CLASS_UNIFORM);
+
+						break;
+					}
+					case VARIABLE_INTERNAL:
+						access_type = convert_pointer_type_to_spirv_id(access_kong_type, STORAGE_CLASS_INPUT);
+						break;
 					}
 
-					access_type = convert_pointer_type_to_spirv_id(access_kong_type, root_constant ? STORAGE_CLASS_PUSH_CONSTANT : STORAGE_CLASS_UNIFORM);
+					spirv_id pointer =
+					    write_op_access_chain(instructions, access_type, convert_kong_index_to_spirv_id(o->op_load_access_list.from.index), indices, chain);
 
-					break;
+					value = write_op_load(instructions, convert_type_to_spirv_id(shuffle ? access_kong_type : o->op_load_access_list.to.type), pointer);
 				}
-				case VARIABLE_INTERNAL:
-					access_type = convert_pointer_type_to_spirv_id(access_kong_type, STORAGE_CLASS_INPUT);
-					break;
+				else {
+					value = get_var(instructions, o->op_load_access_list.from);
 				}
 
-				spirv_id pointer =
-				    write_op_access_chain(instructions, access_type, convert_kong_index_to_spirv_id(o->op_load_access_list.from.index), indices, indices_size);
+				if (shuffle) {
+					value = write_op_vector_shuffle(instructions, convert_type_to_spirv_id(o->op_load_access_list.to.type), value, value,
+					                                last->access_swizzle.swizzle.indices, last->access_swizzle.swizzle.size);
+				}
 
-				spirv_id value = write_op_load(instructions, convert_type_to_spirv_id(o->op_load_access_list.to.type.type), pointer);
 				hmput(index_map, o->op_load_access_list.to.index, value);
 			}
 			break;
@@ -2043,16 +2497,16 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				spirv_id image_type;
 				spirv_id sampled_image_type;
 
-				if (get_type(image_var.type.type)->tex_kind != TEXTURE_KIND_NONE) {
-					if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_2D) {
+				if (get_type(image_var.type)->tex_kind != TEXTURE_KIND_NONE) {
+					if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_2D) {
 						image_type         = spirv_image_type;
 						sampled_image_type = spirv_sampled_image_type;
 					}
-					else if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
+					else if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
 						image_type         = spirv_image2darray_type;
 						sampled_image_type = spirv_sampled_image2darray_type;
 					}
-					else if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_CUBE) {
+					else if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_CUBE) {
 						image_type         = spirv_imagecube_type;
 						sampled_image_type = spirv_sampled_imagecube_type;
 					}
@@ -2069,7 +2523,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 				spirv_id id = write_op_image_sample_implicit_lod(instructions, spirv_float4_type, sampled_image, coordinate);
 
-				if (is_depth(get_type(image_var.type.type)->tex_format)) {
+				if (is_depth(get_type(image_var.type)->tex_format)) {
 					uint32_t index = 0;
 
 					id = write_op_composite_extract(instructions, spirv_float_type, id, &index, 1);
@@ -2083,16 +2537,16 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				spirv_id image_type;
 				spirv_id sampled_image_type;
 
-				if (get_type(image_var.type.type)->tex_kind != TEXTURE_KIND_NONE) {
-					if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_2D) {
+				if (get_type(image_var.type)->tex_kind != TEXTURE_KIND_NONE) {
+					if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_2D) {
 						image_type         = spirv_image_type;
 						sampled_image_type = spirv_sampled_image_type;
 					}
-					else if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
+					else if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
 						image_type         = spirv_image2darray_type;
 						sampled_image_type = spirv_sampled_image2darray_type;
 					}
-					else if (get_type(image_var.type.type)->tex_kind == TEXTURE_KIND_CUBE) {
+					else if (get_type(image_var.type)->tex_kind == TEXTURE_KIND_CUBE) {
 						image_type         = spirv_imagecube_type;
 						sampled_image_type = spirv_sampled_imagecube_type;
 					}
@@ -2112,11 +2566,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				hmput(index_map, o->op_call.var.index, id);
 			}
 			else if (func == add_name("float")) {
-				if (o->op_call.parameters[0].type.type == int_id) {
+				if (o->op_call.parameters[0].type == int_id) {
 					spirv_id id = write_op_convert_s_to_f(instructions, spirv_float_type, get_var(instructions, o->op_call.parameters[0]));
 					hmput(index_map, o->op_call.var.index, id);
 				}
-				else if (o->op_call.parameters[0].type.type == uint_id) {
+				else if (o->op_call.parameters[0].type == uint_id) {
 					spirv_id id = write_op_convert_u_to_f(instructions, spirv_float_type, get_var(instructions, o->op_call.parameters[0]));
 					hmput(index_map, o->op_call.var.index, id);
 				}
@@ -2127,11 +2581,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			else if (func == add_name("float2")) {
 				if (o->op_call.parameters_size == 1) {
 					variable parameter = o->op_call.parameters[0];
-					if (parameter.type.type == int2_id) {
+					if (parameter.type == int2_id) {
 						spirv_id id = write_op_convert_s_to_f(instructions, spirv_float2_type, convert_kong_index_to_spirv_id(parameter.index));
 						hmput(index_map, o->op_call.var.index, id);
 					}
-					else if (parameter.type.type == uint2_id) {
+					else if (parameter.type == uint2_id) {
 						spirv_id id = write_op_convert_u_to_f(instructions, spirv_float2_type, convert_kong_index_to_spirv_id(parameter.index));
 						hmput(index_map, o->op_call.var.index, id);
 					}
@@ -2184,7 +2638,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				hmput(index_map, o->op_call.var.index, id);
 			}
 			else if (func == add_name("int")) {
-				if (o->op_call.parameters[0].type.type == float_id) {
+				if (o->op_call.parameters[0].type == float_id) {
 					spirv_id id = write_op_convert_f_to_s(instructions, spirv_int_type, get_var(instructions, o->op_call.parameters[0]));
 					hmput(index_map, o->op_call.var.index, id);
 				}
@@ -2195,11 +2649,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			else if (func == add_name("int2")) {
 				if (o->op_call.parameters_size == 1) {
 					spirv_id constituent = convert_kong_index_to_spirv_id(o->op_call.parameters[0].index);
-					if (o->op_call.parameters[0].type.type == uint2_id) {
+					if (o->op_call.parameters[0].type == uint2_id) {
 						spirv_id id = write_op_bitcast(instructions, spirv_int2_type, constituent);
 						hmput(index_map, o->op_call.var.index, id);
 					}
-					else if (o->op_call.parameters[0].type.type == float2_id) {
+					else if (o->op_call.parameters[0].type == float2_id) {
 						spirv_id id = write_op_convert_f_to_s(instructions, spirv_int2_type, constituent);
 						hmput(index_map, o->op_call.var.index, id);
 					}
@@ -2234,11 +2688,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				hmput(index_map, o->op_call.var.index, id);
 			}
 			else if (func == add_name("uint")) {
-				if (o->op_call.parameters[0].type.type == float_id) {
+				if (o->op_call.parameters[0].type == float_id) {
 					spirv_id id = write_op_convert_f_to_u(instructions, spirv_uint_type, get_var(instructions, o->op_call.parameters[0]));
 					hmput(index_map, o->op_call.var.index, id);
 				}
-				else if (o->op_call.parameters[0].type.type == int_id) {
+				else if (o->op_call.parameters[0].type == int_id) {
 					spirv_id id = write_op_bitcast(instructions, spirv_uint_type, get_var(instructions, o->op_call.parameters[0]));
 					hmput(index_map, o->op_call.var.index, id);
 				}
@@ -2475,9 +2929,9 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 			uint16_t indices_size = o->op_store_access_list.access_list_size;
 
-			type *s = get_type(o->op_store_access_list.to.type.type);
+			type *s = get_type(o->op_store_access_list.to.type);
 
-			if (get_type(o->op_store_access_list.to.type.type)->tex_kind == TEXTURE_KIND_2D) {
+			if (get_type(o->op_store_access_list.to.type)->tex_kind == TEXTURE_KIND_2D) {
 				assert(indices_size == 1);
 				assert(o->op_store_access_list.access_list[0].kind == ACCESS_ELEMENT);
 
@@ -2489,8 +2943,46 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 				write_op_image_write(instructions, image, coordinate, texel);
 			}
+			else if (is_ssa_variable(o->op_store_access_list.to.index)) {
+				// writing a part of a vector that is kept in an ssa value makes a new vector
+				type_id   vector_type = o->op_store_access_list.to.type;
+				swizzle  *written     = &o->op_store_access_list.access_list[0].access_swizzle.swizzle;
+				spirv_id  old         = convert_kong_index_to_spirv_id(o->op_store_access_list.to.index);
+				spirv_id  from        = get_var(instructions, o->op_store_access_list.from);
+				spirv_id  result;
+
+				if (written->size > 1) {
+					uint32_t components[4];
+					uint32_t components_size = vector_size(vector_type);
+					for (uint32_t component = 0; component < components_size; ++component) {
+						components[component] = component;
+					}
+					for (uint32_t swizzle_index = 0; swizzle_index < written->size; ++swizzle_index) {
+						components[written->indices[swizzle_index]] = components_size + swizzle_index;
+					}
+
+					result = write_op_vector_shuffle(instructions, convert_type_to_spirv_id(vector_type), old, from, components, components_size);
+				}
+				else {
+					if (o->type != OPCODE_STORE_ACCESS_LIST) {
+						type_id  component_type = o->op_store_access_list.access_list[0].type;
+						spirv_id component = write_op_composite_extract(instructions, convert_type_to_spirv_id(component_type), old, &written->indices[0], 1);
+						from               = write_compound_assignment(instructions, o, component_type, component, from);
+					}
+
+					result = write_op_composite_insert(instructions, convert_type_to_spirv_id(vector_type), from, old, &written->indices[0], 1);
+				}
+
+				hmput(index_map, o->op_store_access_list.to.index, result);
+			}
 			else {
-				for (uint16_t i = 0; i < indices_size; ++i) {
+				// a store through a swizzle of several components writes a shuffle of the old and the new vector
+				access  *last    = &o->op_store_access_list.access_list[indices_size - 1];
+				bool     shuffle = last->kind == ACCESS_SWIZZLE && last->access_swizzle.swizzle.size > 1;
+				uint16_t chain   = shuffle ? indices_size - 1 : indices_size;
+				assert(!shuffle || o->type == OPCODE_STORE_ACCESS_LIST);
+
+				for (uint16_t i = 0; i < chain; ++i) {
 					switch (o->op_store_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
 						access_kinds[i]  = ACCESS_ELEMENT;
@@ -2534,7 +3026,13 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 					s = get_type(o->op_store_access_list.access_list[i].type);
 				}
 
-				type_id access_kong_type = find_access_type(plain_indices, access_kinds, indices_size, o->op_store_access_list.to.type.type);
+				type_id access_kong_type = o->op_store_access_list.to.type;
+				if (!shuffle) {
+					access_kong_type = find_access_type(plain_indices, access_kinds, indices_size, o->op_store_access_list.to.type);
+				}
+				else if (chain > 0) {
+					access_kong_type = o->op_store_access_list.access_list[chain - 1].type;
+				}
 				assert(access_kong_type != NO_TYPE);
 
 				spirv_id access_type = {0};
@@ -2551,12 +3049,29 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 					break;
 				}
 
-				spirv_id pointer =
-				    write_op_access_chain(instructions, access_type, convert_kong_index_to_spirv_id(o->op_store_access_list.to.index), indices, indices_size);
+				spirv_id pointer = convert_kong_index_to_spirv_id(o->op_store_access_list.to.index);
+				if (chain > 0) {
+					pointer = write_op_access_chain(instructions, access_type, pointer, indices, chain);
+				}
 
 				spirv_id result;
 
-				if (o->type == OPCODE_STORE_ACCESS_LIST) {
+				if (shuffle) {
+					uint32_t components[4];
+					uint32_t components_size = vector_size(access_kong_type);
+					for (uint32_t component = 0; component < components_size; ++component) {
+						components[component] = component;
+					}
+					for (uint32_t swizzle_index = 0; swizzle_index < last->access_swizzle.swizzle.size; ++swizzle_index) {
+						components[last->access_swizzle.swizzle.indices[swizzle_index]] = components_size + swizzle_index;
+					}
+
+					spirv_id loaded = write_op_load(instructions, convert_type_to_spirv_id(access_kong_type), pointer);
+					spirv_id from   = get_var(instructions, o->op_store_access_list.from);
+
+					result = write_op_vector_shuffle(instructions, convert_type_to_spirv_id(access_kong_type), loaded, from, components, components_size);
+				}
+				else if (o->type == OPCODE_STORE_ACCESS_LIST) {
 					result = get_var(instructions, o->op_store_access_list.from);
 				}
 				else {
@@ -2606,35 +3121,35 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_BITWISE_XOR: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_bitwise_xor(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_bitwise_xor(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			hmput(index_map, o->op_binary.result.index, result);
 			break;
 		}
 		case OPCODE_BITWISE_AND: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_bitwise_and(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_bitwise_and(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			hmput(index_map, o->op_binary.result.index, result);
 			break;
 		}
 		case OPCODE_BITWISE_OR: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_bitwise_or(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_bitwise_or(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			hmput(index_map, o->op_binary.result.index, result);
 			break;
 		}
 		case OPCODE_LEFT_SHIFT: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_left_shift(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_left_shift(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			hmput(index_map, o->op_binary.result.index, result);
 			break;
 		}
 		case OPCODE_RIGHT_SHIFT: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_right_shift(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_right_shift(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			hmput(index_map, o->op_binary.result.index, result);
 			break;
 		}
@@ -2647,12 +3162,12 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_NEGATE: {
 			spirv_id from = get_var(instructions, o->op_negate.from);
 
-			if (vector_base_type(o->op_negate.from.type.type) == float_id) {
-				spirv_id result = write_op_f_negate(instructions, convert_type_to_spirv_id(o->op_negate.to.type.type), from);
+			if (vector_base_type(o->op_negate.from.type) == float_id) {
+				spirv_id result = write_op_f_negate(instructions, convert_type_to_spirv_id(o->op_negate.to.type), from);
 				hmput(index_map, o->op_negate.to.index, result);
 			}
-			else if (vector_base_type(o->op_negate.from.type.type) == int_id || vector_base_type(o->op_negate.from.type.type) == uint_id) {
-				spirv_id result = write_op_s_negate(instructions, convert_type_to_spirv_id(o->op_negate.to.type.type), from);
+			else if (vector_base_type(o->op_negate.from.type) == int_id || vector_base_type(o->op_negate.from.type) == uint_id) {
+				spirv_id result = write_op_s_negate(instructions, convert_type_to_spirv_id(o->op_negate.to.type), from);
 				hmput(index_map, o->op_negate.to.index, result);
 			}
 
@@ -2660,7 +3175,12 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		}
 		case OPCODE_STORE_VARIABLE: {
 			spirv_id from = get_var(instructions, o->op_store_var.from);
-			write_op_store(instructions, convert_kong_index_to_spirv_id(o->op_store_var.to.index), from);
+			if (is_ssa_variable(o->op_store_var.to.index)) {
+				hmput(index_map, o->op_store_var.to.index, from);
+			}
+			else {
+				write_op_store(instructions, convert_kong_index_to_spirv_id(o->op_store_var.to.index), from);
+			}
 			break;
 		}
 		case OPCODE_ADD_AND_STORE_VARIABLE:
@@ -2673,29 +3193,29 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 			switch (o->type) {
 			case OPCODE_ADD_AND_STORE_VARIABLE: {
-				if (vector_base_type(o->op_store_var.to.type.type) == float_id) {
-					result = write_op_f_add(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				if (vector_base_type(o->op_store_var.to.type) == float_id) {
+					result = write_op_f_add(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				}
-				else if (vector_base_type(o->op_store_var.to.type.type) == int_id || vector_base_type(o->op_store_var.to.type.type) == uint_id) {
-					result = write_op_i_add(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				else if (vector_base_type(o->op_store_var.to.type) == int_id || vector_base_type(o->op_store_var.to.type) == uint_id) {
+					result = write_op_i_add(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				}
 				break;
 			}
 			case OPCODE_SUB_AND_STORE_VARIABLE: {
-				if (vector_base_type(o->op_store_var.to.type.type) == float_id) {
-					result = write_op_f_sub(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				if (vector_base_type(o->op_store_var.to.type) == float_id) {
+					result = write_op_f_sub(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				}
-				else if (vector_base_type(o->op_store_var.to.type.type) == int_id || vector_base_type(o->op_store_var.to.type.type) == uint_id) {
-					result = write_op_i_sub(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				else if (vector_base_type(o->op_store_var.to.type) == int_id || vector_base_type(o->op_store_var.to.type) == uint_id) {
+					result = write_op_i_sub(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				}
 				break;
 			}
 			case OPCODE_MULTIPLY_AND_STORE_VARIABLE: {
-				result = write_op_f_mul(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				result = write_op_f_mul(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				break;
 			}
 			case OPCODE_DIVIDE_AND_STORE_VARIABLE: {
-				result = write_op_f_div(instructions, convert_type_to_spirv_id(o->op_store_var.to.type.type), to, from);
+				result = write_op_f_div(instructions, convert_type_to_spirv_id(o->op_store_var.to.type), to, from);
 				break;
 			}
 			default:
@@ -2703,7 +3223,12 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 				break;
 			}
 
-			write_op_store(instructions, convert_kong_index_to_spirv_id(o->op_store_var.to.index), result);
+			if (is_ssa_variable(o->op_store_var.to.index)) {
+				hmput(index_map, o->op_store_var.to.index, result);
+			}
+			else {
+				write_op_store(instructions, convert_kong_index_to_spirv_id(o->op_store_var.to.index), result);
+			}
 
 			break;
 		}
@@ -2781,20 +3306,20 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			break;
 		}
 		case OPCODE_LESS: {
-			assert(o->op_binary.left.type.type == o->op_binary.right.type.type);
+			assert(o->op_binary.left.type == o->op_binary.right.type);
 
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
 			spirv_id result;
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				result = write_op_f_ord_less_than(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id) {
 				result = write_op_s_less_than(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == uint_id) {
 				result = write_op_u_less_than(instructions, spirv_bool_type, left, right);
 			}
 			else {
@@ -2806,20 +3331,20 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			break;
 		}
 		case OPCODE_LESS_EQUAL: {
-			assert(o->op_binary.left.type.type == o->op_binary.right.type.type);
+			assert(o->op_binary.left.type == o->op_binary.right.type);
 
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
 			spirv_id result;
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				result = write_op_f_ord_less_than_equal(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id) {
 				result = write_op_s_less_than_equal(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == uint_id) {
 				result = write_op_u_less_than_equal(instructions, spirv_bool_type, left, right);
 			}
 			else {
@@ -2831,20 +3356,20 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			break;
 		}
 		case OPCODE_GREATER: {
-			assert(o->op_binary.left.type.type == o->op_binary.right.type.type);
+			assert(o->op_binary.left.type == o->op_binary.right.type);
 
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
 			spirv_id result;
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				result = write_op_f_ord_greater_than(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id) {
 				result = write_op_s_greater_than(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == uint_id) {
 				result = write_op_u_greater_than(instructions, spirv_bool_type, left, right);
 			}
 			else {
@@ -2856,20 +3381,20 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			break;
 		}
 		case OPCODE_GREATER_EQUAL: {
-			assert(o->op_binary.left.type.type == o->op_binary.right.type.type);
+			assert(o->op_binary.left.type == o->op_binary.right.type);
 
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
 			spirv_id result;
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				result = write_op_f_ord_greater_than_equal(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id) {
 				result = write_op_s_greater_than_equal(instructions, spirv_bool_type, left, right);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == uint_id) {
 				result = write_op_u_greater_than_equal(instructions, spirv_bool_type, left, right);
 			}
 			else {
@@ -2884,12 +3409,12 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
-			if (vector_base_type(o->op_binary.result.type.type) == float_id) {
-				spirv_id result = write_op_f_add(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			if (vector_base_type(o->op_binary.result.type) == float_id) {
+				spirv_id result = write_op_f_add(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
-			else if (vector_base_type(o->op_binary.result.type.type) == int_id || vector_base_type(o->op_binary.result.type.type) == uint_id) {
-				spirv_id result = write_op_i_add(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			else if (vector_base_type(o->op_binary.result.type) == int_id || vector_base_type(o->op_binary.result.type) == uint_id) {
+				spirv_id result = write_op_i_add(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
 			else {
@@ -2901,7 +3426,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_SUB: {
 			spirv_id left        = get_var(instructions, o->op_binary.left);
 			spirv_id right       = get_var(instructions, o->op_binary.right);
-			type_id  result_type = o->op_binary.result.type.type;
+			type_id  result_type = o->op_binary.result.type;
 
 			if (result_type == int_id || result_type == int2_id || result_type == int3_id || result_type == int4_id || result_type == uint_id ||
 			    result_type == uint2_id || result_type == uint3_id || result_type == uint4_id) {
@@ -2918,21 +3443,21 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_MULTIPLY: {
 			spirv_id left            = get_var(instructions, o->op_binary.left);
 			spirv_id right           = get_var(instructions, o->op_binary.right);
-			bool     left_is_matrix  = is_matrix(o->op_binary.left.type.type);
-			bool     right_is_matrix = is_matrix(o->op_binary.right.type.type);
+			bool     left_is_matrix  = is_matrix(o->op_binary.left.type);
+			bool     right_is_matrix = is_matrix(o->op_binary.right.type);
 			spirv_id result;
 
 			if (left_is_matrix && right_is_matrix) {
-				result = write_op_matrix_times_matrix(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+				result = write_op_matrix_times_matrix(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			}
 			else if (left_is_matrix) {
-				result = write_op_matrix_times_vector(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+				result = write_op_matrix_times_vector(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			}
 			else if (right_is_matrix) {
-				result = write_op_vector_times_matrix(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+				result = write_op_vector_times_matrix(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			}
 			else {
-				result = write_op_f_mul(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+				result = write_op_f_mul(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 			}
 
 			hmput(index_map, o->op_binary.result.index, result);
@@ -2942,7 +3467,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_DIVIDE: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_f_div(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_f_div(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 
 			hmput(index_map, o->op_binary.result.index, result);
 
@@ -2951,7 +3476,7 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		case OPCODE_MOD: {
 			spirv_id left   = get_var(instructions, o->op_binary.left);
 			spirv_id right  = get_var(instructions, o->op_binary.right);
-			spirv_id result = write_op_f_mod(instructions, convert_type_to_spirv_id(o->op_binary.result.type.type), left, right);
+			spirv_id result = write_op_f_mod(instructions, convert_type_to_spirv_id(o->op_binary.result.type), left, right);
 
 			hmput(index_map, o->op_binary.result.index, result);
 
@@ -2961,11 +3486,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				spirv_id result = write_op_f_ord_equal(instructions, spirv_bool_type, left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id || vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id || vector_base_type(o->op_binary.left.type) == uint_id) {
 				spirv_id result = write_op_i_equal(instructions, spirv_bool_type, left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
@@ -2976,11 +3501,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			spirv_id left  = get_var(instructions, o->op_binary.left);
 			spirv_id right = get_var(instructions, o->op_binary.right);
 
-			if (vector_base_type(o->op_binary.left.type.type) == float_id) {
+			if (vector_base_type(o->op_binary.left.type) == float_id) {
 				spirv_id result = write_op_f_ord_not_equal(instructions, spirv_bool_type, left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
-			else if (vector_base_type(o->op_binary.left.type.type) == int_id || vector_base_type(o->op_binary.left.type.type) == uint_id) {
+			else if (vector_base_type(o->op_binary.left.type) == int_id || vector_base_type(o->op_binary.left.type) == uint_id) {
 				spirv_id result = write_op_i_not_equal(instructions, spirv_bool_type, left, right);
 				hmput(index_map, o->op_binary.result.index, result);
 			}
@@ -2991,12 +3516,16 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			nested_if_count++;
 			next_block_branch_id[nested_if_count] = o->op_if.end_id;
 			next_block_label_id[nested_if_count]  = o->op_if.end_id;
+			if_header_labels[nested_if_count]     = current_label;
+			push_ssa_values(&if_values);
+
 			write_op_selection_merge(instructions, convert_kong_index_to_spirv_id(o->op_if.end_id), SELECTION_CONTROL_NONE);
 
 			write_op_branch_conditional(instructions, convert_kong_index_to_spirv_id(o->op_if.condition.index),
 			                            convert_kong_index_to_spirv_id(o->op_if.start_id), convert_kong_index_to_spirv_id(o->op_if.end_id));
 
-			write_op_label_preallocated(instructions, convert_kong_index_to_spirv_id(o->op_if.start_id));
+			current_label = convert_kong_index_to_spirv_id(o->op_if.start_id);
+			write_op_label_preallocated(instructions, current_label);
 
 			break;
 		}
@@ -3005,14 +3534,20 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			spirv_id while_continue_label = convert_kong_index_to_spirv_id(o->op_while_start.continue_id);
 			spirv_id while_end_label      = convert_kong_index_to_spirv_id(o->op_while_start.end_id);
 
+			spirv_id preheader_label = current_label;
+
 			write_op_branch(instructions, while_start_label);
 			write_op_label_preallocated(instructions, while_start_label);
 
+			arrput(loop_phis_starts, arrlenu(loop_phis));
+			write_ssa_loop_phis(instructions, data, size, index, preheader_label, while_continue_label, &loop_phis);
+
 			write_op_loop_merge(instructions, while_end_label, while_continue_label, LOOP_CONTROL_NONE);
 
 			spirv_id loop_start_id = allocate_index();
 			write_op_branch(instructions, loop_start_id);
 			write_op_label_preallocated(instructions, loop_start_id);
+			current_label = loop_start_id;
 			break;
 		}
 		case OPCODE_WHILE_CONDITION: {
@@ -3020,9 +3555,12 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 
 			spirv_id pass = allocate_index();
 
+			push_ssa_values(&loop_exit_values);
+
 			write_op_branch_conditional(instructions, convert_kong_index_to_spirv_id(o->op_while.condition.index), pass, while_end_label);
 
 			write_op_label_preallocated(instructions, pass);
+			current_label = pass;
 			break;
 		}
 		case OPCODE_WHILE_END: {
@@ -3033,19 +3571,31 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 			write_op_branch(instructions, while_continue_label);
 			write_op_label_preallocated(instructions, while_continue_label);
 
+			patch_ssa_loop_phis(instructions, &loop_phis, arrpop(loop_phis_starts));
+
 			write_op_branch(instructions, while_start_label);
 			write_op_label_preallocated(instructions, while_end_label);
+			current_label = while_end_label;
+
+			pop_ssa_values(&loop_exit_values);
 			break;
 		}
 		case OPCODE_BLOCK_START: {
 			break;
 		}
 		case OPCODE_BLOCK_END: {
-			if (o->op_block.id == next_block_branch_id[nested_if_count]) {
+			bool     reaches_merge = o->op_block.id == next_block_branch_id[nested_if_count];
+			spirv_id block_label   = current_label;
+
+			if (reaches_merge) {
 				write_op_branch(instructions, convert_kong_index_to_spirv_id(o->op_block.id));
 			}
 			if (o->op_block.id == next_block_label_id[nested_if_count]) {
-				write_op_label_preallocated(instructions, convert_kong_index_to_spirv_id(o->op_block.id));
+				current_label = convert_kong_index_to_spirv_id(o->op_block.id);
+				write_op_label_preallocated(instructions, current_label);
+
+				write_ssa_if_merge(instructions, &if_values, if_header_labels[nested_if_count], block_label, reaches_merge, index);
+
 				nested_if_count--;
 			}
 			break;
@@ -3067,6 +3617,11 @@ static void write_function(instructions_buffer *instructions, function *f, spirv
 		write_op_return(instructions);
 	}
 	write_op_function_end(instructions);
+
+	arrfree(if_values);
+	arrfree(loop_exit_values);
+	arrfree(loop_phis);
+	arrfree(loop_phis_starts);
 }
 
 static void write_functions(instructions_buffer *instructions, function *main, spirv_id entry_point, shader_stage stage, type_id output) {
@@ -3166,6 +3721,12 @@ static void write_constants(instructions_buffer *instructions) {
 	for (size_t i = 0; i < size; ++i) {
 		write_constant_bool(instructions, bool_constants[i].value, bool_constants[i].key);
 	}
+
+	size = hmlenu(undefined_values);
+	for (size_t i = 0; i < size; ++i) {
+		spirv_id type = {.id = undefined_values[i].key};
+		write_undefined_value(instructions, type, undefined_values[i].value);
+	}
 }
 
 static void assign_bindings(uint32_t *bindings, function *shader) {
@@ -3500,43 +4061,61 @@ static void write_globals(instructions_buffer *decorations, instructions_buffer
 
 static void init_index_map(void) {
 	spirv_id default_id = {0};
+	hmfree(index_map);
 	hmdefault(index_map, default_id);
-	size_t size = hmlenu(index_map);
-	for (size_t i = 0; i < size; ++i) {
-		hmdel(index_map, index_map[i].key);
-	}
 }
 
 static void init_type_map(void) {
 	spirv_id default_id = {0};
+	hmfree(type_map);
 	hmdefault(type_map, default_id);
-	size_t size = hmlenu(type_map);
-	for (size_t i = 0; i < size; ++i) {
-		hmdel(type_map, type_map[i].key);
-	}
 }
 
 static void init_function_map(void) {
 	spirv_id default_id = {0};
+	hmfree(function_map);
 	hmdefault(function_map, default_id);
-	size_t size = hmlenu(function_map);
-	for (size_t i = 0; i < size; ++i) {
-		hmdel(function_map, function_map[i].key);
+}
+
+static void free_int_constant(struct container *container, void *data) {
+	free(container);
+}
+
+static void free_int_constants(void) {
+	if (int_constants != NULL) {
+		hash_map_iterate(int_constants, free_int_constant, NULL);
+		hash_map_destroy(int_constants);
+		int_constants = NULL;
 	}
 }
 
 static void init_int_constants(void) {
-	hash_map_destroy(int_constants);
+	free_int_constants();
 	int_constants = hash_map_create();
 }
 
+static void init_uint_constants(void) {
+	spirv_id default_id = {0};
+	hmfree(uint_constants);
+	hmdefault(uint_constants, default_id);
+}
+
 static void init_float_constants(void) {
 	spirv_id default_id = {0};
+	hmfree(float_constants);
 	hmdefault(float_constants, default_id);
-	size_t size = hmlenu(float_constants);
-	for (size_t i = 0; i < size; ++i) {
-		hmdel(float_constants, float_constants[i].key);
-	}
+}
+
+static void init_bool_constants(void) {
+	spirv_id default_id = {0};
+	hmfree(bool_constants);
+	hmdefault(bool_constants, default_id);
+}
+
+static void init_undefined_values(void) {
+	spirv_id default_id = {0};
+	hmfree(undefined_values);
+	hmdefault(undefined_values, default_id);
 }
 
 void init_maps(void) {
@@ -3544,7 +4123,24 @@ void init_maps(void) {
 	init_type_map();
 	init_function_map();
 	init_int_constants();
+	init_uint_constants();
 	init_float_constants();
+	init_bool_constants();
+	init_undefined_values();
+}
+
+// the maps are thread local, so they are freed after every job instead of being left to the worker threads
+static void free_maps(void) {
+	hmfree(index_map);
+	hmfree(type_map);
+	hmfree(function_map);
+	free_int_constants();
+	hmfree(uint_constants);
+	hmfree(float_constants);
+	hmfree(bool_constants);
+	hmfree(undefined_values);
+	hmfree(ssa_slots);
+	arrfree(ssa_variables);
 }
 
 static void spirv_export_vertex(char *directory, function *main, bool debug) {
@@ -3554,33 +4150,13 @@ static void spirv_export_vertex(char *directory, function *main, bool debug) {
 	find_used_builtins(main);
 	find_used_capabilities(main);
 
-	instructions_buffer header = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer decorations = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer base_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer constants = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer aggregate_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer global_vars = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer instructions = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
+	instructions_buffer header          = {0};
+	instructions_buffer decorations     = {0};
+	instructions_buffer base_types      = {0};
+	instructions_buffer constants       = {0};
+	instructions_buffer aggregate_types = {0};
+	instructions_buffer global_vars     = {0};
+	instructions_buffer instructions    = {0};
 
 	assert(main->parameters_size > 0);
 	type_id vertex_output = main->return_type.type;
@@ -3718,6 +4294,14 @@ static void spirv_export_vertex(char *directory, function *main, bool debug) {
 	sprintf(var_name, "%s_code", name);
 
 	write_bytecode(directory, filename, var_name, &header, &decorations, &base_types, &constants, &aggregate_types, &global_vars, &instructions, debug);
+
+	instructions_buffer_free(&header);
+	instructions_buffer_free(&decorations);
+	instructions_buffer_free(&base_types);
+	instructions_buffer_free(&constants);
+	instructions_buffer_free(&aggregate_types);
+	instructions_buffer_free(&global_vars);
+	instructions_buffer_free(&instructions);
 }
 
 static void spirv_export_fragment(char *directory, function *main, bool debug) {
@@ -3727,33 +4311,13 @@ static void spirv_export_fragment(char *directory, function *main, bool debug) {
 	find_used_builtins(main);
 	find_used_capabilities(main);
 
-	instructions_buffer header = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer decorations = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer base_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer constants = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer aggregate_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer global_vars = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer instructions = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
+	instructions_buffer header          = {0};
+	instructions_buffer decorations     = {0};
+	instructions_buffer base_types      = {0};
+	instructions_buffer constants       = {0};
+	instructions_buffer aggregate_types = {0};
+	instructions_buffer global_vars     = {0};
+	instructions_buffer instructions    = {0};
 
 	assert(main->parameters_size > 0);
 	type_id pixel_input  = main->parameter_types[0].type;
@@ -3863,6 +4427,14 @@ static void spirv_export_fragment(char *directory, function *main, bool debug) {
 	sprintf(var_name, "%s_code", name);
 
 	write_bytecode(directory, filename, var_name, &header, &decorations, &base_types, &constants, &aggregate_types, &global_vars, &instructions, debug);
+
+	instructions_buffer_free(&header);
+	instructions_buffer_free(&decorations);
+	instructions_buffer_free(&base_types);
+	instructions_buffer_free(&constants);
+	instructions_buffer_free(&aggregate_types);
+	instructions_buffer_free(&global_vars);
+	instructions_buffer_free(&instructions);
 }
 
 static void spirv_export_compute(char *directory, function *main, bool debug) {
@@ -3872,33 +4444,13 @@ static void spirv_export_compute(char *directory, function *main, bool debug) {
 	find_used_builtins(main);
 	find_used_capabilities(main);
 
-	instructions_buffer header = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer decorations = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer base_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer constants = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer aggregate_types = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer global_vars = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
-
-	instructions_buffer instructions = {
-	    .instructions = (uint32_t *)calloc(1024 * 1024, 1),
-	};
+	instructions_buffer header          = {0};
+	instructions_buffer decorations     = {0};
+	instructions_buffer base_types      = {0};
+	instructions_buffer constants       = {0};
+	instructions_buffer aggregate_types = {0};
+	instructions_buffer global_vars     = {0};
+	instructions_buffer instructions    = {0};
 
 	assert(main->parameters_size == 0);
 
@@ -3981,9 +4533,59 @@ static void spirv_export_compute(char *directory, function *main, bool debug) {
 	sprintf(var_name, "%s_code", name);
 
 	write_bytecode(directory, filename, var_name, &header, &decorations, &base_types, &constants, &aggregate_types, &global_vars, &instructions, debug);
+
+	instructions_buffer_free(&header);
+	instructions_buffer_free(&decorations);
+	instructions_buffer_free(&base_types);
+	instructions_buffer_free(&constants);
+	instructions_buffer_free(&aggregate_types);
+	instructions_buffer_free(&global_vars);
+	instructions_buffer_free(&instructions);
+}
+
+typedef struct spirv_export_job {
+	char        *directory;
+	function    *main;
+	shader_stage stage;
+	bool         debug;
+} spirv_export_job;
+
+static void spirv_export_job_run(void *data, size_t index) {
+	spirv_export_job *job = &((spirv_export_job *)data)[index];
+
+	input_vars_count = 0;
+
+	switch (job->stage) {
+	case SHADER_STAGE_VERTEX:
+		spirv_export_vertex(job->directory, job->main, job->debug);
+		break;
+	case SHADER_STAGE_FRAGMENT:
+		spirv_export_fragment(job->directory, job->main, job->debug);
+		break;
+	case SHADER_STAGE_COMPUTE:
+		spirv_export_compute(job->directory, job->main, job->debug);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	free_maps();
 }
 
-void spirv_export(char *directory, bool debug) {
+static void add_export_job(spirv_export_job *jobs, size_t *jobs_size, spirv_export_job job) {
+	char filename[512];
+	sprintf(filename, "kong_%s", get_name(job.main->name));
+
+	if (!cache_check(filename, job.main, job.stage)) {
+		jobs[*jobs_size] = job;
+		*jobs_size += 1;
+	}
+}
+
+void spirv_export(char *directory, bool debug, bool ssa) {
+	ssa_enabled = ssa;
+
 	function *vertex_shaders[256];
 	size_t    vertex_shaders_size = 0;
 
@@ -4034,18 +4636,29 @@ void spirv_export(char *directory, bool debug) {
 		}
 	}
 
+	spirv_export_job jobs[256 * 3];
+	size_t           jobs_size = 0;
+
 	for (size_t i = 0; i < vertex_shaders_size; ++i) {
-		input_vars_count = 0;
-		spirv_export_vertex(directory, vertex_shaders[i], debug);
+		spirv_export_job job = {.directory = directory, .main = vertex_shaders[i], .stage = SHADER_STAGE_VERTEX, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	for (size_t i = 0; i < fragment_shaders_size; ++i) {
-		input_vars_count = 0;
-		spirv_export_fragment(directory, fragment_shaders[i], debug);
+		spirv_export_job job = {.directory = directory, .main = fragment_shaders[i], .stage = SHADER_STAGE_FRAGMENT, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
 
 	for (size_t i = 0; i < compute_shaders_size; ++i) {
-		input_vars_count = 0;
-		spirv_export_compute(directory, compute_shaders[i], debug);
+		spirv_export_job job = {.directory = directory, .main = compute_shaders[i], .stage = SHADER_STAGE_COMPUTE, .debug = debug};
+		add_export_job(jobs, &jobs_size, job);
 	}
+
+	// the analyzer caches its results in the functions so it has to run before the jobs are started
+	for (size_t i = 0; i < jobs_size; ++i) {
+		find_used_builtins(jobs[i].main);
+		find_used_capabilities(jobs[i].main);
+	}
+
+	jobs_run(spirv_export_job_run, jobs, jobs_size);
 }
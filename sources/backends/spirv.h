@@ -3,6 +3,6 @@
 
 #include "stdbool.h"
 
-void spirv_export(char *directory, bool debug);
+void spirv_export(char *directory, bool debug, bool ssa);
 
 #endif
@@ -479,7 +479,7 @@ static small_string get_var(variable var, function *f, function *main) {
 				global *g = get_global(set->globals.globals[global_index]);
 				if (g != NULL && var.index == g->var_index) {
 					small_string name;
-					sprintf(name.str, "_set%zu_%" PRIu64, set_index, var.index);
+					sprintf(name.str, "_set%zu_%" PRIu32, set_index, var.index);
 					return name;
 				}
 			}
@@ -487,7 +487,7 @@ static small_string get_var(variable var, function *f, function *main) {
 	}
 
 	small_string name;
-	sprintf(name.str, "_%" PRIu64, var.index);
+	sprintf(name.str, "_%" PRIu32, var.index);
 	return name;
 }
 
@@ -612,27 +612,27 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 			switch (o->type) {
 			case OPCODE_VAR:
 				indent(code, offset, indentation);
-				if (get_type(o->op_var.var.type.type)->array_size > 0) {
-					type_id base_type = get_type(o->op_var.var.type.type)->base;
+				if (get_type(o->op_var.var.type)->array_size > 0) {
+					type_id base_type = get_type(o->op_var.var.type)->base;
 
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": array<%s, %i>;\n", o->op_var.var.index, type_string(base_type),
-					                   get_type(o->op_var.var.type.type)->array_size);
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": array<%s, %i>;\n", o->op_var.var.index, type_string(base_type),
+					                   get_type(o->op_var.var.type)->array_size);
 				}
 				else {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s;\n", o->op_var.var.index, type_string(o->op_var.var.type.type));
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s;\n", o->op_var.var.index, type_string(o->op_var.var.type));
 				}
 				break;
 			case OPCODE_LOAD_ACCESS_LIST: {
 				indent(code, offset, indentation);
 
-				type_id from_type = o->op_load_access_list.from.type.type;
+				type_id from_type = o->op_load_access_list.from.type;
 
 				if (is_texture(from_type)) {
 					assert(o->op_load_access_list.access_list_size == 1);
 					assert(o->op_load_access_list.access_list[0].kind == ACCESS_ELEMENT);
 
 					*offset +=
-					    sprintf(&code[*offset], "var %s: %s = ", get_var(o->op_load_access_list.to, f, main).str, type_string(o->op_load_access_list.to.type.type));
+					    sprintf(&code[*offset], "var %s: %s = ", get_var(o->op_load_access_list.to, f, main).str, type_string(o->op_load_access_list.to.type));
 
 					*offset += sprintf(&code[*offset], "textureLoad(%s, vec2<u32>(u32(%s.x), u32(%s.y)), 0);\n", get_var(o->op_load_access_list.from, f, main).str,
 					                   get_var(o->op_load_access_list.access_list[0].access_element.index, f, main).str,
@@ -640,14 +640,14 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 				}
 				else {
 					*offset += sprintf(&code[*offset], "var %s: %s = %s", get_var(o->op_load_access_list.to, f, main).str,
-					                   type_string(o->op_load_access_list.to.type.type), get_var(o->op_load_access_list.from, f, main).str);
+					                   type_string(o->op_load_access_list.to.type), get_var(o->op_load_access_list.from, f, main).str);
 
-					type *s = get_type(o->op_load_access_list.from.type.type);
+					type *s = get_type(o->op_load_access_list.from.type);
 
 					for (size_t i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 						switch (o->op_load_access_list.access_list[i].kind) {
 						case ACCESS_ELEMENT:
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_load_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_load_access_list.access_list[i].access_element.index.index);
 							break;
 						case ACCESS_MEMBER:
 							*offset += sprintf(&code[*offset], ".%s", get_name(o->op_load_access_list.access_list[i].access_member.name));
@@ -681,14 +681,14 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 			case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST: {
 				indent(code, offset, indentation);
 
-				type_id to_type = o->op_store_access_list.to.type.type;
+				type_id to_type = o->op_store_access_list.to.type;
 
 				if (is_texture(to_type)) {
 					assert(o->type == OPCODE_STORE_ACCESS_LIST);
 					assert(o->op_store_access_list.access_list_size == 1);
 					assert(o->op_store_access_list.access_list[0].kind == ACCESS_ELEMENT);
 
-					*offset += sprintf(&code[*offset], "textureStore(%s, vec2<u32>(u32(_%" PRIu64 ".x), u32(_%" PRIu64 ".y)), _%" PRIu64 ");\n",
+					*offset += sprintf(&code[*offset], "textureStore(%s, vec2<u32>(u32(_%" PRIu32 ".x), u32(_%" PRIu32 ".y)), _%" PRIu32 ");\n",
 					                   get_var(o->op_store_access_list.to, f, main).str, o->op_store_access_list.access_list[0].access_element.index.index,
 					                   o->op_store_access_list.access_list[0].access_element.index.index, o->op_store_access_list.from.index);
 				}
@@ -700,7 +700,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 					for (size_t i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 						switch (o->op_store_access_list.access_list[i].kind) {
 						case ACCESS_ELEMENT:
-							*offset += sprintf(&code[*offset], "[_%" PRIu64 "]", o->op_store_access_list.access_list[i].access_element.index.index);
+							*offset += sprintf(&code[*offset], "[_%" PRIu32 "]", o->op_store_access_list.access_list[i].access_element.index.index);
 							break;
 						case ACCESS_MEMBER:
 							*offset += sprintf(&code[*offset], ".%s", get_name(o->op_store_access_list.access_list[i].access_member.name));
@@ -755,7 +755,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 						*offset += sprintf(&code[*offset], "var _kong_colors: _kong_colors_out;\n");
 						for (uint32_t j = 0; j < get_type(f->return_type.type)->array_size; ++j) {
 							indent(code, offset, indentation + 1);
-							*offset += sprintf(&code[*offset], "_kong_colors._%i = _%" PRIu64 "[%i];\n", j, o->op_return.var.index, j);
+							*offset += sprintf(&code[*offset], "_kong_colors._%i = _%" PRIu32 "[%i];\n", j, o->op_return.var.index, j);
 						}
 						indent(code, offset, indentation + 1);
 						*offset += sprintf(&code[*offset], "return _kong_colors;\n");
@@ -764,7 +764,7 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 					}
 					else {
 						indent(code, offset, indentation);
-						*offset += sprintf(&code[*offset], "return _%" PRIu64 ";\n", o->op_return.var.index);
+						*offset += sprintf(&code[*offset], "return _%" PRIu32 ";\n", o->op_return.var.index);
 					}
 				}
 				else {
@@ -780,126 +780,126 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 			}
 			case OPCODE_MULTIPLY: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " * _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " * _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_DIVIDE: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " / _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " / _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_ADD: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " + _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " + _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_SUB: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " - _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " - _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_MOD: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " %% _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " %% _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_EQUALS: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " == _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " == _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_NOT_EQUALS: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " != _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " != _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_GREATER: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " > _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " > _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_GREATER_EQUAL: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " >= _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " >= _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LESS: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " < _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " < _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LESS_EQUAL: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " <= _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " <= _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_AND: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " && _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " && _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_OR: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " || _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " || _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_BITWISE_XOR: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " ^ _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " ^ _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_BITWISE_AND: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " & _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " & _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_BITWISE_OR: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " | _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " | _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LEFT_SHIFT: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " << _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " << _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_RIGHT_SHIFT: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _%" PRIu64 " >> _%" PRIu64 ";\n", o->op_binary.result.index,
-				                   type_string(o->op_binary.result.type.type), o->op_binary.left.index, o->op_binary.right.index);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _%" PRIu32 " >> _%" PRIu32 ";\n", o->op_binary.result.index,
+				                   type_string(o->op_binary.result.type), o->op_binary.left.index, o->op_binary.right.index);
 				break;
 			}
 			case OPCODE_LOAD_FLOAT_CONSTANT:
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = %f;\n", o->op_load_float_constant.to.index,
-				                   type_string(o->op_load_float_constant.to.type.type), o->op_load_float_constant.number);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = %f;\n", o->op_load_float_constant.to.index,
+				                   type_string(o->op_load_float_constant.to.type), o->op_load_float_constant.number);
 				break;
 			case OPCODE_LOAD_INT_CONSTANT:
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = %i;\n", o->op_load_int_constant.to.index,
-				                   type_string(o->op_load_int_constant.to.type.type), o->op_load_int_constant.number);
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = %i;\n", o->op_load_int_constant.to.index,
+				                   type_string(o->op_load_int_constant.to.type), o->op_load_int_constant.number);
 				break;
 			case OPCODE_LOAD_BOOL_CONSTANT:
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = %s;\n", o->op_load_bool_constant.to.index,
-				                   type_string(o->op_load_bool_constant.to.type.type), o->op_load_bool_constant.boolean ? "true" : "false");
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = %s;\n", o->op_load_bool_constant.to.index,
+				                   type_string(o->op_load_bool_constant.to.type), o->op_load_bool_constant.boolean ? "true" : "false");
 				break;
 			case OPCODE_CALL: {
 				debug_context context = {0};
@@ -911,14 +911,14 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 					variable sampler = o->op_call.parameters[1];
 					variable coord   = o->op_call.parameters[2];
 
-					if (get_type(tex.type.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
+					if (get_type(tex.type)->tex_kind == TEXTURE_KIND_2D_ARRAY) {
 						*offset += sprintf(&code[*offset], "var %s: %s = textureSample(%s, %s, %s.xy, u32(%s.z));\n", get_var(o->op_call.var, f, main).str,
-						                   type_string(o->op_call.var.type.type), get_var(tex, f, main).str, get_var(sampler, f, main).str, get_var(coord, f, main).str,
+						                   type_string(o->op_call.var.type), get_var(tex, f, main).str, get_var(sampler, f, main).str, get_var(coord, f, main).str,
 						                   get_var(coord, f, main).str);
 					}
 					else {
 						*offset += sprintf(&code[*offset], "var %s: %s = textureSample(%s, %s, %s);\n", get_var(o->op_call.var, f, main).str,
-						                   type_string(o->op_call.var.type.type), get_var(tex, f, main).str, get_var(sampler, f, main).str, get_var(coord, f, main).str);
+						                   type_string(o->op_call.var.type), get_var(tex, f, main).str, get_var(sampler, f, main).str, get_var(coord, f, main).str);
 					}
 				}
 				else if (o->op_call.func == add_name("sample_lod")) {
@@ -926,54 +926,54 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 					indent(code, offset, indentation);
 					*offset +=
 					    sprintf(&code[*offset], "var %s: %s = textureSampleLevel(%s, %s, %s, %s);\n", get_var(o->op_call.var, f, main).str,
-					            type_string(o->op_call.var.type.type), get_var(o->op_call.parameters[0], f, main).str, get_var(o->op_call.parameters[1], f, main).str,
+					            type_string(o->op_call.var.type), get_var(o->op_call.parameters[0], f, main).str, get_var(o->op_call.parameters[1], f, main).str,
 					            get_var(o->op_call.parameters[2], f, main).str, get_var(o->op_call.parameters[3], f, main).str);
 				}
 				else if (o->op_call.func == add_name("group_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_id can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _kong_group_id;\n", o->op_call.var.index, type_string(o->op_call.var.type.type));
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _kong_group_id;\n", o->op_call.var.index, type_string(o->op_call.var.type));
 				}
 				else if (o->op_call.func == add_name("group_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "group_thread_id can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "var _%" PRIu64 ": %s = _kong_group_thread_id;\n", o->op_call.var.index, type_string(o->op_call.var.type.type));
+					    sprintf(&code[*offset], "var _%" PRIu32 ": %s = _kong_group_thread_id;\n", o->op_call.var.index, type_string(o->op_call.var.type));
 				}
 				else if (o->op_call.func == add_name("dispatch_thread_id")) {
 					check(o->op_call.parameters_size == 0, context, "dispatch_thread_id can not have a parameter");
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = _kong_dispatch_thread_id;\n", o->op_call.var.index,
-					                   type_string(o->op_call.var.type.type));
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = _kong_dispatch_thread_id;\n", o->op_call.var.index,
+					                   type_string(o->op_call.var.type));
 				}
 				else if (o->op_call.func == add_name("group_index")) {
 					check(o->op_call.parameters_size == 0, context, "group_index can not have a parameter");
 					indent(code, offset, indentation);
 					*offset +=
-					    sprintf(&code[*offset], "var _%" PRIu64 ": %s = _kong_group_index;\n", o->op_call.var.index, type_string(o->op_call.var.type.type));
+					    sprintf(&code[*offset], "var _%" PRIu32 ": %s = _kong_group_index;\n", o->op_call.var.index, type_string(o->op_call.var.type));
 				}
 				else if (o->op_call.func == add_name("vertex_id")) {
 					check(o->op_call.parameters_size == 0, context, "vertex_id can not have a parameter");
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = i32(_kong_vertex_id);\n", o->op_call.var.index, type_string(o->op_call.var.type.type));
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = i32(_kong_vertex_id);\n", o->op_call.var.index, type_string(o->op_call.var.type));
 				}
 				else if (o->op_call.func == add_name("lerp")) {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = mix(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n", o->op_call.var.index, type_string(o->op_call.var.type.type),
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = mix(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n", o->op_call.var.index, type_string(o->op_call.var.type),
 					                   o->op_call.parameters[0].index, o->op_call.parameters[1].index, o->op_call.parameters[2].index);
 				}
 				else if (o->op_call.func == add_name("ddx")) {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = dpdx(_%" PRIu64 ");\n", o->op_call.var.index, type_string(o->op_call.var.type.type),
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = dpdx(_%" PRIu32 ");\n", o->op_call.var.index, type_string(o->op_call.var.type),
 					                   o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("ddy")) {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = dpdy(_%" PRIu64 ");\n", o->op_call.var.index, type_string(o->op_call.var.type.type),
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = dpdy(_%" PRIu32 ");\n", o->op_call.var.index, type_string(o->op_call.var.type),
 					                   o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("rsqrt")) {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = inverseSqrt(_%" PRIu64 ");\n", o->op_call.var.index, type_string(o->op_call.var.type.type),
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = inverseSqrt(_%" PRIu32 ");\n", o->op_call.var.index, type_string(o->op_call.var.type),
 					                   o->op_call.parameters[0].index);
 				}
 				else if (o->op_call.func == add_name("float3x3")) {
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = mat3x3<f32>(_%" PRIu64 ", _%" PRIu64 ", _%" PRIu64 ");\n", o->op_call.var.index, type_string(o->op_call.var.type.type),
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = mat3x3<f32>(_%" PRIu32 ", _%" PRIu32 ", _%" PRIu32 ");\n", o->op_call.var.index, type_string(o->op_call.var.type),
 					                   o->op_call.parameters[0].index, o->op_call.parameters[1].index, o->op_call.parameters[2].index);
 				}
 				else {
@@ -1017,11 +1017,11 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 					}
 
 					indent(code, offset, indentation);
-					*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = %s(", o->op_call.var.index, type_string(o->op_call.var.type.type), func_name);
+					*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = %s(", o->op_call.var.index, type_string(o->op_call.var.type), func_name);
 					if (o->op_call.parameters_size > 0) {
-						*offset += sprintf(&code[*offset], "_%" PRIu64, o->op_call.parameters[0].index);
+						*offset += sprintf(&code[*offset], "_%" PRIu32, o->op_call.parameters[0].index);
 						for (uint8_t i = 1; i < o->op_call.parameters_size; ++i) {
-							*offset += sprintf(&code[*offset], ", _%" PRIu64, o->op_call.parameters[i].index);
+							*offset += sprintf(&code[*offset], ", _%" PRIu32, o->op_call.parameters[i].index);
 						}
 					}
 					*offset += sprintf(&code[*offset], ");\n");
@@ -1030,13 +1030,13 @@ static void write_functions(char *code, size_t *offset, shader_stage stage, func
 			}
 			case OPCODE_NEGATE: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = -_%" PRIu64 ";\n", o->op_negate.to.index, type_string(o->op_negate.to.type.type),
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = -_%" PRIu32 ";\n", o->op_negate.to.index, type_string(o->op_negate.to.type),
 				                   o->op_negate.from.index);
 				break;
 			}
 			case OPCODE_NOT: {
 				indent(code, offset, indentation);
-				*offset += sprintf(&code[*offset], "var _%" PRIu64 ": %s = !_%" PRIu64 ";\n", o->op_not.to.index, type_string(o->op_not.to.type.type),
+				*offset += sprintf(&code[*offset], "var _%" PRIu32 ": %s = !_%" PRIu32 ";\n", o->op_not.to.index, type_string(o->op_not.to.type),
 				                   o->op_not.from.index);
 				break;
 			}
@@ -1141,6 +1141,12 @@ static void wgsl_export_compute(char *directory, function *main) {
 }
 
 void wgsl_export(char *directory) {
+	vertex_inputs_size      = 0;
+	fragment_inputs_size    = 0;
+	vertex_functions_size   = 0;
+	fragment_functions_size = 0;
+	compute_functions_size  = 0;
+
 	for (type_id i = 0; get_type(i) != NULL; ++i) {
 		type *t = get_type(i);
 		if (!t->built_in && has_attribute(&t->attributes, add_name("pipe"))) {
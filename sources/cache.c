@@ -0,0 +1,459 @@
+#include "cache.h"
+
+#include "analyzer.h"
+#include "compiler.h"
+#include "errors.h"
+#include "globals.h"
+#include "log.h"
+#include "names.h"
+#include "sets.h"
+#include "types.h"
+
+#include "libs/stb_ds.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+// The key of an entry point hashes everything the backends look at when writing it. Variable, block and loop
+// ids are renumbered in order of appearance and names are hashed as strings so that edits in unrelated
+// functions, which shift the global id counters, do not invalidate the entry.
+
+static bool     enabled = false;
+static char    *cache_directory;
+static uint64_t salt;
+
+static struct {
+	char    *key;
+	uint64_t value;
+} *stored_keys = NULL;
+
+static struct {
+	char    *key;
+	uint64_t value;
+} *current_keys = NULL;
+
+typedef struct hasher {
+	uint64_t value;
+
+	struct {
+		uint64_t key;
+		uint64_t value;
+	} *ids;
+	uint64_t next_id;
+} hasher;
+
+static void hash_bytes(hasher *h, const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < size; ++i) {
+		h->value ^= bytes[i];
+		h->value *= 0x100000001b3ull;
+	}
+}
+
+static void hash_u64(hasher *h, uint64_t value) {
+	hash_bytes(h, &value, sizeof(value));
+}
+
+static void hash_string(hasher *h, const char *string) {
+	hash_bytes(h, string, strlen(string) + 1);
+}
+
+static void hash_name(hasher *h, name_id name) {
+	hash_string(h, get_name(name));
+}
+
+static void hash_id(hasher *h, uint64_t id) {
+	ptrdiff_t index = hmgeti(h->ids, id);
+	if (index < 0) {
+		hmput(h->ids, id, h->next_id);
+		hash_u64(h, h->next_id);
+		h->next_id += 1;
+	}
+	else {
+		hash_u64(h, h->ids[index].value);
+	}
+}
+
+static void hash_type_name(hasher *h, type_id t) {
+	if (t == NO_TYPE) {
+		hash_u64(h, NO_TYPE);
+		return;
+	}
+
+	type *ty = get_type(t);
+	hash_name(h, ty->name);
+	hash_u64(h, ty->array_size);
+}
+
+static void hash_attributes(hasher *h, attribute_list *attributes) {
+	hash_u64(h, attributes->attributes_count);
+	for (uint8_t i = 0; i < attributes->attributes_count; ++i) {
+		attribute *a = &attributes->attributes[i];
+		hash_name(h, a->name);
+		hash_u64(h, a->paramters_count);
+		hash_bytes(h, a->parameters, a->paramters_count * sizeof(double));
+	}
+}
+
+static void hash_type(hasher *h, type_id t, int depth) {
+	hash_type_name(h, t);
+
+	if (t == NO_TYPE || depth > 16) {
+		return;
+	}
+
+	type *ty = get_type(t);
+	hash_u64(h, ty->built_in);
+	hash_u64(h, ty->tex_kind);
+	hash_u64(h, ty->tex_format);
+	hash_attributes(h, &ty->attributes);
+
+	hash_type(h, ty->base, depth + 1);
+
+	hash_u64(h, ty->members.size);
+	for (size_t i = 0; i < ty->members.size; ++i) {
+		member *m = &ty->members.m[i];
+		hash_name(h, m->name);
+		hash_type(h, m->type.type, depth + 1);
+		if (m->value.kind == TOKEN_IDENTIFIER) {
+			hash_name(h, m->value.identifier);
+		}
+	}
+}
+
+static void hash_global(hasher *h, global *g) {
+	hash_name(h, g->name);
+	hash_type(h, g->type, 0);
+	hash_u64(h, g->value.kind);
+	hash_bytes(h, &g->value.value.floats, sizeof(g->value.value.floats));
+	hash_attributes(h, &g->attributes);
+	hash_u64(h, g->usage);
+	hash_u64(h, g->sets_count);
+	for (size_t i = 0; i < g->sets_count; ++i) {
+		hash_name(h, g->sets[i]->name);
+		hash_u64(h, g->sets[i]->index);
+	}
+}
+
+static void hash_variable(hasher *h, variable v) {
+	hash_u64(h, v.kind);
+
+	if (v.kind == VARIABLE_GLOBAL) {
+		for (global_id i = 0; get_global(i) != NULL; ++i) {
+			global *g = get_global(i);
+			if (g->var_index == v.index) {
+				hash_name(h, g->name);
+				break;
+			}
+		}
+	}
+	else {
+		hash_id(h, v.index);
+	}
+
+	hash_type_name(h, v.type);
+}
+
+static void hash_access_list(hasher *h, access *access_list, uint8_t access_list_size) {
+	hash_u64(h, access_list_size);
+	for (uint8_t i = 0; i < access_list_size; ++i) {
+		access *a = &access_list[i];
+		hash_u64(h, a->kind);
+		hash_type_name(h, a->type);
+		switch (a->kind) {
+		case ACCESS_MEMBER:
+			hash_name(h, a->access_member.name);
+			break;
+		case ACCESS_ELEMENT:
+			hash_variable(h, a->access_element.index);
+			break;
+		case ACCESS_SWIZZLE:
+			hash_u64(h, a->access_swizzle.swizzle.size);
+			hash_bytes(h, a->access_swizzle.swizzle.indices, a->access_swizzle.swizzle.size * sizeof(uint32_t));
+			break;
+		}
+	}
+}
+
+static void hash_opcode(hasher *h, opcode *o) {
+	hash_u64(h, o->type);
+
+	switch (o->type) {
+	case OPCODE_VAR:
+		hash_variable(h, o->op_var.var);
+		break;
+	case OPCODE_NOT:
+	case OPCODE_NEGATE:
+	case OPCODE_STORE_VARIABLE:
+	case OPCODE_SUB_AND_STORE_VARIABLE:
+	case OPCODE_ADD_AND_STORE_VARIABLE:
+	case OPCODE_DIVIDE_AND_STORE_VARIABLE:
+	case OPCODE_MULTIPLY_AND_STORE_VARIABLE:
+		hash_variable(h, o->op_store_var.from);
+		hash_variable(h, o->op_store_var.to);
+		break;
+	case OPCODE_STORE_ACCESS_LIST:
+	case OPCODE_SUB_AND_STORE_ACCESS_LIST:
+	case OPCODE_ADD_AND_STORE_ACCESS_LIST:
+	case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
+	case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
+		hash_variable(h, o->op_store_access_list.from);
+		hash_variable(h, o->op_store_access_list.to);
+		hash_access_list(h, o->op_store_access_list.access_list, o->op_store_access_list.access_list_size);
+		break;
+	case OPCODE_LOAD_ACCESS_LIST:
+		hash_variable(h, o->op_load_access_list.from);
+		hash_variable(h, o->op_load_access_list.to);
+		hash_access_list(h, o->op_load_access_list.access_list, o->op_load_access_list.access_list_size);
+		break;
+	case OPCODE_LOAD_FLOAT_CONSTANT:
+		hash_bytes(h, &o->op_load_float_constant.number, sizeof(float));
+		hash_variable(h, o->op_load_float_constant.to);
+		break;
+	case OPCODE_LOAD_INT_CONSTANT:
+		hash_u64(h, (uint64_t)(int64_t)o->op_load_int_constant.number);
+		hash_variable(h, o->op_load_int_constant.to);
+		break;
+	case OPCODE_LOAD_BOOL_CONSTANT:
+		hash_u64(h, o->op_load_bool_constant.boolean);
+		hash_variable(h, o->op_load_bool_constant.to);
+		break;
+	case OPCODE_RETURN:
+		if (o->size > offsetof(opcode, op_return)) {
+			hash_variable(h, o->op_return.var);
+		}
+		break;
+	case OPCODE_DISCARD:
+		break;
+	case OPCODE_CALL:
+		hash_variable(h, o->op_call.var);
+		hash_name(h, o->op_call.func);
+		hash_u64(h, o->op_call.parameters_size);
+		for (uint8_t i = 0; i < o->op_call.parameters_size; ++i) {
+			hash_variable(h, o->op_call.parameters[i]);
+		}
+		break;
+	case OPCODE_MULTIPLY:
+	case OPCODE_DIVIDE:
+	case OPCODE_MOD:
+	case OPCODE_ADD:
+	case OPCODE_SUB:
+	case OPCODE_EQUALS:
+	case OPCODE_NOT_EQUALS:
+	case OPCODE_GREATER:
+	case OPCODE_GREATER_EQUAL:
+	case OPCODE_LESS:
+	case OPCODE_LESS_EQUAL:
+	case OPCODE_AND:
+	case OPCODE_OR:
+	case OPCODE_BITWISE_XOR:
+	case OPCODE_BITWISE_AND:
+	case OPCODE_BITWISE_OR:
+	case OPCODE_LEFT_SHIFT:
+	case OPCODE_RIGHT_SHIFT:
+		hash_variable(h, o->op_binary.right);
+		hash_variable(h, o->op_binary.left);
+		hash_variable(h, o->op_binary.result);
+		break;
+	case OPCODE_IF:
+		hash_variable(h, o->op_if.condition);
+		hash_id(h, o->op_if.start_id);
+		hash_id(h, o->op_if.end_id);
+		break;
+	case OPCODE_WHILE_START:
+		hash_id(h, o->op_while_start.start_id);
+		hash_id(h, o->op_while_start.continue_id);
+		hash_id(h, o->op_while_start.end_id);
+		break;
+	case OPCODE_WHILE_END:
+		hash_id(h, o->op_while_end.start_id);
+		hash_id(h, o->op_while_end.continue_id);
+		hash_id(h, o->op_while_end.end_id);
+		break;
+	case OPCODE_WHILE_CONDITION:
+		hash_variable(h, o->op_while.condition);
+		hash_id(h, o->op_while.end_id);
+		break;
+	case OPCODE_WHILE_BODY:
+		break;
+	case OPCODE_BLOCK_START:
+	case OPCODE_BLOCK_END:
+		hash_id(h, o->op_block.id);
+		break;
+	}
+}
+
+static void hash_function(hasher *h, function *f) {
+	hash_name(h, f->name);
+	hash_attributes(h, &f->attributes);
+	hash_type(h, f->return_type.type, 0);
+
+	hash_u64(h, f->parameters_size);
+	for (uint8_t i = 0; i < f->parameters_size; ++i) {
+		hash_name(h, f->parameter_names[i]);
+		hash_type(h, f->parameter_types[i].type, 0);
+		hash_name(h, f->parameter_attributes[i]);
+	}
+
+	uint8_t *data = f->code.o;
+	size_t   size = f->code.size;
+
+	size_t index = 0;
+	while (index < size) {
+		opcode *o = (opcode *)&data[index];
+		hash_opcode(h, o);
+		index += o->size;
+	}
+}
+
+static uint64_t entry_point_key(const char *filename, function *main, shader_stage stage) {
+	hasher h = {
+	    .value   = 0xcbf29ce484222325ull,
+	    .ids     = NULL,
+	    .next_id = 1,
+	};
+
+	hash_u64(&h, salt);
+	hash_string(&h, filename);
+	hash_u64(&h, stage);
+
+	function *functions[256];
+	size_t    functions_size = 0;
+
+	functions[functions_size] = main;
+	functions_size += 1;
+
+	find_referenced_functions(main, functions, &functions_size);
+
+	hash_u64(&h, functions_size);
+	for (size_t i = 0; i < functions_size; ++i) {
+		hash_function(&h, functions[i]);
+	}
+
+	type_id types[256];
+	size_t  types_size = 0;
+	find_referenced_types(main, types, &types_size);
+
+	hash_u64(&h, types_size);
+	for (size_t i = 0; i < types_size; ++i) {
+		hash_type(&h, types[i], 0);
+	}
+
+	global_array globals = {0};
+	find_referenced_globals(main, &globals);
+
+	hash_u64(&h, globals.size);
+	for (size_t i = 0; i < globals.size; ++i) {
+		hash_global(&h, get_global(globals.globals[i]));
+		hash_u64(&h, globals.readable[i]);
+		hash_u64(&h, globals.writable[i]);
+	}
+
+	// bindings are assigned per descriptor set group so everything in the group is part of the key
+	hash_u64(&h, main->descriptor_set_group_index);
+	if (main->descriptor_set_group_index != UINT32_MAX) {
+		descriptor_set_group *group = get_descriptor_set_group(main->descriptor_set_group_index);
+		hash_u64(&h, group->size);
+		for (size_t i = 0; i < group->size; ++i) {
+			descriptor_set *set = group->values[i];
+			hash_name(&h, set->name);
+			hash_u64(&h, set->index);
+			hash_u64(&h, set->globals.size);
+			for (size_t j = 0; j < set->globals.size; ++j) {
+				hash_global(&h, get_global(set->globals.globals[j]));
+			}
+		}
+	}
+
+	hmfree(h.ids);
+
+	return h.value;
+}
+
+static void cache_filename(char *path, size_t size) {
+	snprintf(path, size, "%s/kong_cache", cache_directory);
+}
+
+void cache_init(char *directory, api_kind api, bool debug, bool spirv_ssa) {
+	enabled         = true;
+	cache_directory = directory;
+
+	shfree(stored_keys);
+	shfree(current_keys);
+
+	hasher h = {.value = 0xcbf29ce484222325ull};
+	hash_string(&h, "kong cache 1 " __DATE__ " " __TIME__);
+	hash_u64(&h, api);
+	hash_u64(&h, debug);
+	hash_u64(&h, spirv_ssa);
+	salt = h.value;
+
+	sh_new_strdup(stored_keys);
+	sh_new_strdup(current_keys);
+
+	char path[1024];
+	cache_filename(path, sizeof(path));
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return;
+	}
+
+	char     name[512];
+	uint64_t key;
+	while (fscanf(file, "%511s %" SCNx64, name, &key) == 2) {
+		shput(stored_keys, name, key);
+	}
+
+	fclose(file);
+}
+
+static bool file_exists(const char *filename, const char *extension) {
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s%s", cache_directory, filename, extension);
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	fclose(file);
+	return true;
+}
+
+bool cache_check(const char *filename, function *main, shader_stage stage) {
+	if (!enabled) {
+		return false;
+	}
+
+	uint64_t key = entry_point_key(filename, main, stage);
+	shput(current_keys, filename, key);
+
+	ptrdiff_t index = shgeti(stored_keys, filename);
+	return index >= 0 && stored_keys[index].value == key && file_exists(filename, ".h") && file_exists(filename, ".c");
+}
+
+void cache_save(void) {
+	if (!enabled) {
+		return;
+	}
+
+	char path[1024];
+	cache_filename(path, sizeof(path));
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		kong_log(LOG_LEVEL_WARNING, "Could not write %s.", path);
+		return;
+	}
+
+	for (ptrdiff_t i = 0; i < shlen(current_keys); ++i) {
+		fprintf(file, "%s %016" PRIx64 "\n", current_keys[i].key, current_keys[i].value);
+	}
+
+	fclose(file);
+
+	shfree(stored_keys);
+	shfree(current_keys);
+	enabled = false;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "api.h"
+#include "functions.h"
+#include "shader_stage.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void cache_init(char *directory, api_kind api, bool debug, bool spirv_ssa);
+
+// true when the files of the given name are still up to date for this entry point, otherwise the new key is remembered for cache_save
+bool cache_check(const char *filename, function *main, shader_stage stage);
+
+void cache_save(void);
@@ -1,10 +1,14 @@
 #include "compiler.h"
 
 #include "errors.h"
+#include "functions.h"
+#include "jobs.h"
+#include "name_map.h"
 #include "parser.h"
 
 #include <assert.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 typedef struct allocated_global {
@@ -13,13 +17,13 @@ typedef struct allocated_global {
 } allocated_global;
 
 static allocated_global allocated_globals[1024];
-static size_t           allocated_globals_size = 0;
+static size_t           allocated_globals_size    = 0;
+static name_map         allocated_globals_by_name = {0}; // the first allocated global of each name
 
 allocated_global find_allocated_global(name_id name) {
-	for (size_t i = 0; i < allocated_globals_size; ++i) {
-		if (name == allocated_globals[i].g->name) {
-			return allocated_globals[i];
-		}
+	uint32_t index = name_map_get(&allocated_globals_by_name, name);
+	if (index != NAME_MAP_NOT_FOUND) {
+		return allocated_globals[index];
 	}
 
 	allocated_global a;
@@ -32,7 +36,7 @@ variable find_local_var(block *b, name_id name) {
 	if (b == NULL) {
 		variable var;
 		var.index = 0;
-		init_type_ref(&var.type, NO_NAME);
+		var.type  = NO_TYPE;
 		return var;
 	}
 
@@ -42,7 +46,7 @@ variable find_local_var(block *b, name_id name) {
 			check(b->vars.v[i].type.type != NO_TYPE, context, "Local variable does not have a type");
 			variable var;
 			var.index = b->vars.v[i].variable_id;
-			var.type  = b->vars.v[i].type;
+			var.type  = b->vars.v[i].type.type;
 			var.kind  = VARIABLE_LOCAL;
 			return var;
 		}
@@ -57,10 +61,9 @@ variable find_variable(block *parent, name_id name) {
 		allocated_global global = find_allocated_global(name);
 		if (global.g->type != NO_TYPE && global.variable_id != 0) {
 			variable v;
-			init_type_ref(&v.type, NO_NAME);
-			v.type.type = global.g->type;
-			v.index     = global.variable_id;
-			v.kind      = VARIABLE_GLOBAL;
+			v.type  = global.g->type;
+			v.index = global.variable_id;
+			v.kind  = VARIABLE_GLOBAL;
 			return v;
 		}
 		else {
@@ -77,28 +80,63 @@ variable find_variable(block *parent, name_id name) {
 	}
 }
 
-const char all_names[1024 * 1024];
-
-static uint64_t next_variable_id = 1;
+static uint32_t                   function_variables_start = 1;
+static KONG_THREAD_LOCAL uint32_t next_variable_id         = 1;
 
-variable all_variables[1024 * 1024];
+variable allocate_variable(type_id type, variable_kind kind) {
+	debug_context context = {0};
+	check(next_variable_id < UINT32_MAX, context, "Too many variables");
 
-variable allocate_variable(type_ref type, variable_kind kind) {
 	variable v;
-	v.index                = next_variable_id;
-	v.type                 = type;
-	v.kind                 = kind;
-	all_variables[v.index] = v;
+	v.index = next_variable_id;
+	v.type  = type;
+	v.kind  = kind;
 	++next_variable_id;
 	return v;
 }
 
+void begin_function_variables(function *f) {
+	next_variable_id = f->variables_end;
+}
+
+void end_function_variables(function *f) {
+	f->variables_end = next_variable_id;
+}
+
+uint32_t first_function_variable_index(void) {
+	return function_variables_start;
+}
+
+void opcodes_reserve(opcodes *code, size_t size) {
+	if (size <= code->capacity) {
+		return;
+	}
+
+	size_t capacity = code->capacity == 0 ? 1024 : code->capacity;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	uint8_t      *new_o   = realloc(code->o, capacity);
+	debug_context context = {0};
+	check(new_o != NULL, context, "Could not allocate opcodes");
+	code->o        = new_o;
+	code->capacity = capacity;
+}
+
+void opcodes_free(opcodes *code) {
+	free(code->o);
+	code->o        = NULL;
+	code->size     = 0;
+	code->capacity = 0;
+}
+
 opcode *emit_op(opcodes *code, opcode *o) {
-	assert(code->size + o->size < OPCODES_SIZE);
+	opcodes_reserve(code, code->size + o->size);
 
 	uint8_t *location = &code->o[code->size];
 
-	memcpy(&code->o[code->size], o, o->size);
+	memcpy(location, o, o->size);
 
 	code->size += o->size;
 
@@ -124,10 +162,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		case OPERATOR_OR: {
 			variable right_var = emit_expression(code, parent, right);
 			variable left_var  = emit_expression(code, parent, left);
-			type_ref t;
-			init_type_ref(&t, NO_NAME);
-			t.type              = bool_id;
-			variable result_var = allocate_variable(t, VARIABLE_INTERNAL);
+			variable result_var = allocate_variable(bool_id, VARIABLE_INTERNAL);
 
 			opcode o;
 			switch (e->binary.op) {
@@ -179,7 +214,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		case OPERATOR_RIGHT_SHIFT: {
 			variable right_var  = emit_expression(code, parent, right);
 			variable left_var   = emit_expression(code, parent, left);
-			variable result_var = allocate_variable(e->type, VARIABLE_INTERNAL);
+			variable result_var = allocate_variable(e->type.type, VARIABLE_INTERNAL);
 
 			opcode o;
 			switch (e->binary.op) {
@@ -288,7 +323,6 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 					error(context, "Unexpected operator");
 				}
 				}
-				o.size                      = OP_SIZE(o, op_store_access_list);
 				o.op_store_access_list.from = v;
 
 				expression *of = left;
@@ -331,6 +365,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 				}
 
 				o.op_store_access_list.access_list_size = access_list_size;
+				o.size                                  = OP_SIZE_ACCESS_LIST(o, op_store_access_list);
 
 				for (uint32_t access_index = 0; access_index < access_list_size; ++access_index) {
 					o.op_store_access_list.access_list[access_list_size - access_index - 1] = access_list[access_index];
@@ -419,10 +454,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		}
 	}
 	case EXPRESSION_BOOLEAN: {
-		type_ref t;
-		init_type_ref(&t, NO_NAME);
-		t.type     = float_id;
-		variable v = allocate_variable(t, VARIABLE_INTERNAL);
+		variable v = allocate_variable(float_id, VARIABLE_INTERNAL);
 
 		opcode o;
 		o.type                          = OPCODE_LOAD_BOOL_CONSTANT;
@@ -434,10 +466,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		return v;
 	}
 	case EXPRESSION_FLOAT: {
-		type_ref t;
-		init_type_ref(&t, NO_NAME);
-		t.type     = float_id;
-		variable v = allocate_variable(t, VARIABLE_INTERNAL);
+		variable v = allocate_variable(float_id, VARIABLE_INTERNAL);
 
 		opcode o;
 		o.type                          = OPCODE_LOAD_FLOAT_CONSTANT;
@@ -449,10 +478,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		return v;
 	}
 	case EXPRESSION_INT: {
-		type_ref t;
-		init_type_ref(&t, NO_NAME);
-		t.type     = int_id;
-		variable v = allocate_variable(t, VARIABLE_INTERNAL);
+		variable v = allocate_variable(int_id, VARIABLE_INTERNAL);
 
 		opcode o;
 		o.type                        = OPCODE_LOAD_INT_CONSTANT;
@@ -472,16 +498,13 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		return emit_expression(code, parent, e->grouping);
 	}
 	case EXPRESSION_CALL: {
-		type_ref t;
-		init_type_ref(&t, NO_NAME);
-		t.type     = e->type.type;
-		variable v = allocate_variable(t, VARIABLE_INTERNAL);
+		variable v = allocate_variable(e->type.type, VARIABLE_INTERNAL);
 
 		opcode o;
-		o.type         = OPCODE_CALL;
-		o.size         = OP_SIZE(o, op_call);
-		o.op_call.func = e->call.func_name;
-		o.op_call.var  = v;
+		o.type           = OPCODE_CALL;
+		o.op_call.func   = e->call.func_name;
+		o.op_call.callee = find_function(e->call.func_name);
+		o.op_call.var    = v;
 
 		debug_context context = {0};
 		check(e->call.parameters.size <= sizeof(o.op_call.parameters) / sizeof(variable), context, "Call parameters missized");
@@ -489,6 +512,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 			o.op_call.parameters[i] = emit_expression(code, parent, e->call.parameters.e[i]);
 		}
 		o.op_call.parameters_size = (uint8_t)e->call.parameters.size;
+		o.size                    = OP_SIZE_CALL(o);
 
 		emit_op(code, &o);
 
@@ -499,9 +523,8 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 	case EXPRESSION_SWIZZLE: {
 		opcode o;
 		o.type = OPCODE_LOAD_ACCESS_LIST;
-		o.size = OP_SIZE(o, op_load_access_list);
 
-		variable v               = allocate_variable(e->type, VARIABLE_INTERNAL);
+		variable v               = allocate_variable(e->type.type, VARIABLE_INTERNAL);
 		o.op_load_access_list.to = v;
 
 		expression *of = e;
@@ -544,6 +567,7 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 		}
 
 		o.op_load_access_list.access_list_size = access_list_size;
+		o.size                                 = OP_SIZE_ACCESS_LIST(o, op_load_access_list);
 
 		for (uint32_t access_index = 0; access_index < access_list_size; ++access_index) {
 			o.op_load_access_list.access_list[access_list_size - access_index - 1] = access_list[access_index];
@@ -571,8 +595,8 @@ variable emit_expression(opcodes *code, block *parent, expression *e) {
 }
 
 typedef struct block_ids {
-	uint64_t start;
-	uint64_t end;
+	uint32_t start;
+	uint32_t end;
 } block_ids;
 
 static block_ids emit_statement(opcodes *code, block *parent, statement *statement) {
@@ -619,13 +643,16 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 
 			o.op_if.condition = initial_condition;
 
-			opcode *written_opcode = emit_op(code, &o);
+			size_t written_offset = code->size;
+			emit_op(code, &o);
 
 			previous_conditions[previous_conditions_size].condition = initial_condition;
 			previous_conditions_size += 1;
 
 			block_ids ids = emit_statement(code, parent, statement->iffy.if_block);
 
+			// the buffer can have moved while emitting the block
+			opcode *written_opcode         = (opcode *)&code->o[written_offset];
 			written_opcode->op_if.start_id = ids.start;
 			written_opcode->op_if.end_id   = ids.end;
 		}
@@ -634,13 +661,10 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 			variable current_condition;
 			{
 				opcode o;
-				o.type        = OPCODE_NOT;
-				o.size        = OP_SIZE(o, op_not);
-				o.op_not.from = previous_conditions[previous_conditions_size - 1].condition;
-				type_ref t;
-				init_type_ref(&t, NO_NAME);
-				t.type            = bool_id;
-				current_condition = allocate_variable(t, VARIABLE_INTERNAL);
+				o.type            = OPCODE_NOT;
+				o.size            = OP_SIZE(o, op_not);
+				o.op_not.from     = previous_conditions[previous_conditions_size - 1].condition;
+				current_condition = allocate_variable(bool_id, VARIABLE_INTERNAL);
 				o.op_not.to       = current_condition;
 				emit_op(code, &o);
 			}
@@ -651,14 +675,11 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 			}
 			else {
 				opcode o;
-				o.type            = OPCODE_AND;
-				o.size            = OP_SIZE(o, op_binary);
-				o.op_binary.left  = previous_conditions[previous_conditions_size - 2].summed_condition;
-				o.op_binary.right = current_condition;
-				type_ref t;
-				init_type_ref(&t, NO_NAME);
-				t.type             = bool_id;
-				summed_condition   = allocate_variable(t, VARIABLE_INTERNAL);
+				o.type             = OPCODE_AND;
+				o.size             = OP_SIZE(o, op_binary);
+				o.op_binary.left   = previous_conditions[previous_conditions_size - 2].summed_condition;
+				o.op_binary.right  = current_condition;
+				summed_condition   = allocate_variable(bool_id, VARIABLE_INTERNAL);
 				o.op_binary.result = summed_condition;
 				emit_op(code, &o);
 			}
@@ -673,14 +694,11 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 				variable else_test;
 				{
 					opcode o;
-					o.type            = OPCODE_AND;
-					o.size            = OP_SIZE(o, op_binary);
-					o.op_binary.left  = summed_condition;
-					o.op_binary.right = v;
-					type_ref t;
-					init_type_ref(&t, NO_NAME);
-					t.type             = bool_id;
-					else_test          = allocate_variable(t, VARIABLE_INTERNAL);
+					o.type             = OPCODE_AND;
+					o.size             = OP_SIZE(o, op_binary);
+					o.op_binary.left   = summed_condition;
+					o.op_binary.right  = v;
+					else_test          = allocate_variable(bool_id, VARIABLE_INTERNAL);
 					o.op_binary.result = else_test;
 					emit_op(code, &o);
 				}
@@ -695,10 +713,12 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 			}
 
 			{
-				opcode *written_opcode = emit_op(code, &o);
+				size_t written_offset = code->size;
+				emit_op(code, &o);
 
 				block_ids ids = emit_statement(code, parent, statement->iffy.else_blocks[i]);
 
+				opcode *written_opcode         = (opcode *)&code->o[written_offset];
 				written_opcode->op_if.start_id = ids.start;
 				written_opcode->op_if.end_id   = ids.end;
 			}
@@ -707,11 +727,11 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 		break;
 	}
 	case STATEMENT_WHILE: {
-		uint64_t start_id = next_variable_id;
+		uint32_t start_id = next_variable_id;
 		++next_variable_id;
-		uint64_t continue_id = next_variable_id;
+		uint32_t continue_id = next_variable_id;
 		++next_variable_id;
-		uint64_t end_id = next_variable_id;
+		uint32_t end_id = next_variable_id;
 		++next_variable_id;
 
 		{
@@ -752,11 +772,11 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 		break;
 	}
 	case STATEMENT_DO_WHILE: {
-		uint64_t start_id = next_variable_id;
+		uint32_t start_id = next_variable_id;
 		++next_variable_id;
-		uint64_t continue_id = next_variable_id;
+		uint32_t continue_id = next_variable_id;
 		++next_variable_id;
-		uint64_t end_id = next_variable_id;
+		uint32_t end_id = next_variable_id;
 		++next_variable_id;
 
 		{
@@ -798,14 +818,14 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 	}
 	case STATEMENT_BLOCK: {
 		for (size_t i = 0; i < statement->block.vars.size; ++i) {
-			variable var                           = allocate_variable(statement->block.vars.v[i].type, VARIABLE_LOCAL);
+			variable var                           = allocate_variable(statement->block.vars.v[i].type.type, VARIABLE_LOCAL);
 			statement->block.vars.v[i].variable_id = var.index;
 		}
 
-		uint64_t start_block_id = next_variable_id;
+		uint32_t start_block_id = next_variable_id;
 		++next_variable_id;
 
-		uint64_t end_block_id = next_variable_id;
+		uint32_t end_block_id = next_variable_id;
 		++next_variable_id;
 
 		{
@@ -848,7 +868,7 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 		o.op_var.var.index                        = statement->local_variable.var.variable_id;
 		debug_context context                     = {0};
 		check(statement->local_variable.var.type.type != NO_TYPE, context, "Local var has no type");
-		o.op_var.var.type = statement->local_variable.var.type;
+		o.op_var.var.type = statement->local_variable.var.type.type;
 		emit_op(code, &o);
 
 		if (statement->local_variable.init != NULL) {
@@ -872,23 +892,33 @@ static block_ids emit_statement(opcodes *code, block *parent, statement *stateme
 	return ids;
 }
 
+void compiler_reset(void) {
+	allocated_globals_size   = 0;
+	next_variable_id         = 1;
+	function_variables_start = 1;
+	name_map_clear(&allocated_globals_by_name);
+}
+
 void allocate_globals(void) {
 	for (global_id i = 0; get_global(i) != NULL && get_global(i)->type != NO_TYPE; ++i) {
 		global *g = get_global(i);
 
-		type_ref t;
-		init_type_ref(&t, NO_NAME);
-		t.type                                                = g->type;
-		variable v                                            = allocate_variable(t, VARIABLE_GLOBAL);
+		variable v                                            = allocate_variable(g->type, VARIABLE_GLOBAL);
 		allocated_globals[allocated_globals_size].g           = g;
 		allocated_globals[allocated_globals_size].variable_id = v.index;
+		if (name_map_get(&allocated_globals_by_name, g->name) == NAME_MAP_NOT_FOUND) {
+			name_map_set(&allocated_globals_by_name, g->name, (uint32_t)allocated_globals_size);
+		}
 		allocated_globals_size += 1;
 
 		assign_global_var(i, v.index);
 	}
+
+	function_variables_start = next_variable_id;
 }
 
-void compile_function_block(opcodes *code, struct statement *block) {
+void compile_function(function *f) {
+	statement *block = f->block;
 	if (block == NULL) {
 		// built-in
 		return;
@@ -898,11 +928,17 @@ void compile_function_block(opcodes *code, struct statement *block) {
 		debug_context context = {0};
 		error(context, "Expected a block");
 	}
+
+	f->variables_end = function_variables_start;
+	begin_function_variables(f);
+
 	for (size_t i = 0; i < block->block.vars.size; ++i) {
-		variable var                       = allocate_variable(block->block.vars.v[i].type, VARIABLE_LOCAL);
+		variable var                       = allocate_variable(block->block.vars.v[i].type.type, VARIABLE_LOCAL);
 		block->block.vars.v[i].variable_id = var.index;
 	}
 	for (size_t i = 0; i < block->block.statements.size; ++i) {
-		emit_statement(code, &block->block, block->block.statements.s[i]);
+		emit_statement(&f->code, &block->block, block->block.statements.s[i]);
 	}
+
+	end_function_variables(f);
 }
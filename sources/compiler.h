@@ -8,10 +8,11 @@
 
 typedef enum variable_kind { VARIABLE_GLOBAL, VARIABLE_LOCAL, VARIABLE_INTERNAL } variable_kind;
 
+// Variables in the opcodes only carry their resolved type, the ids are unique within a function (see begin_function_variables)
 typedef struct variable {
 	variable_kind kind;
-	uint64_t      index;
-	type_ref      type;
+	uint32_t      index;
+	type_id       type;
 } variable;
 
 typedef enum access_kind { ACCESS_MEMBER, ACCESS_ELEMENT, ACCESS_SWIZZLE } access_kind;
@@ -105,8 +106,8 @@ typedef struct opcode {
 			variable from;
 			variable to;
 
-			access  access_list[64];
 			uint8_t access_list_size;
+			access  access_list[64]; // only access_list_size entries are stored
 		} op_store_access_list;
 		struct {
 			float    number;
@@ -124,8 +125,8 @@ typedef struct opcode {
 			variable from;
 			variable to;
 
-			access  access_list[64];
 			uint8_t access_list_size;
+			access  access_list[64]; // only access_list_size entries are stored
 		} op_load_access_list;
 		struct {
 			variable var;
@@ -133,8 +134,9 @@ typedef struct opcode {
 		struct {
 			variable var;
 			name_id  func;
-			variable parameters[64];
+			uint32_t callee; // function_id of func, resolved when the call is emitted
 			uint8_t  parameters_size;
+			variable parameters[64]; // only parameters_size entries are stored
 		} op_call;
 		struct {
 			variable right;
@@ -143,25 +145,25 @@ typedef struct opcode {
 		} op_binary;
 		struct {
 			variable condition;
-			uint64_t start_id;
-			uint64_t end_id;
+			uint32_t start_id;
+			uint32_t end_id;
 		} op_if;
 		struct {
-			uint64_t start_id;
-			uint64_t continue_id;
-			uint64_t end_id;
+			uint32_t start_id;
+			uint32_t continue_id;
+			uint32_t end_id;
 		} op_while_start;
 		struct {
-			uint64_t start_id;
-			uint64_t continue_id;
-			uint64_t end_id;
+			uint32_t start_id;
+			uint32_t continue_id;
+			uint32_t end_id;
 		} op_while_end;
 		struct {
 			variable condition;
-			uint64_t end_id;
+			uint32_t end_id;
 		} op_while;
 		struct {
-			uint64_t id;
+			uint32_t id;
 		} op_block;
 		struct {
 			uint8_t nothing;
@@ -169,19 +171,43 @@ typedef struct opcode {
 	};
 } opcode;
 
-#define OPCODES_SIZE (1024 * 1024)
-
+// A zero-initialized opcodes is empty, the buffer grows on demand
 typedef struct opcodes {
-	uint8_t o[OPCODES_SIZE];
-	size_t  size;
+	uint8_t *o;
+	size_t   size;
+	size_t   capacity;
 } opcodes;
 
+void opcodes_reserve(opcodes *code, size_t size);
+
+void opcodes_free(opcodes *code);
+
+// appends o->size bytes of o and returns where they were written
+opcode *emit_op(opcodes *code, opcode *o);
+
+void compiler_reset(void);
+
 void allocate_globals(void);
 
-struct statement;
+struct function;
+
+void compile_function(struct function *f);
+
+// Globals take the first variable indices and every function numbers its local and internal variables densely after them, so
+// those indices are only unique within their function. allocate_variable numbers the variables of the function the calling
+// thread has begun.
+void begin_function_variables(struct function *f);
+void end_function_variables(struct function *f);
+
+uint32_t first_function_variable_index(void);
+
+variable allocate_variable(type_id type, variable_kind kind);
 
-void compile_function_block(opcodes *code, struct statement *block);
+// sizes are rounded up so every opcode in a stream stays aligned
+#define OP_ALIGN(size) (((size) + _Alignof(opcode) - 1) & ~(_Alignof(opcode) - 1))
 
-variable allocate_variable(type_ref type, variable_kind kind);
+#define OP_SIZE(op, opmember) OP_ALIGN(offsetof(opcode, opmember) + sizeof(op.opmember))
 
-#define OP_SIZE(op, opmember) offsetof(opcode, opmember) + sizeof(op.opmember)
+// access lists and call parameters are cut off after their last entry, the sizes have to be set first
+#define OP_SIZE_ACCESS_LIST(op, opmember) OP_ALIGN(offsetof(opcode, opmember.access_list) + op.opmember.access_list_size * sizeof(access))
+#define OP_SIZE_CALL(op) OP_ALIGN(offsetof(opcode, op_call.parameters) + op.op_call.parameters_size * sizeof(variable))
@@ -1,6 +1,6 @@
 #include "dir.h"
 
-#include "log.h"
+#include "errors.h"
 
 #include <stddef.h>
 #include <stdio.h>
@@ -40,6 +40,28 @@ __declspec(dllimport) int __stdcall FindClose(void *hFindFile);
 
 __declspec(dllimport) unsigned long __stdcall GetLastError(void);
 
+__declspec(dllimport) void *__stdcall CreateFileA(const char *lpFileName, unsigned long dwDesiredAccess, unsigned long dwShareMode, void *lpSecurityAttributes,
+                                                  unsigned long dwCreationDisposition, unsigned long dwFlagsAndAttributes, void *hTemplateFile);
+
+__declspec(dllimport) int __stdcall GetFileSizeEx(void *hFile, __int64 *lpFileSize);
+
+__declspec(dllimport) void *__stdcall CreateFileMappingA(void *hFile, void *lpFileMappingAttributes, unsigned long flProtect, unsigned long dwMaximumSizeHigh,
+                                                         unsigned long dwMaximumSizeLow, const char *lpName);
+
+__declspec(dllimport) void *__stdcall MapViewOfFile(void *hFileMappingObject, unsigned long dwDesiredAccess, unsigned long dwFileOffsetHigh,
+                                                    unsigned long dwFileOffsetLow, size_t dwNumberOfBytesToMap);
+
+__declspec(dllimport) int __stdcall UnmapViewOfFile(const void *lpBaseAddress);
+
+__declspec(dllimport) int __stdcall CloseHandle(void *hObject);
+
+#define GENERIC_READ 0x80000000L
+#define FILE_SHARE_READ 0x00000001
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x0004
+
 #define INVALID_HANDLE_VALUE ((void *)(__int64)-1)
 
 directory open_dir(const char *dirname) {
@@ -51,8 +73,7 @@ directory open_dir(const char *dirname) {
 	directory        dir;
 	dir.handle = FindFirstFileA(pattern, &data);
 	if (dir.handle == INVALID_HANDLE_VALUE) {
-		kong_log(LOG_LEVEL_ERROR, "FindFirstFile failed (%d)\n", GetLastError());
-		exit(1);
+		error_no_context("FindFirstFile failed (%d)", GetLastError());
 	}
 	FindNextFileA(dir.handle, &data);
 	return dir;
@@ -75,21 +96,64 @@ void close_dir(directory *dir) {
 	FindClose(dir->handle);
 }
 
+bool map_file(const char *filename, mapped_file *file) {
+	file->data    = "";
+	file->size    = 0;
+	file->mapping = NULL;
+
+	file->handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file->handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	__int64 size = 0;
+	GetFileSizeEx(file->handle, &size);
+	if (size == 0) {
+		return true;
+	}
+
+	file->mapping = CreateFileMappingA(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file->mapping == NULL) {
+		CloseHandle(file->handle);
+		return false;
+	}
+
+	file->data = (const char *)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file->data == NULL) {
+		CloseHandle(file->mapping);
+		CloseHandle(file->handle);
+		return false;
+	}
+
+	file->size = (size_t)size;
+	return true;
+}
+
+void unmap_file(mapped_file *file) {
+	if (file->mapping != NULL) {
+		UnmapViewOfFile(file->data);
+		CloseHandle(file->mapping);
+	}
+	CloseHandle(file->handle);
+}
+
 #else
 
 #include <stdlib.h>
 #include <string.h>
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 directory open_dir(const char *dirname) {
 	directory dir;
 	dir.handle = opendir(dirname);
 	if (dir.handle == NULL) {
-		kong_log(LOG_LEVEL_ERROR, "Failed to open directory: %s", dirname);
-		exit(1);
+		error_no_context("Failed to open directory: %s", dirname);
 	}
 	return dir;
 }
@@ -111,6 +175,47 @@ file read_next_file(directory *dir) {
 	return f;
 }
 
-void close_dir(directory *dir) {}
+void close_dir(directory *dir) {
+	closedir(dir->handle);
+}
+
+bool map_file(const char *filename, mapped_file *file) {
+	file->data    = "";
+	file->size    = 0;
+	file->handle  = NULL;
+	file->mapping = NULL;
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return false;
+	}
+
+	if (info.st_size > 0) {
+		void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+		file->data    = (const char *)data;
+		file->size    = (size_t)info.st_size;
+		file->mapping = data;
+	}
+
+	// the mapping stays valid without the descriptor
+	close(fd);
+	return true;
+}
+
+void unmap_file(mapped_file *file) {
+	if (file->mapping != NULL) {
+		munmap(file->mapping, file->size);
+	}
+}
 
 #endif
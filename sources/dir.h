@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct directory {
 	void *handle;
@@ -14,3 +15,14 @@ typedef struct file {
 directory open_dir(const char *dirname);
 file      read_next_file(directory *dir);
 void      close_dir(directory *dir);
+
+typedef struct mapped_file {
+	const char *data;
+	size_t      size;
+	void       *handle;
+	void       *mapping;
+} mapped_file;
+
+// maps a file read-only, data is not null-terminated
+bool map_file(const char *filename, mapped_file *file);
+void unmap_file(mapped_file *file);
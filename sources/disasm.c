@@ -71,7 +71,7 @@ static void write_functions(void) {
 				for (int i = 0; i < o->op_load_access_list.access_list_size; ++i) {
 					switch (o->op_load_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						offset += sprintf(&accesses[offset], "$%" PRIu64, o->op_load_access_list.access_list[i].access_element.index.index);
+						offset += sprintf(&accesses[offset], "$%" PRIu32, o->op_load_access_list.access_list[i].access_element.index.index);
 						break;
 					case ACCESS_MEMBER:
 						offset += sprintf(&accesses[offset], "%s", get_name(o->op_load_access_list.access_list[i].access_member.name));
@@ -102,7 +102,7 @@ static void write_functions(void) {
 				parameters[0] = 0;
 
 				for (int i = 0; i < o->op_call.parameters_size; ++i) {
-					offset += sprintf(&parameters[offset], "$%" PRIu64, o->op_call.parameters[i].index);
+					offset += sprintf(&parameters[offset], "$%" PRIu32, o->op_call.parameters[i].index);
 
 					if (i < o->op_call.parameters_size - 1) {
 						offset += sprintf(&parameters[offset], ", ");
@@ -135,7 +135,7 @@ static void write_functions(void) {
 				for (int i = 0; i < o->op_store_access_list.access_list_size; ++i) {
 					switch (o->op_store_access_list.access_list[i].kind) {
 					case ACCESS_ELEMENT:
-						offset += sprintf(&accesses[offset], "$%" PRIu64, o->op_store_access_list.access_list[i].access_element.index.index);
+						offset += sprintf(&accesses[offset], "$%" PRIu32, o->op_store_access_list.access_list[i].access_element.index.index);
 						break;
 					case ACCESS_MEMBER:
 						offset += sprintf(&accesses[offset], "%s", get_name(o->op_store_access_list.access_list[i].access_member.name));
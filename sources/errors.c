@@ -1,10 +1,27 @@
 #include "errors.h"
 
+#include "jobs.h"
 #include "log.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+static KONG_THREAD_LOCAL jmp_buf *error_recovery = NULL;
+
+jmp_buf *set_error_recovery(jmp_buf *recovery) {
+	jmp_buf *previous = error_recovery;
+	error_recovery    = recovery;
+	return previous;
+}
+
+static noreturn void fail(void) {
+	if (error_recovery != NULL) {
+		longjmp(*error_recovery, 1);
+	}
+
+	exit(1);
+}
+
 static void debug_break(void) {
 #ifndef NDEBUG
 #if defined(_MSC_VER)
@@ -37,15 +54,25 @@ void error_args(debug_context context, const char *message, va_list args) {
 
 	kong_log_args(LOG_LEVEL_ERROR, buffer, args);
 
-	debug_break();
+	if (error_recovery == NULL) {
+		debug_break();
+	}
 
-	exit(1);
+	fail();
+}
+
+void error_reported(void) {
+	if (error_recovery == NULL) {
+		debug_break();
+	}
+
+	fail();
 }
 
 void error_args_no_context(const char *message, va_list args) {
 	kong_log_args(LOG_LEVEL_ERROR, message, args);
 
-	exit(1);
+	fail();
 }
 
 void error(debug_context context, const char *message, ...) {
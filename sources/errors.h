@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <setjmp.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -31,6 +32,12 @@ void          check_function(bool test, debug_context context, const char *messa
 	check_function(test, context, message, ##__VA_ARGS__)
 void check_args(bool test, debug_context context, const char *message, va_list args);
 
+// when set, errors on the calling thread jump to recovery instead of exiting the process, returns the previous recovery
+jmp_buf *set_error_recovery(jmp_buf *recovery);
+
+// fails on the calling thread for an error that was already logged, like one that happened in a job
+noreturn void error_reported(void);
+
 // V_ASSERT_CONTRACT, assertMacro:check
 
 #ifdef __cplusplus
@@ -1,6 +1,7 @@
 #include "functions.h"
 
 #include "errors.h"
+#include "name_map.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -10,6 +11,10 @@ static function   *functions           = NULL;
 static function_id functions_size      = 1024;
 static function_id next_function_index = 0;
 
+static function_id snapshot_functions_size = 0;
+
+static name_map functions_by_name = {0}; // the first function of each name
+
 static void add_func_int(char *name) {
 	function_id func = add_function(add_name(name));
 	function   *f    = get_function(func);
@@ -216,6 +221,7 @@ void functions_init(void) {
 	check(new_functions != NULL, context, "Could not allocate functions");
 	functions           = new_functions;
 	next_function_index = 0;
+	name_map_clear(&functions_by_name);
 
 	{
 		function_id func = add_function(add_name("sample"));
@@ -784,6 +790,32 @@ void functions_init(void) {
 	}
 }
 
+void functions_snapshot(void) {
+	snapshot_functions_size = next_function_index;
+}
+
+// built-in functions have no code so only the analysis results have to be dropped
+void functions_restore(void) {
+	for (function_id i = snapshot_functions_size; i < next_function_index; ++i) {
+		opcodes_free(&functions[i].code);
+	}
+
+	next_function_index = snapshot_functions_size;
+
+	for (function_id i = 0; i < next_function_index; ++i) {
+		functions[i].descriptor_set_group_index = UINT32_MAX;
+		functions[i].used_builtins              = (builtins){0};
+		functions[i].used_capabilities          = (capabilities){0};
+	}
+
+	name_map_clear(&functions_by_name);
+	for (function_id i = 0; i < next_function_index; ++i) {
+		if (name_map_get(&functions_by_name, functions[i].name) == NAME_MAP_NOT_FOUND) {
+			name_map_set(&functions_by_name, functions[i].name, i);
+		}
+	}
+}
+
 static void grow_if_needed(uint64_t size) {
 	while (size >= functions_size) {
 		functions_size *= 2;
@@ -805,24 +837,23 @@ function_id add_function(name_id name) {
 	init_type_ref(&functions[f].return_type, NO_NAME);
 	functions[f].parameters_size = 0;
 	memset(functions[f].parameter_attributes, 0, sizeof(functions[f].parameter_attributes));
-	functions[f].block = NULL;
-	memset(functions[f].code.o, 0, sizeof(functions[f].code.o));
-	functions[f].code.size                  = 0;
+	functions[f].block                      = NULL;
+	functions[f].code                       = (opcodes){0};
+	functions[f].variables_end              = 0;
 	functions[f].descriptor_set_group_index = UINT32_MAX;
 	functions[f].used_builtins              = (builtins){0};
 	functions[f].used_capabilities          = (capabilities){0};
 
+	if (name_map_get(&functions_by_name, name) == NAME_MAP_NOT_FOUND) {
+		name_map_set(&functions_by_name, name, f);
+	}
+
 	return f;
 }
 
 function_id find_function(name_id name) {
-	for (function_id i = 0; i < next_function_index; ++i) {
-		if (functions[i].name == name) {
-			return i;
-		}
-	}
-
-	return NO_FUNCTION;
+	uint32_t f = name_map_get(&functions_by_name, name);
+	return f == NAME_MAP_NOT_FOUND ? NO_FUNCTION : f;
 }
 
 function *get_function(function_id function) {
@@ -831,3 +862,9 @@ function *get_function(function_id function) {
 	}
 	return &functions[function];
 }
+
+function_id get_function_id(function *f) {
+	debug_context context = {0};
+	check(f >= functions && f < functions + next_function_index, context, "Encountered a function that is not in the functions list");
+	return (function_id)(f - functions);
+}
@@ -39,13 +39,18 @@ typedef struct function {
 	builtins     used_builtins;
 	capabilities used_capabilities;
 
-	opcodes code;
+	opcodes  code;
+	uint32_t variables_end; // the local and internal variables of code are numbered below this
 } function;
 
 void functions_init(void);
+void functions_snapshot(void);
+void functions_restore(void);
 
 function_id add_function(name_id name);
 
 function_id find_function(name_id name);
 
 function *get_function(function_id function);
+
+function_id get_function_id(function *f);
@@ -1,12 +1,25 @@
 #include "globals.h"
 
 #include "errors.h"
+#include "name_map.h"
 
 #include <assert.h>
+#include <string.h>
 
 static global    globals[1024];
 static global_id globals_size = 0;
 
+static global    snapshot_globals[1024];
+static global_id snapshot_globals_size = 0;
+
+static name_map globals_by_name = {0}; // the first global of each name
+
+static void index_global(global_id g) {
+	if (name_map_get(&globals_by_name, globals[g].name) == NAME_MAP_NOT_FOUND) {
+		name_map_set(&globals_by_name, globals[g].name, g);
+	}
+}
+
 void globals_init(void) {
 	global_value int_value;
 	int_value.kind = GLOBAL_VALUE_INT;
@@ -157,7 +170,25 @@ void globals_init(void) {
 	add_global_with_value(uint_id, attributes, add_name("TEXTURE_FORMAT_DEPTH32_FLOAT_STENCIL8_NOTHING24"), uint_value);
 }
 
+void globals_snapshot(void) {
+	memcpy(snapshot_globals, globals, globals_size * sizeof(global));
+	snapshot_globals_size = globals_size;
+}
+
+void globals_restore(void) {
+	memcpy(globals, snapshot_globals, snapshot_globals_size * sizeof(global));
+	globals_size = snapshot_globals_size;
+
+	name_map_clear(&globals_by_name);
+	for (global_id g = 0; g < globals_size; ++g) {
+		index_global(g);
+	}
+}
+
 global_id add_global(type_id type, attribute_list attributes, name_id name) {
+	debug_context context = {0};
+	check(globals_size < sizeof(globals) / sizeof(globals[0]), context, "Too many globals");
+
 	uint32_t index            = globals_size;
 	globals[index].name       = name;
 	globals[index].type       = type;
@@ -167,10 +198,16 @@ global_id add_global(type_id type, attribute_list attributes, name_id name) {
 	globals[index].sets_count = 0;
 	globals[index].usage      = 0;
 	globals_size += 1;
+
+	index_global(index);
+
 	return index;
 }
 
 global_id add_global_with_value(type_id type, attribute_list attributes, name_id name, global_value value) {
+	debug_context context = {0};
+	check(globals_size < sizeof(globals) / sizeof(globals[0]), context, "Too many globals");
+
 	uint32_t index            = globals_size;
 	globals[index].name       = name;
 	globals[index].type       = type;
@@ -180,6 +217,9 @@ global_id add_global_with_value(type_id type, attribute_list attributes, name_id
 	globals[index].sets_count = 0;
 	globals[index].usage      = 0;
 	globals_size += 1;
+
+	index_global(index);
+
 	return index;
 }
 
@@ -188,13 +228,8 @@ bool global_has_usage(global_id g, global_usage usage) {
 }
 
 global *find_global(name_id name) {
-	for (uint32_t i = 0; i < globals_size; ++i) {
-		if (globals[i].name == name) {
-			return &globals[i];
-		}
-	}
-
-	return NULL;
+	uint32_t g = name_map_get(&globals_by_name, name);
+	return g == NAME_MAP_NOT_FOUND ? NULL : &globals[g];
 }
 
 global *get_global(global_id id) {
@@ -59,6 +59,8 @@ typedef struct global_array {
 } global_array;
 
 void globals_init(void);
+void globals_snapshot(void);
+void globals_restore(void);
 
 global_id add_global(type_id type, attribute_list attributes, name_id name);
 global_id add_global_with_value(type_id type, attribute_list attributes, name_id name, global_value value);
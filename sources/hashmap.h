@@ -66,7 +66,36 @@ static inline struct hash_map *hash_map_create(void) {
 	return map;
 }
 
-static inline void hash_map_destroy(struct hash_map *map) {}
+static inline void hash_map_free_bucket(struct bucket *bucket) {
+	if (bucket->meta.c) {
+		hash_map_free_bucket((struct bucket *)bucket->entries[6]);
+	}
+#ifdef _WIN32
+	_aligned_free(bucket);
+#else
+	free(bucket);
+#endif
+}
+
+// frees the map and its overflow buckets, the entries belong to the caller
+static inline void hash_map_destroy(struct hash_map *map) {
+	if (map == NULL) {
+		return;
+	}
+
+	for (uint32_t bucket_index = 0; bucket_index < HASH_MAP_SIZE; ++bucket_index) {
+		struct bucket *bucket = &map->buckets[bucket_index];
+		if (bucket->meta.c) {
+			hash_map_free_bucket((struct bucket *)bucket->entries[6]);
+		}
+	}
+
+#ifdef _WIN32
+	_aligned_free(map);
+#else
+	free(map);
+#endif
+}
 
 static inline void hash_map_add_to_bucket(struct bucket *bucket, struct container *value, uint8_t secondary_hash) {
 	for (uint32_t index = 0; index < 7; ++index) {
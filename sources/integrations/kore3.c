@@ -600,7 +600,7 @@ static void format_to_string_wgsl(texture_format format, char *str) {
 	}
 }
 
-static int global_register_indices[512];
+static int global_register_indices[1024];
 
 void kore3_export(char *directory, api_kind api) {
 	for (function_id i = 0; get_function(i) != NULL; ++i) {
@@ -0,0 +1,482 @@
+#include "ir.h"
+
+#include "errors.h"
+
+#include "libs/stb_ds.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void ir_operands_of(opcode *o, ir_operands *operands) {
+	operands->definitions_size = 0;
+	operands->uses_size        = 0;
+
+#define DEFINE(v) operands->definitions[operands->definitions_size++] = &(v)
+#define USE(v) operands->uses[operands->uses_size++] = &(v)
+
+	switch (o->type) {
+	case OPCODE_NOT:
+		USE(o->op_not.from);
+		DEFINE(o->op_not.to);
+		break;
+	case OPCODE_NEGATE:
+		USE(o->op_negate.from);
+		DEFINE(o->op_negate.to);
+		break;
+	case OPCODE_STORE_VARIABLE:
+		USE(o->op_store_var.from);
+		DEFINE(o->op_store_var.to);
+		break;
+	case OPCODE_SUB_AND_STORE_VARIABLE:
+	case OPCODE_ADD_AND_STORE_VARIABLE:
+	case OPCODE_DIVIDE_AND_STORE_VARIABLE:
+	case OPCODE_MULTIPLY_AND_STORE_VARIABLE:
+		USE(o->op_store_var.from);
+		USE(o->op_store_var.to);
+		DEFINE(o->op_store_var.to);
+		break;
+	case OPCODE_STORE_ACCESS_LIST:
+	case OPCODE_SUB_AND_STORE_ACCESS_LIST:
+	case OPCODE_ADD_AND_STORE_ACCESS_LIST:
+	case OPCODE_DIVIDE_AND_STORE_ACCESS_LIST:
+	case OPCODE_MULTIPLY_AND_STORE_ACCESS_LIST:
+		USE(o->op_store_access_list.from);
+		for (uint8_t access_index = 0; access_index < o->op_store_access_list.access_list_size; ++access_index) {
+			if (o->op_store_access_list.access_list[access_index].kind == ACCESS_ELEMENT) {
+				USE(o->op_store_access_list.access_list[access_index].access_element.index);
+			}
+		}
+		// only a part of the target is written
+		USE(o->op_store_access_list.to);
+		DEFINE(o->op_store_access_list.to);
+		break;
+	case OPCODE_LOAD_FLOAT_CONSTANT:
+		DEFINE(o->op_load_float_constant.to);
+		break;
+	case OPCODE_LOAD_INT_CONSTANT:
+		DEFINE(o->op_load_int_constant.to);
+		break;
+	case OPCODE_LOAD_BOOL_CONSTANT:
+		DEFINE(o->op_load_bool_constant.to);
+		break;
+	case OPCODE_LOAD_ACCESS_LIST:
+		USE(o->op_load_access_list.from);
+		for (uint8_t access_index = 0; access_index < o->op_load_access_list.access_list_size; ++access_index) {
+			if (o->op_load_access_list.access_list[access_index].kind == ACCESS_ELEMENT) {
+				USE(o->op_load_access_list.access_list[access_index].access_element.index);
+			}
+		}
+		DEFINE(o->op_load_access_list.to);
+		break;
+	case OPCODE_RETURN:
+		if (o->size > offsetof(opcode, op_return)) {
+			USE(o->op_return.var);
+		}
+		break;
+	case OPCODE_CALL:
+		for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+			USE(o->op_call.parameters[parameter_index]);
+		}
+		if (o->op_call.var.index != 0) {
+			DEFINE(o->op_call.var);
+		}
+		break;
+	case OPCODE_MULTIPLY:
+	case OPCODE_DIVIDE:
+	case OPCODE_MOD:
+	case OPCODE_ADD:
+	case OPCODE_SUB:
+	case OPCODE_EQUALS:
+	case OPCODE_NOT_EQUALS:
+	case OPCODE_GREATER:
+	case OPCODE_GREATER_EQUAL:
+	case OPCODE_LESS:
+	case OPCODE_LESS_EQUAL:
+	case OPCODE_AND:
+	case OPCODE_OR:
+	case OPCODE_BITWISE_XOR:
+	case OPCODE_BITWISE_AND:
+	case OPCODE_BITWISE_OR:
+	case OPCODE_LEFT_SHIFT:
+	case OPCODE_RIGHT_SHIFT:
+		USE(o->op_binary.left);
+		USE(o->op_binary.right);
+		DEFINE(o->op_binary.result);
+		break;
+	case OPCODE_IF:
+		USE(o->op_if.condition);
+		break;
+	case OPCODE_WHILE_CONDITION:
+		USE(o->op_while.condition);
+		break;
+	case OPCODE_VAR:
+	case OPCODE_DISCARD:
+	case OPCODE_WHILE_START:
+	case OPCODE_WHILE_BODY:
+	case OPCODE_WHILE_END:
+	case OPCODE_BLOCK_START:
+	case OPCODE_BLOCK_END:
+		break;
+	}
+
+#undef DEFINE
+#undef USE
+}
+
+opcode *ir_copy_opcode(ir_function *ir, opcode *o) {
+	if (ir->memory == NULL) {
+		ir->memory = arena_create();
+	}
+	opcode *copy = (opcode *)arena_alloc(ir->memory, o->size);
+	memcpy(copy, o, o->size);
+	return copy;
+}
+
+static bool is_label(function *f, uint32_t id) {
+	return id != 0 && id < f->variables_end;
+}
+
+static uint32_t label_target(uint32_t *labels, uint32_t id, size_t instructions_size) {
+	debug_context context = {0};
+	check(labels[id] <= instructions_size, context, "Jump to an unknown label");
+	return labels[id];
+}
+
+bool ir_build(ir_function *ir, function *f) {
+	memset(ir, 0, sizeof(*ir));
+	ir->f    = f;
+	ir->code = (uint8_t *)malloc(f->code.size + 1);
+
+	// label ids are numbered like the variables, an entry is the index of the instruction the label marks
+	uint32_t     *labels  = (uint32_t *)malloc(f->variables_end * sizeof(uint32_t));
+	debug_context context = {0};
+	check(ir->code != NULL && labels != NULL, context, "Could not allocate the ir");
+
+	if (f->code.size > 0) {
+		memcpy(ir->code, f->code.o, f->code.size);
+	}
+	memset(labels, 0xff, f->variables_end * sizeof(uint32_t));
+
+	opcode **instructions = NULL;
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&ir->code[index])->size) {
+		arrput(instructions, (opcode *)&ir->code[index]);
+	}
+	size_t instructions_size = arrlenu(instructions);
+
+	// where the blocks of ifs end and where loops start and end
+	uint32_t *if_ends    = NULL;
+	bool      structured = true;
+	for (size_t index = 0; index < instructions_size; ++index) {
+		opcode *o = instructions[index];
+		switch (o->type) {
+		case OPCODE_IF:
+			if (o->op_if.start_id == 0 || !is_label(f, o->op_if.end_id)) {
+				structured = false;
+			}
+			arrput(if_ends, o->op_if.end_id);
+			break;
+		case OPCODE_BLOCK_END:
+			for (size_t if_index = 0; if_index < arrlenu(if_ends); ++if_index) {
+				if (if_ends[if_index] == o->op_block.id) {
+					labels[o->op_block.id] = (uint32_t)(index + 1);
+					arrdelswap(if_ends, if_index);
+					break;
+				}
+			}
+			break;
+		case OPCODE_WHILE_CONDITION:
+			if (!is_label(f, o->op_while.end_id)) {
+				structured = false;
+			}
+			break;
+		case OPCODE_WHILE_START:
+			if (!is_label(f, o->op_while_start.start_id) || !is_label(f, o->op_while_start.end_id)) {
+				structured = false;
+				break;
+			}
+			labels[o->op_while_start.start_id] = (uint32_t)index;
+			break;
+		case OPCODE_WHILE_END:
+			if (!is_label(f, o->op_while_end.start_id) || !is_label(f, o->op_while_end.end_id)) {
+				structured = false;
+				break;
+			}
+			labels[o->op_while_end.end_id] = (uint32_t)(index + 1);
+			break;
+		default:
+			break;
+		}
+	}
+	if (arrlenu(if_ends) > 0) {
+		structured = false;
+	}
+	arrfree(if_ends);
+
+	if (!structured) {
+		free(labels);
+		arrfree(instructions);
+		free(ir->code);
+		ir->code = NULL;
+		return false;
+	}
+
+	// blocks start at labels and behind branches, a label right behind the last instruction needs an empty block to point to
+	bool *leaders = (bool *)calloc(instructions_size + 1, sizeof(bool));
+	check(leaders != NULL, context, "Could not allocate the ir blocks");
+	leaders[0] = true;
+	for (size_t index = 0; index < instructions_size; ++index) {
+		opcode *o = instructions[index];
+		switch (o->type) {
+		case OPCODE_IF:
+			leaders[index + 1]                                                = true;
+			leaders[label_target(labels, o->op_if.end_id, instructions_size)] = true;
+			break;
+		case OPCODE_WHILE_CONDITION:
+			leaders[index + 1]                                                   = true;
+			leaders[label_target(labels, o->op_while.end_id, instructions_size)] = true;
+			break;
+		case OPCODE_WHILE_END:
+			leaders[index + 1]                                                         = true;
+			leaders[label_target(labels, o->op_while_end.start_id, instructions_size)] = true;
+			break;
+		case OPCODE_RETURN:
+		case OPCODE_DISCARD:
+			leaders[index + 1] = true;
+			break;
+		default:
+			break;
+		}
+	}
+	bool needs_end_block = instructions_size == 0 || leaders[instructions_size];
+
+	uint32_t *block_of_instruction = NULL;
+	arrsetlen(block_of_instruction, instructions_size + 1);
+
+	for (size_t index = 0; index < instructions_size; ++index) {
+		if (leaders[index]) {
+			ir_block block = {0};
+			arrput(ir->blocks, block);
+		}
+		ir_block *block = &ir->blocks[arrlenu(ir->blocks) - 1];
+		arrput(block->instructions, instructions[index]);
+		block_of_instruction[index] = (uint32_t)(arrlenu(ir->blocks) - 1);
+	}
+
+	if (needs_end_block) {
+		ir_block block = {0};
+		arrput(ir->blocks, block);
+	}
+	block_of_instruction[instructions_size] = (uint32_t)(arrlenu(ir->blocks) - 1);
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		opcode   *last  = arrlenu(block->instructions) > 0 ? block->instructions[arrlenu(block->instructions) - 1] : NULL;
+		uint32_t  next  = block_index + 1 < arrlenu(ir->blocks) ? block_index + 1 : IR_NO_BLOCK;
+
+		if (last == NULL) {
+			if (next != IR_NO_BLOCK) {
+				arrput(block->successors, next);
+			}
+			continue;
+		}
+
+		switch (last->type) {
+		case OPCODE_IF:
+			arrput(block->successors, next);
+			arrput(block->successors, block_of_instruction[labels[last->op_if.end_id]]);
+			break;
+		case OPCODE_WHILE_CONDITION:
+			arrput(block->successors, next);
+			arrput(block->successors, block_of_instruction[labels[last->op_while.end_id]]);
+			break;
+		case OPCODE_WHILE_END:
+			arrput(block->successors, block_of_instruction[labels[last->op_while_end.start_id]]);
+			break;
+		case OPCODE_RETURN:
+		case OPCODE_DISCARD:
+			break;
+		default:
+			if (next != IR_NO_BLOCK) {
+				arrput(block->successors, next);
+			}
+			break;
+		}
+	}
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (size_t successor_index = 0; successor_index < arrlenu(block->successors); ++successor_index) {
+			arrput(ir->blocks[block->successors[successor_index]].predecessors, block_index);
+		}
+	}
+
+	free(leaders);
+	arrfree(block_of_instruction);
+	free(labels);
+	arrfree(instructions);
+
+	ir->variables_size = f->variables_end;
+	ir->variables      = (ir_variable *)calloc(ir->variables_size, sizeof(ir_variable));
+	check(ir->variables != NULL || ir->variables_size == 0, context, "Could not allocate the ir variables");
+
+	ir_update(ir);
+
+	return true;
+}
+
+void ir_update(ir_function *ir) {
+	for (uint32_t variable_index = 0; variable_index < ir->variables_size; ++variable_index) {
+		ir->variables[variable_index].definitions_size = 0;
+		ir->variables[variable_index].uses_size        = 0;
+	}
+
+	debug_context context = {0};
+
+	// count first so all locations fit into one array
+	size_t locations_size = 0;
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+
+			for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+				uint32_t index = operands.uses[use_index]->index;
+				check(index < ir->variables_size, context, "Variable index out of range");
+				ir->variables[index].uses_size += 1;
+			}
+
+			for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+				uint32_t index = operands.definitions[definition_index]->index;
+				check(index < ir->variables_size, context, "Variable index out of range");
+				ir->variables[index].definitions_size += 1;
+			}
+
+			locations_size += operands.uses_size + operands.definitions_size;
+		}
+	}
+
+	arrsetlen(ir->locations, locations_size);
+
+	ir_location *next = ir->locations;
+	for (uint32_t variable_index = 0; variable_index < ir->variables_size; ++variable_index) {
+		ir_variable *v      = &ir->variables[variable_index];
+		v->definitions      = next;
+		v->uses             = next + v->definitions_size;
+		next                = v->uses + v->uses_size;
+		v->definitions_size = 0;
+		v->uses_size        = 0;
+	}
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_location location = {
+			    .block       = block_index,
+			    .instruction = instruction_index,
+			};
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+
+			for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+				ir_variable *v          = &ir->variables[operands.uses[use_index]->index];
+				v->uses[v->uses_size++] = location;
+			}
+
+			for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+				ir_variable *v                        = &ir->variables[operands.definitions[definition_index]->index];
+				v->definitions[v->definitions_size++] = location;
+			}
+		}
+	}
+}
+
+void ir_remove(ir_function *ir, ir_location location) {
+	ir->blocks[location.block].instructions[location.instruction] = NULL;
+}
+
+void ir_compact(ir_function *ir) {
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+
+		size_t kept = 0;
+		for (size_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			if (block->instructions[instruction_index] != NULL) {
+				block->instructions[kept] = block->instructions[instruction_index];
+				kept += 1;
+			}
+		}
+		arrsetlen(block->instructions, kept);
+	}
+}
+
+void ir_write(ir_function *ir, opcodes *code) {
+	code->size = 0;
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (size_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o != NULL) {
+				emit_op(code, o);
+			}
+		}
+	}
+}
+
+void ir_free(ir_function *ir) {
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		arrfree(ir->blocks[block_index].instructions);
+		arrfree(ir->blocks[block_index].successors);
+		arrfree(ir->blocks[block_index].predecessors);
+	}
+	arrfree(ir->blocks);
+
+	free(ir->variables);
+	arrfree(ir->locations);
+
+	free(ir->code);
+	if (ir->memory != NULL) {
+		arena_destroy(ir->memory);
+	}
+
+	memset(ir, 0, sizeof(*ir));
+}
+
+void ir_check_round_trip(void) {
+	opcodes written = {0};
+
+	for (function_id i = 0; get_function(i) != NULL; ++i) {
+		function *f = get_function(i);
+		if (f->block == NULL) {
+			continue;
+		}
+
+		ir_function ir;
+		if (!ir_build(&ir, f)) {
+			continue;
+		}
+
+		ir_write(&ir, &written);
+
+		debug_context context = {0};
+		check(written.size == f->code.size && (written.size == 0 || memcmp(written.o, f->code.o, written.size) == 0), context,
+		      "The ir of %s does not round trip", get_name(f->name));
+
+		ir_free(&ir);
+	}
+
+	opcodes_free(&written);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "arena.h"
+#include "compiler.h"
+#include "functions.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The code of a function split into basic blocks with explicit successors and the definitions and uses of every variable. The
+// instructions are copies of the opcodes so they can be changed, inserted or removed and written back with ir_write. Blocks are
+// kept in code order so writing them out one after another gives back the structured opcode stream.
+
+#define IR_NO_BLOCK UINT32_MAX
+
+typedef struct ir_block {
+	opcode  **instructions; // stb_ds array, removed instructions are NULL until ir_compact
+	uint32_t *successors;   // stb_ds array of block indices, for ifs and loop conditions the block entered when the condition holds first
+	uint32_t *predecessors; // stb_ds array of block indices
+} ir_block;
+
+typedef struct ir_location {
+	uint32_t block;
+	uint32_t instruction;
+} ir_location;
+
+typedef struct ir_variable {
+	ir_location *definitions; // stores through access lists and compound assignments are definitions and uses
+	uint32_t     definitions_size;
+	ir_location *uses;
+	uint32_t     uses_size;
+} ir_variable;
+
+typedef struct ir_function {
+	function    *f;
+	uint8_t     *code;   // a copy of the opcodes of the function the instructions start out in
+	arena       *memory; // instructions added later, created on demand
+	ir_block    *blocks;    // stb_ds array
+	ir_variable *variables; // indexed by variable index, globals included
+	uint32_t     variables_size;
+	ir_location *locations; // stb_ds array the definitions and uses of all variables point into
+} ir_function;
+
+// Pointers to the variables an opcode writes and reads so passes can rewrite them in place
+typedef struct ir_operands {
+	variable *definitions[1];
+	uint8_t   definitions_size;
+	variable *uses[68];
+	uint8_t   uses_size;
+} ir_operands;
+
+void ir_operands_of(opcode *o, ir_operands *operands);
+
+// returns false and builds nothing when the control flow can not be followed, like an if without a block
+bool ir_build(ir_function *ir, function *f);
+
+// recomputes the definitions and uses after instructions were changed, changes to the control flow need a new ir_build
+void ir_update(ir_function *ir);
+
+// allocates an instruction that lives as long as the ir
+opcode *ir_copy_opcode(ir_function *ir, opcode *o);
+
+void ir_remove(ir_function *ir, ir_location location);
+
+// drops removed instructions, locations are invalid afterwards until ir_update
+void ir_compact(ir_function *ir);
+
+void ir_write(ir_function *ir, opcodes *code);
+
+void ir_free(ir_function *ir);
+
+// builds the ir of every function and checks that writing it back reproduces the code
+void ir_check_round_trip(void);
@@ -0,0 +1,185 @@
+#include "jobs.h"
+
+#include "errors.h"
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+
+#include <intrin.h>
+
+typedef unsigned long(__stdcall *LPTHREAD_START_ROUTINE)(void *lpThreadParameter);
+
+__declspec(dllimport) void *__stdcall CreateThread(void *lpThreadAttributes, size_t dwStackSize, LPTHREAD_START_ROUTINE lpStartAddress, void *lpParameter,
+                                                   unsigned long dwCreationFlags, unsigned long *lpThreadId);
+
+__declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+
+__declspec(dllimport) int __stdcall CloseHandle(void *hObject);
+
+__declspec(dllimport) void __stdcall AcquireSRWLockExclusive(void **SRWLock);
+
+__declspec(dllimport) void __stdcall ReleaseSRWLockExclusive(void **SRWLock);
+
+#ifndef INFINITE
+#define INFINITE 0xFFFFFFFF
+#endif
+
+#else
+
+#include <pthread.h>
+
+#endif
+
+#define MAX_THREADS 256
+
+static uint32_t threads_count = 1;
+
+void jobs_init(uint32_t count) {
+	threads_count = count < 1 ? 1 : (count > MAX_THREADS ? MAX_THREADS : count);
+}
+
+uint32_t jobs_threads_count(void) {
+	return threads_count;
+}
+
+#ifdef _WIN32
+static void *lock = NULL; // SRWLOCK_INIT
+#else
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void jobs_lock(void) {
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&lock);
+#else
+	pthread_mutex_lock(&lock);
+#endif
+}
+
+void jobs_unlock(void) {
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&lock);
+#else
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+typedef struct job_queue {
+	job_func func;
+	void    *data;
+	size_t   count;
+	long     next;
+	long     failed;
+} job_queue;
+
+static size_t take_job(job_queue *queue) {
+#ifdef _WIN32
+	return (size_t)(_InterlockedIncrement(&queue->next) - 1);
+#else
+	return (size_t)__atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static bool has_failed(job_queue *queue) {
+#ifdef _WIN32
+	return *(volatile long *)&queue->failed != 0;
+#else
+	return __atomic_load_n(&queue->failed, __ATOMIC_RELAXED) != 0;
+#endif
+}
+
+static void set_failed(job_queue *queue) {
+#ifdef _WIN32
+	_InterlockedExchange(&queue->failed, 1);
+#else
+	__atomic_store_n(&queue->failed, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+// An error in a job is already logged when it gets here. The queue is drained and the caller of jobs_run fails once all threads
+// are done - jumping out of a job directly would leave the other threads working on a queue that is gone.
+static void work(job_queue *queue) {
+	jmp_buf  recovery;
+	jmp_buf *previous_recovery = set_error_recovery(&recovery);
+
+	if (setjmp(recovery) == 0) {
+		for (size_t index = take_job(queue); index < queue->count && !has_failed(queue); index = take_job(queue)) {
+			queue->func(queue->data, index);
+		}
+	}
+	else {
+		set_failed(queue);
+	}
+
+	set_error_recovery(previous_recovery);
+}
+
+#ifdef _WIN32
+static unsigned long __stdcall worker(void *parameter) {
+	work((job_queue *)parameter);
+	return 0;
+}
+#else
+static void *worker(void *parameter) {
+	work((job_queue *)parameter);
+	return NULL;
+}
+#endif
+
+void jobs_run(job_func func, void *data, size_t count) {
+	job_queue queue = {
+	    .func   = func,
+	    .data   = data,
+	    .count  = count,
+	    .next   = 0,
+	    .failed = 0,
+	};
+
+	uint32_t workers_count = threads_count;
+	if (workers_count > count) {
+		workers_count = (uint32_t)count;
+	}
+
+	if (workers_count <= 1) {
+		work(&queue);
+		if (queue.failed) {
+			error_reported();
+		}
+		return;
+	}
+
+	debug_context context = {0};
+
+	// the calling thread works the queue, too
+#ifdef _WIN32
+	void *threads[MAX_THREADS];
+	for (uint32_t i = 0; i < workers_count - 1; ++i) {
+		threads[i] = CreateThread(NULL, 0, worker, &queue, 0, NULL);
+		check(threads[i] != NULL, context, "Could not create job thread");
+	}
+
+	work(&queue);
+
+	for (uint32_t i = 0; i < workers_count - 1; ++i) {
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+	}
+#else
+	pthread_t threads[MAX_THREADS];
+	for (uint32_t i = 0; i < workers_count - 1; ++i) {
+		int result = pthread_create(&threads[i], NULL, worker, &queue);
+		check(result == 0, context, "Could not create job thread");
+	}
+
+	work(&queue);
+
+	for (uint32_t i = 0; i < workers_count - 1; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+#endif
+
+	if (queue.failed) {
+		error_reported();
+	}
+}
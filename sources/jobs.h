@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#define KONG_THREAD_LOCAL __declspec(thread)
+#else
+#define KONG_THREAD_LOCAL _Thread_local
+#endif
+
+typedef void (*job_func)(void *data, size_t index);
+
+void jobs_init(uint32_t threads_count);
+
+uint32_t jobs_threads_count(void);
+
+// guards the few shared tables jobs still write to (like the hlsl payload types)
+void jobs_lock(void);
+
+void jobs_unlock(void);
+
+// runs func for every index in [0, count) and returns when all of them are done
+void jobs_run(job_func func, void *data, size_t count);
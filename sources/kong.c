@@ -1,12 +1,17 @@
 #include "analyzer.h"
+#include "cache.h"
 #include "compiler.h"
 #include "disasm.h"
 #include "errors.h"
 #include "functions.h"
 #include "globals.h"
+#include "ir.h"
+#include "jobs.h"
+#include "kong.h"
 #include "log.h"
 #include "names.h"
 #include "parser.h"
+#include "sets.h"
 #include "tokenizer.h"
 #include "transformer.h"
 #include "typer.h"
@@ -24,60 +29,152 @@
 
 #include "dir.h"
 
+#include "libs/stb_ds.h"
+
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef enum arg_mode { MODE_MODECHECK, MODE_INPUT, MODE_OUTPUT, MODE_PLATFORM, MODE_API, MODE_INTEGRATION } arg_mode;
+#ifdef _WIN32
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(int64_t *lpPerformanceCount);
+
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(int64_t *lpFrequency);
+#else
+#include <time.h>
+#endif
+
+typedef enum arg_mode { MODE_MODECHECK, MODE_INPUT, MODE_OUTPUT, MODE_PLATFORM, MODE_API, MODE_INTEGRATION, MODE_JOBS } arg_mode;
 
 static void help(void) {
-	printf("No help is coming.");
+	printf("Usage: kongruent -i <directory> -o <directory> -p <platform> [options]\n"
+	       "\n"
+	       "  -i, --in <directory>           adds a directory of .kong files, can be used several times\n"
+	       "  -o, --out <directory>          the directory the generated code is written to\n"
+	       "  -p, --platform <platform>      windows, macos, linux, ios, android, wasm or kompjuta\n"
+	       "  -a, --api <api>                direct3d11, direct3d12, opengl, metal, webgpu, vulkan or default\n"
+	       "  -n, --integration <name>       the engine integration to write, only kore3 so far\n"
+	       "  -j, --jobs <count>             tokenizes, lowers and exports on that many threads\n"
+	       "      --cache                    only exports the entry points that changed since the last run\n"
+	       "      --debug                    writes debug output and validates it where a validator is installed\n"
+	       "      --serve                    reads one command line per line from stdin and answers each with done 0 or done 1,\n"
+	       "                                 quit ends it\n"
+	       "      --no-optimize              skips inlining, constant folding and the other optimization passes\n"
+	       "      --spirv-ssa                keeps Vulkan locals in SSA values instead of variables, not validated yet\n"
+	       "      --timings                  logs how long every phase took\n"
+	       "      --stats                    logs the size of the code and of every entry point between the phases\n"
+	       "  -h, --help                     prints this\n");
 }
 
-static void read_file(char *filename) {
-	FILE *file = fopen(filename, "rb");
+typedef struct source_file {
+	char        path[1024];
+	mapped_file mapped;
+	tokens      tokens;
+} source_file;
+
+static void tokenize_job(void *data, size_t index) {
+	source_file *file = &((source_file *)data)[index];
+	file->tokens      = tokenize(file->path, file->mapped.data, file->mapped.size);
+}
 
-	if (file == NULL) {
-		kong_log(LOG_LEVEL_ERROR, "File %s not found.", filename);
-		exit(1);
+// Files are tokenized in parallel but parsed one after another in directory order so definitions are always registered in the same order
+static void read_files(source_file *files, size_t files_count) {
+	for (size_t i = 0; i < files_count; ++i) {
+		if (!map_file(files[i].path, &files[i].mapped)) {
+			error_no_context("File %s not found.", files[i].path);
+		}
 	}
 
-	fseek(file, 0, SEEK_END);
-	size_t size = ftell(file);
-	fseek(file, 0, SEEK_SET);
+	jobs_run(tokenize_job, files, files_count);
 
-	char *data = (char *)malloc(size + 1);
+	for (size_t i = 0; i < files_count; ++i) {
+		parse(files[i].path, &files[i].tokens);
 
-	debug_context context = {0};
-	context.filename      = filename;
-	check(data != NULL, context, "Could not allocate memory to read file %s", filename);
+		free(files[i].tokens.t);
+		unmap_file(&files[i].mapped);
+	}
+}
 
-	fread(data, 1, size, file);
-	data[size] = 0;
+// Functions only read the allocated globals and number their variables on their own, so they can be lowered in any order
+static void compile_job(void *data, size_t index) {
+	compile_function(get_function((function_id)index));
+}
 
-	fclose(file);
+static double milliseconds(void) {
+#ifdef _WIN32
+	int64_t counter;
+	int64_t frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter * 1000.0 / (double)frequency;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1000000.0;
+#endif
+}
 
-	tokens tokens = tokenize(filename, data);
+static void log_code_stats(const char *phase) {
+	size_t functions_count = 0;
+	size_t opcodes_count   = 0;
+	size_t size            = 0;
+	size_t capacity        = 0;
 
-	free(data);
+	for (function_id i = 0; get_function(i) != NULL; ++i) {
+		function *f = get_function(i);
+		if (f->block == NULL) {
+			continue;
+		}
+
+		functions_count += 1;
+		size += f->code.size;
+		capacity += f->code.capacity;
+
+		for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+			opcodes_count += 1;
+		}
+	}
 
-	parse(filename, &tokens);
+	kong_log(LOG_LEVEL_INFO, "Code %s: %zu functions, %zu opcodes, %zu bytes (%.1f per opcode), %zu bytes allocated", phase, functions_count, opcodes_count,
+	         size, opcodes_count > 0 ? (double)size / (double)opcodes_count : 0.0, capacity);
 }
 
-typedef enum integration_kind { INTEGRATION_KORE3 } integration_kind;
+static void log_entry_point_stats(const char *phase) {
+	function *entry_points[1024];
+	size_t    entry_points_size = 0;
+	find_entry_points(entry_points, &entry_points_size);
+
+	for (size_t entry_point_index = 0; entry_point_index < entry_points_size; ++entry_point_index) {
+		function *functions[256];
+		size_t    functions_size = 1;
+		functions[0]             = entry_points[entry_point_index];
+		find_referenced_functions(functions[0], functions, &functions_size);
+
+		size_t opcodes_count = 0;
+		size_t size          = 0;
+		for (size_t function_index = 0; function_index < functions_size; ++function_index) {
+			function *f = functions[function_index];
+			size += f->code.size;
+			for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+				opcodes_count += 1;
+			}
+		}
 
-int main(int argc, char **argv) {
-	arg_mode mode = MODE_MODECHECK;
+		kong_log(LOG_LEVEL_INFO, "Entry point %s %s: %zu functions, %zu opcodes, %zu bytes", get_name(functions[0]->name), phase, functions_size,
+		         opcodes_count, size);
+	}
+}
+
+void kong_init_options(kong_options *options) {
+	memset(options, 0, sizeof(*options));
+	options->api         = API_DEFAULT;
+	options->integration = INTEGRATION_KORE3;
+	options->jobs        = 1;
+}
 
-	char            *inputs[256] = {0};
-	size_t           inputs_size = 0;
-	char            *platform    = NULL;
-	api_kind         api         = API_DEFAULT;
-	integration_kind integration = INTEGRATION_KORE3;
-	bool             debug       = false;
-	char            *output      = NULL;
+static void parse_arguments(int argc, char **argv, kong_options *options) {
+	arg_mode mode = MODE_MODECHECK;
 
 	for (int i = 1; i < argc; ++i) {
 		char *arg = argv[i];
@@ -100,12 +197,32 @@ int main(int argc, char **argv) {
 					else if (strcmp(&arg[2], "integration") == 0) {
 						mode = MODE_INTEGRATION;
 					}
+					else if (strcmp(&arg[2], "jobs") == 0) {
+						mode = MODE_JOBS;
+					}
+					else if (strcmp(&arg[2], "cache") == 0) {
+						options->cache = true;
+					}
+					else if (strcmp(&arg[2], "serve") == 0) {
+						options->serve = true;
+					}
+					else if (strcmp(&arg[2], "timings") == 0) {
+						options->timings = true;
+					}
+					else if (strcmp(&arg[2], "stats") == 0) {
+						options->stats = true;
+					}
+					else if (strcmp(&arg[2], "no-optimize") == 0) {
+						options->no_optimize = true;
+					}
+					else if (strcmp(&arg[2], "spirv-ssa") == 0) {
+						options->spirv_ssa = true;
+					}
 					else if (strcmp(&arg[2], "debug") == 0) {
-						debug = true;
+						options->debug = true;
 					}
 					else if (strcmp(&arg[2], "help") == 0) {
-						help();
-						return 0;
+						options->help = true;
 					}
 					else {
 						kong_log(LOG_LEVEL_WARNING, "Ignoring unknown parameter %s", arg);
@@ -141,9 +258,12 @@ int main(int argc, char **argv) {
 						case 'n':
 							mode = MODE_INTEGRATION;
 							break;
+						case 'j':
+							mode = MODE_JOBS;
+							break;
 						case 'h':
-							help();
-							return 0;
+							options->help = true;
+							break;
 						default: {
 							kong_log(LOG_LEVEL_WARNING, "Ignoring unknown parameter %s.", arg);
 						}
@@ -157,42 +277,44 @@ int main(int argc, char **argv) {
 			break;
 		}
 		case MODE_INPUT: {
-			inputs[inputs_size] = arg;
-			inputs_size += 1;
+			debug_context context = {0};
+			check(options->inputs_size < sizeof(options->inputs) / sizeof(options->inputs[0]), context, "Too many input parameters");
+			options->inputs[options->inputs_size] = arg;
+			options->inputs_size += 1;
 			mode = MODE_MODECHECK;
 			break;
 		}
 		case MODE_OUTPUT: {
-			output = arg;
-			mode   = MODE_MODECHECK;
+			options->output = arg;
+			mode            = MODE_MODECHECK;
 			break;
 		}
 		case MODE_PLATFORM: {
-			platform = arg;
-			mode     = MODE_MODECHECK;
+			options->platform = arg;
+			mode              = MODE_MODECHECK;
 			break;
 		}
 		case MODE_API: {
 			if (strcmp(arg, "direct3d11") == 0) {
-				api = API_DIRECT3D11;
+				options->api = API_DIRECT3D11;
 			}
 			else if (strcmp(arg, "direct3d12") == 0) {
-				api = API_DIRECT3D12;
+				options->api = API_DIRECT3D12;
 			}
 			else if (strcmp(arg, "opengl") == 0) {
-				api = API_OPENGL;
+				options->api = API_OPENGL;
 			}
 			else if (strcmp(arg, "metal") == 0) {
-				api = API_METAL;
+				options->api = API_METAL;
 			}
 			else if (strcmp(arg, "webgpu") == 0) {
-				api = API_WEBGPU;
+				options->api = API_WEBGPU;
 			}
 			else if (strcmp(arg, "vulkan") == 0) {
-				api = API_VULKAN;
+				options->api = API_VULKAN;
 			}
 			else if (strcmp(arg, "default") == 0) {
-				api = API_DEFAULT;
+				options->api = API_DEFAULT;
 			}
 			else {
 				debug_context context = {0};
@@ -203,7 +325,7 @@ int main(int argc, char **argv) {
 		}
 		case MODE_INTEGRATION: {
 			if (strcmp(arg, "kore3") == 0) {
-				integration = INTEGRATION_KORE3;
+				options->integration = INTEGRATION_KORE3;
 			}
 			else {
 				debug_context context = {0};
@@ -212,11 +334,50 @@ int main(int argc, char **argv) {
 			mode = MODE_MODECHECK;
 			break;
 		}
+		case MODE_JOBS: {
+			int count = atoi(arg);
+			if (count < 1) {
+				debug_context context = {0};
+				error(context, "Invalid job count %s", arg);
+			}
+			options->jobs = (uint32_t)count;
+			mode          = MODE_MODECHECK;
+			break;
 		}
+		}
+	}
+
+	debug_context context = {0};
+	check(mode == MODE_MODECHECK, context, "Wrong parameter syntax");
+}
+
+bool kong_parse_arguments(int argc, char **argv, kong_options *options) {
+	jmp_buf recovery;
+	if (setjmp(recovery) != 0) {
+		set_error_recovery(NULL);
+		return false;
 	}
+	set_error_recovery(&recovery);
+
+	parse_arguments(argc, argv, options);
+
+	set_error_recovery(NULL);
+	return true;
+}
+
+static void init_builtins(void) {
+	names_init();
+	types_init();
+	functions_init();
+	globals_init();
+}
 
+static void compile(kong_options *options) {
 	debug_context context = {0};
-	check(platform != NULL, context, "platform parameter not found");
+	check(options->platform != NULL, context, "platform parameter not found");
+
+	api_kind api      = options->api;
+	char    *platform = options->platform;
 
 	if (api == API_DEFAULT) {
 		if (strcmp(platform, "windows") == 0) {
@@ -242,30 +403,36 @@ int main(int argc, char **argv) {
 		}
 	}
 
-	check(mode == MODE_MODECHECK, context, "Wrong parameter syntax");
-	check(inputs_size > 0, context, "no input parameters found");
+	char *output = options->output;
+
+	check(options->inputs_size > 0, context, "no input parameters found");
 	check(output != NULL, context, "output parameter not found");
 	check(api != API_DEFAULT, context, "api parameter not found");
 
-	names_init();
-	types_init();
-	functions_init();
-	globals_init();
+	jobs_init(options->jobs);
+
+	double start_time = milliseconds();
+
+	if (options->cache) {
+		cache_init(output, api, options->debug, options->spirv_ssa);
+	}
+
+	source_file *files = NULL;
 
-	for (size_t i = 0; i < inputs_size; ++i) {
-		directory dir = open_dir(inputs[i]);
+	for (size_t i = 0; i < options->inputs_size; ++i) {
+		directory dir = open_dir(options->inputs[i]);
 
 		file f = read_next_file(&dir);
 		while (f.valid) {
-			char path[1024];
-			strcpy(path, inputs[i]);
-			strcat(path, "/");
-			strcat(path, f.name);
+			source_file source = {0};
+			strcpy(source.path, options->inputs[i]);
+			strcat(source.path, "/");
+			strcat(source.path, f.name);
 
-			size_t length         = strlen(path);
+			size_t length         = strlen(source.path);
 			size_t dotkong_length = strlen(".kong");
-			if (length > dotkong_length && strcmp(&path[length - dotkong_length], ".kong") == 0) {
-				read_file(path);
+			if (length > dotkong_length && strcmp(&source.path[length - dotkong_length], ".kong") == 0) {
+				arrput(files, source);
 			}
 
 			f = read_next_file(&dir);
@@ -274,6 +441,9 @@ int main(int argc, char **argv) {
 		close_dir(&dir);
 	}
 
+	read_files(files, arrlen(files));
+	arrfree(files);
+
 #ifndef NDEBUG
 	kong_log(LOG_LEVEL_INFO, "Functions:");
 	for (function_id i = 0; get_function(i) != NULL; ++i) {
@@ -288,26 +458,62 @@ int main(int argc, char **argv) {
 	kong_log(LOG_LEVEL_INFO, "");
 #endif
 
+	double parse_time = milliseconds();
+
 	resolve_types();
 
+	double types_time = milliseconds();
+
 	allocate_globals();
-	for (function_id i = 0; get_function(i) != NULL; ++i) {
-		compile_function_block(&get_function(i)->code, get_function(i)->block);
+
+	function_id functions_count = 0;
+	while (get_function(functions_count) != NULL) {
+		++functions_count;
 	}
+	jobs_run(compile_job, NULL, functions_count);
+
+	double compile_time = milliseconds();
+
+	if (options->stats) {
+		log_code_stats("after lowering");
+	}
+
+#ifndef NDEBUG
+	ir_check_round_trip();
+#endif
 
 	analyze();
 
+	if (options->stats) {
+		log_entry_point_stats("before transforming");
+	}
+
+	uint32_t transform_flags;
 	switch (api) {
 	case API_VULKAN:
-		transform(TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE | TRANSFORM_FLAG_BINARY_UNIFY_LENGTH);
+		transform_flags = TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE | TRANSFORM_FLAG_BINARY_UNIFY_LENGTH | TRANSFORM_FLAG_SWIZZLE_STORES | TRANSFORM_FLAGS_OPTIMIZE;
 		break;
 	case API_WEBGPU:
-		transform(TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE);
+		transform_flags = TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE | TRANSFORM_FLAGS_OPTIMIZE;
 		break;
 	default:
+		transform_flags = TRANSFORM_FLAGS_OPTIMIZE & ~TRANSFORM_FLAG_FUSE_COMPONENTS;
 		break;
 	}
 
+	if (options->no_optimize) {
+		transform_flags &= ~TRANSFORM_FLAGS_OPTIMIZE;
+	}
+
+	transform(transform_flags);
+
+	double analyze_time = milliseconds();
+
+	if (options->stats) {
+		log_code_stats("after transforming");
+		log_entry_point_stats("after transforming");
+	}
+
 #ifndef NDEBUG
 	disassemble();
 #endif
@@ -315,7 +521,7 @@ int main(int argc, char **argv) {
 	switch (api) {
 	case API_DIRECT3D11:
 	case API_DIRECT3D12:
-		hlsl_export(output, api, debug);
+		hlsl_export(output, api, options->debug);
 		break;
 	case API_OPENGL:
 		glsl_export(output);
@@ -327,7 +533,7 @@ int main(int argc, char **argv) {
 		wgsl_export(output);
 		break;
 	case API_VULKAN:
-		spirv_export(output, debug);
+		spirv_export(output, options->debug, options->spirv_ssa);
 		break;
 	case API_KOMPJUTA:
 		kompjuta_export(output);
@@ -338,13 +544,168 @@ int main(int argc, char **argv) {
 	}
 	}
 
+	cache_save();
+
 	cpu_export(output);
 
-	switch (integration) {
+	switch (options->integration) {
 	case INTEGRATION_KORE3:
 		kore3_export(output, api);
 		break;
 	}
 
+	if (options->timings) {
+		double end_time = milliseconds();
+		kong_log(LOG_LEVEL_INFO, "Timings with %u jobs:", jobs_threads_count());
+		kong_log(LOG_LEVEL_INFO, "  read and parse:      %9.2f ms", parse_time - start_time);
+		kong_log(LOG_LEVEL_INFO, "  resolve types:       %9.2f ms", types_time - parse_time);
+		kong_log(LOG_LEVEL_INFO, "  globals and compile: %9.2f ms", compile_time - types_time);
+		kong_log(LOG_LEVEL_INFO, "  analyze, transform:  %9.2f ms", analyze_time - compile_time);
+		kong_log(LOG_LEVEL_INFO, "  export:              %9.2f ms", end_time - analyze_time);
+		kong_log(LOG_LEVEL_INFO, "  total:               %9.2f ms", end_time - start_time);
+	}
+}
+
+struct kong_context {
+	bool dirty;
+};
+
+static bool context_created = false;
+
+kong_context *kong_create(void) {
+	debug_context context = {0};
+	check(!context_created, context, "Only one kong context can exist at a time");
+	context_created = true;
+
+	init_builtins();
+
+	types_snapshot();
+	functions_snapshot();
+	globals_snapshot();
+
+	kong_context *kong = (kong_context *)calloc(1, sizeof(kong_context));
+	check(kong != NULL, context, "Could not allocate kong context");
+	return kong;
+}
+
+// names are kept, they are only an interning table and stay valid
+void kong_reset(kong_context *context) {
+	types_restore();
+	functions_restore();
+	globals_restore();
+	sets_reset();
+	compiler_reset();
+	parser_reset();
+	analyzer_reset();
+
+	context->dirty = false;
+}
+
+bool kong_compile(kong_context *context, kong_options *options) {
+	if (context->dirty) {
+		kong_reset(context);
+	}
+	context->dirty = true;
+
+	jmp_buf recovery;
+	if (setjmp(recovery) != 0) {
+		set_error_recovery(NULL);
+		return false;
+	}
+	set_error_recovery(&recovery);
+
+	compile(options);
+
+	set_error_recovery(NULL);
+	return true;
+}
+
+void kong_destroy(kong_context *context) {
+	free(context);
+	context_created = false;
+}
+
+#ifndef KONG_LIBRARY
+
+// Reads one command line per line from stdin and answers each one with "done 0" or "done 1" after its log output
+static int serve(void) {
+	kong_context *context = kong_create();
+
+	char line[4096];
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		char *argv[512];
+		int   argc = 0;
+
+		argv[argc++] = "kongruent";
+
+		char *current = line;
+		while (*current != 0 && argc < 512) {
+			while (*current == ' ' || *current == '\t' || *current == '\r' || *current == '\n') {
+				++current;
+			}
+			if (*current == 0) {
+				break;
+			}
+
+			if (*current == '"') {
+				++current;
+				argv[argc++] = current;
+				while (*current != 0 && *current != '"') {
+					++current;
+				}
+			}
+			else {
+				argv[argc++] = current;
+				while (*current != 0 && *current != ' ' && *current != '\t' && *current != '\r' && *current != '\n') {
+					++current;
+				}
+			}
+
+			if (*current != 0) {
+				*current = 0;
+				++current;
+			}
+		}
+
+		if (argc == 2 && strcmp(argv[1], "quit") == 0) {
+			break;
+		}
+
+		kong_options options;
+		kong_init_options(&options);
+
+		bool success = kong_parse_arguments(argc, argv, &options) && kong_compile(context, &options);
+
+		fflush(stderr);
+		printf("done %i\n", success ? 0 : 1);
+		fflush(stdout);
+	}
+
+	kong_destroy(context);
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	kong_options options;
+	kong_init_options(&options);
+
+	parse_arguments(argc, argv, &options);
+
+	if (options.help) {
+		help();
+		return 0;
+	}
+
+	if (options.serve) {
+		return serve();
+	}
+
+	init_builtins();
+
+	compile(&options);
+
 	return 0;
 }
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "api.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum integration_kind { INTEGRATION_KORE3 } integration_kind;
+
+typedef struct kong_options {
+	char            *inputs[256];
+	size_t           inputs_size;
+	char            *platform;
+	api_kind         api;
+	integration_kind integration;
+	bool             debug;
+	char            *output;
+	uint32_t         jobs;
+	bool             cache;
+	bool             serve;
+	bool             timings;
+	bool             stats;
+	bool             no_optimize;
+	bool             spirv_ssa;
+	bool             help;
+} kong_options;
+
+void kong_init_options(kong_options *options);
+
+// parses the command line syntax of the kongruent executable, argv[0] is skipped
+bool kong_parse_arguments(int argc, char **argv, kong_options *options);
+
+// The compiler state is process-global so there can only be one context at a time. The built-in types,
+// functions and globals are set up once in kong_create and every compile starts from that snapshot.
+typedef struct kong_context kong_context;
+
+kong_context *kong_create(void);
+
+void kong_reset(kong_context *context);
+
+// errors are reported via the log and make kong_compile return false instead of exiting the process
+bool kong_compile(kong_context *context, kong_options *options);
+
+void kong_destroy(kong_context *context);
+
+#ifdef __cplusplus
+}
+#endif
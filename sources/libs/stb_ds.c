@@ -1,3 +1,6 @@
+#include "../jobs.h"
+
 #define STB_DS_IMPLEMENTATION
+#define STBDS_THREAD_LOCAL KONG_THREAD_LOCAL
 
 #include "stb_ds.h"
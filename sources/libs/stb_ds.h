@@ -846,7 +846,11 @@ typedef struct
 #define STBDS_HASH_EMPTY      0
 #define STBDS_HASH_DELETED    1
 
-static size_t stbds_hash_seed=0x31415926;
+#ifndef STBDS_THREAD_LOCAL
+#define STBDS_THREAD_LOCAL
+#endif
+
+static STBDS_THREAD_LOCAL size_t stbds_hash_seed=0x31415926;
 
 void stbds_rand_seed(size_t seed)
 {
@@ -0,0 +1,85 @@
+#include "name_map.h"
+
+#include "errors.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t hash_name_id(name_id name) {
+	uint64_t hash = (uint64_t)name * 0x9E3779B97F4A7C15ull;
+	return (uint32_t)(hash >> 32);
+}
+
+static void insert(name_map *map, name_id name, uint32_t value) {
+	uint32_t mask = map->capacity - 1;
+	for (uint32_t index = hash_name_id(name) & mask;; index = (index + 1) & mask) {
+		if (map->keys[index] == name) {
+			map->values[index] = value;
+			return;
+		}
+		if (map->keys[index] == NO_NAME) {
+			map->keys[index]   = name;
+			map->values[index] = value;
+			map->count += 1;
+			return;
+		}
+	}
+}
+
+static void grow(name_map *map) {
+	name_id  *old_keys     = map->keys;
+	uint32_t *old_values   = map->values;
+	uint32_t  old_capacity = map->capacity;
+
+	map->capacity = old_capacity == 0 ? 64 : old_capacity * 2;
+	map->keys     = (name_id *)calloc(map->capacity, sizeof(name_id));
+	map->values   = (uint32_t *)malloc(map->capacity * sizeof(uint32_t));
+	map->count    = 0;
+
+	debug_context context = {0};
+	check(map->keys != NULL && map->values != NULL, context, "Could not allocate a name map");
+
+	for (uint32_t index = 0; index < old_capacity; ++index) {
+		if (old_keys[index] != NO_NAME) {
+			insert(map, old_keys[index], old_values[index]);
+		}
+	}
+
+	free(old_keys);
+	free(old_values);
+}
+
+uint32_t name_map_get(name_map *map, name_id name) {
+	if (map->capacity == 0 || name == NO_NAME) {
+		return NAME_MAP_NOT_FOUND;
+	}
+
+	uint32_t mask = map->capacity - 1;
+	for (uint32_t index = hash_name_id(name) & mask;; index = (index + 1) & mask) {
+		if (map->keys[index] == name) {
+			return map->values[index];
+		}
+		if (map->keys[index] == NO_NAME) {
+			return NAME_MAP_NOT_FOUND;
+		}
+	}
+}
+
+void name_map_set(name_map *map, name_id name, uint32_t value) {
+	if (name == NO_NAME) {
+		return;
+	}
+
+	if ((map->count + 1) * 2 > map->capacity) {
+		grow(map);
+	}
+
+	insert(map, name, value);
+}
+
+void name_map_clear(name_map *map) {
+	if (map->capacity > 0) {
+		memset(map->keys, 0, map->capacity * sizeof(name_id));
+	}
+	map->count = 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "names.h"
+
+#include <stdint.h>
+
+#define NAME_MAP_NOT_FOUND UINT32_MAX
+
+// Open addressing hash map from name ids to indices, used to look up functions, types and globals by name.
+// Lookups do not write so they can run concurrently as long as nothing is added at the same time.
+typedef struct name_map {
+	name_id  *keys;
+	uint32_t *values;
+	uint32_t  capacity; // power of two
+	uint32_t  count;
+} name_map;
+
+uint32_t name_map_get(name_map *map, name_id name);
+
+// replaces the value if the name is already in the map, no-names are never added
+void name_map_set(name_map *map, name_id name, uint32_t value);
+
+// removes all entries but keeps the memory
+void name_map_clear(name_map *map);
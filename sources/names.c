@@ -1,65 +1,288 @@
 #include "names.h"
 
-#include "libs/stb_ds.h"
-
+#include "arena.h"
 #include "errors.h"
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Names are interned into shards, each with its own lock, string arena and hash table. Lookups of existing names do not lock, the
+// tables are only ever replaced by bigger copies and published entries never change. Ids index a chunked table of string pointers
+// so get_name never sees memory move.
+
+#define NAME_CHUNK_SHIFT 12
+#define NAME_CHUNK_SIZE (1 << NAME_CHUNK_SHIFT)
+#define MAX_NAME_CHUNKS (16 * 1024)
+#define SHARDS_BITS 6
+#define SHARDS_COUNT (1 << SHARDS_BITS)
+
+typedef struct name_slot {
+	uint32_t hash;
+	uint32_t id;
+} name_slot;
+
+typedef struct name_table {
+	name_slot *slots;
+	uint32_t   capacity; // power of two
+	uint32_t   count;
+} name_table;
+
+typedef struct name_shard {
+	long        lock;
+	name_table *table;
+	arena      *strings;
+	name_table *retired_tables[32]; // lock-free readers can still be probing these
+	uint32_t    retired_tables_count;
+} name_shard;
+
+static char     **name_chunks[MAX_NAME_CHUNKS];
+static long       next_name_id = 1;
+static name_shard shards[SHARDS_COUNT];
+
+static char no_name[1] = {0};
+
+#ifdef _MSC_VER
+static void *load_pointer(void *const *pointer) {
+	return *(void *volatile const *)pointer;
+}
+
+static void store_pointer(void **pointer, void *value) {
+	*(void *volatile *)pointer = value;
+}
+
+static bool replace_null_pointer(void **pointer, void *value) {
+	return _InterlockedCompareExchangePointer(pointer, value, NULL) == NULL;
+}
+
+static uint32_t load_id(const uint32_t *id) {
+	return *(volatile const uint32_t *)id;
+}
+
+static void store_id(uint32_t *id, uint32_t value) {
+	*(volatile uint32_t *)id = value;
+}
 
-static char   *names       = NULL;
-static size_t  names_size  = 1024 * 1024;
-static name_id names_index = 1;
+static long take_name_id(void) {
+	return _InterlockedIncrement(&next_name_id) - 1;
+}
+
+static long load_name_count(void) {
+	return *(volatile long *)&next_name_id;
+}
+
+static void shard_lock(name_shard *shard) {
+	while (_InterlockedExchange(&shard->lock, 1) != 0) {
+		_mm_pause();
+	}
+}
 
-static struct {
-	char   *key;
-	name_id value;
-} *hash = NULL;
+static void shard_unlock(name_shard *shard) {
+	_InterlockedExchange(&shard->lock, 0);
+}
+#else
+static void *load_pointer(void *const *pointer) {
+	return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+}
+
+static void store_pointer(void **pointer, void *value) {
+	__atomic_store_n(pointer, value, __ATOMIC_RELEASE);
+}
+
+static bool replace_null_pointer(void **pointer, void *value) {
+	void *expected = NULL;
+	return __atomic_compare_exchange_n(pointer, &expected, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static uint32_t load_id(const uint32_t *id) {
+	return __atomic_load_n(id, __ATOMIC_ACQUIRE);
+}
+
+static void store_id(uint32_t *id, uint32_t value) {
+	__atomic_store_n(id, value, __ATOMIC_RELEASE);
+}
+
+static long take_name_id(void) {
+	return __atomic_fetch_add(&next_name_id, 1, __ATOMIC_RELAXED);
+}
+
+static long load_name_count(void) {
+	return __atomic_load_n(&next_name_id, __ATOMIC_ACQUIRE);
+}
+
+static void shard_lock(name_shard *shard) {
+	while (__atomic_exchange_n(&shard->lock, 1, __ATOMIC_ACQUIRE) != 0) {
+		while (__atomic_load_n(&shard->lock, __ATOMIC_RELAXED) != 0) {
+		}
+	}
+}
+
+static void shard_unlock(name_shard *shard) {
+	__atomic_store_n(&shard->lock, 0, __ATOMIC_RELEASE);
+}
+#endif
+
+static uint32_t hash_name(const char *name, size_t *length) {
+	uint32_t hash  = 2166136261u;
+	size_t   index = 0;
+	for (; name[index] != 0; ++index) {
+		hash = (hash ^ (uint8_t)name[index]) * 16777619u;
+	}
+	*length = index;
+	return hash;
+}
+
+static name_table *allocate_table(uint32_t capacity) {
+	name_table   *table   = (name_table *)malloc(sizeof(name_table));
+	name_slot    *slots   = (name_slot *)calloc(capacity, sizeof(name_slot));
+	debug_context context = {0};
+	check(table != NULL && slots != NULL, context, "Could not allocate names");
+	table->slots    = slots;
+	table->capacity = capacity;
+	table->count    = 0;
+	return table;
+}
+
+static void free_table(name_table *table) {
+	free(table->slots);
+	free(table);
+}
+
+static char *name_string(name_id id) {
+	char **chunk = (char **)load_pointer((void *const *)&name_chunks[id >> NAME_CHUNK_SHIFT]);
+	return chunk[id & (NAME_CHUNK_SIZE - 1)];
+}
+
+static name_id find_in_table(name_table *table, const char *name, uint32_t hash) {
+	uint32_t mask = table->capacity - 1;
+	for (uint32_t index = hash & mask;; index = (index + 1) & mask) {
+		uint32_t id = load_id(&table->slots[index].id);
+		if (id == 0) {
+			return NO_NAME;
+		}
+		if (table->slots[index].hash == hash && strcmp(name_string(id), name) == 0) {
+			return id;
+		}
+	}
+}
+
+static void insert_into_table(name_table *table, uint32_t hash, uint32_t id) {
+	uint32_t mask  = table->capacity - 1;
+	uint32_t index = hash & mask;
+	while (table->slots[index].id != 0) {
+		index = (index + 1) & mask;
+	}
+	table->slots[index].hash = hash;
+	store_id(&table->slots[index].id, id);
+	table->count += 1;
+}
 
 void names_init(void) {
-	char         *new_names = realloc(names, names_size);
-	debug_context context   = {0};
-	check(new_names != NULL, context, "Could not allocate names");
-	names    = new_names;
-	names[0] = 0; // make NO_NAME a proper string
-
-	sh_new_arena(hash); // TODO: Get rid of this by using indices internally in the hash-map so it can survive grow_if_needed
-}
-
-static void grow_if_needed(size_t size) {
-	while (size >= names_size) {
-		names_size *= 2;
-		char         *new_names = realloc(names, names_size);
-		debug_context context   = {0};
-		check(new_names != NULL, context, "Could not allocate names");
-		names = new_names;
+	for (size_t chunk_index = 0; chunk_index < MAX_NAME_CHUNKS && name_chunks[chunk_index] != NULL; ++chunk_index) {
+		free(name_chunks[chunk_index]);
+		name_chunks[chunk_index] = NULL;
+	}
+
+	for (uint32_t shard_index = 0; shard_index < SHARDS_COUNT; ++shard_index) {
+		name_shard *shard = &shards[shard_index];
+		if (shard->table != NULL) {
+			free_table(shard->table);
+			arena_destroy(shard->strings);
+		}
+		for (uint32_t table_index = 0; table_index < shard->retired_tables_count; ++table_index) {
+			free_table(shard->retired_tables[table_index]);
+		}
+		shard->lock                 = 0;
+		shard->table                = allocate_table(64);
+		shard->strings              = arena_create();
+		shard->retired_tables_count = 0;
+	}
+
+	name_chunks[0] = (char **)calloc(NAME_CHUNK_SIZE, sizeof(char *));
+	debug_context context = {0};
+	check(name_chunks[0] != NULL, context, "Could not allocate names");
+	name_chunks[0][NO_NAME] = no_name; // make NO_NAME a proper string
+	next_name_id            = 1;
+}
+
+static void publish_name(name_id id, char *string) {
+	size_t        chunk_index = id >> NAME_CHUNK_SHIFT;
+	debug_context context     = {0};
+	check(chunk_index < MAX_NAME_CHUNKS, context, "Too many names");
+
+	char **chunk = (char **)load_pointer((void *const *)&name_chunks[chunk_index]);
+	if (chunk == NULL) {
+		char **new_chunk = (char **)calloc(NAME_CHUNK_SIZE, sizeof(char *));
+		check(new_chunk != NULL, context, "Could not allocate names");
+		if (replace_null_pointer((void **)&name_chunks[chunk_index], new_chunk)) {
+			chunk = new_chunk;
+		}
+		else {
+			free(new_chunk);
+			chunk = (char **)load_pointer((void *const *)&name_chunks[chunk_index]);
+		}
 	}
+
+	chunk[id & (NAME_CHUNK_SIZE - 1)] = string;
 }
 
 name_id add_name(char *name) {
-	ptrdiff_t old_id_index = shgeti(hash, name);
+	size_t      length;
+	uint32_t    hash  = hash_name(name, &length);
+	name_shard *shard = &shards[hash >> (32 - SHARDS_BITS)]; // the low bits pick the slot
 
-	if (old_id_index >= 0) {
-		return hash[old_id_index].value;
+	name_id found = find_in_table((name_table *)load_pointer((void *const *)&shard->table), name, hash);
+	if (found != NO_NAME) {
+		return found;
 	}
 
-	size_t length = strlen(name);
+	shard_lock(shard);
 
-	grow_if_needed(names_index + length + 1);
+	name_table *table = shard->table;
+
+	found = find_in_table(table, name, hash);
+	if (found != NO_NAME) {
+		shard_unlock(shard);
+		return found;
+	}
+
+	if ((table->count + 1) * 2 > table->capacity) {
+		name_table *bigger = allocate_table(table->capacity * 2);
+		for (uint32_t index = 0; index < table->capacity; ++index) {
+			if (table->slots[index].id != 0) {
+				insert_into_table(bigger, table->slots[index].hash, table->slots[index].id);
+			}
+		}
+
+		debug_context context = {0};
+		check(shard->retired_tables_count < sizeof(shard->retired_tables) / sizeof(shard->retired_tables[0]), context, "Too many names");
+		shard->retired_tables[shard->retired_tables_count] = table;
+		shard->retired_tables_count += 1;
+
+		store_pointer((void **)&shard->table, bigger);
+		table = bigger;
+	}
 
-	name_id id = names_index;
+	char *string = (char *)arena_alloc(shard->strings, length + 1);
+	memcpy(string, name, length + 1);
 
-	memcpy(&names[id], name, length);
-	names[id + length] = 0;
+	name_id id = (name_id)take_name_id();
+	publish_name(id, string);
 
-	names_index += length + 1;
+	insert_into_table(table, hash, (uint32_t)id);
 
-	shput(hash, &names[id], id);
+	shard_unlock(shard);
 
 	return id;
 }
 
 char *get_name(name_id id) {
 	debug_context context = {0};
-	check(id < names_index, context, "Encountered a weird name id");
-	return &names[id];
+	check(id < (name_id)load_name_count(), context, "Encountered a weird name id");
+	return name_string(id);
 }
@@ -1,51 +1,57 @@
 #include "parser.h"
+#include "arena.h"
 #include "errors.h"
 #include "functions.h"
 #include "sets.h"
 #include "tokenizer.h"
 #include "types.h"
 
+#include "libs/stb_ds.h"
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
-static statement *statement_allocate(void) {
-	statement    *s       = (statement *)malloc(sizeof(statement));
-	debug_context context = {0};
-	check(s != NULL, context, "Could not allocate statement");
-	return s;
-}
+// one arena per parsed file, the nodes stay alive until parser_reset
+static arena **arenas = NULL;
 
-// static void statement_free(statement *statement) {
-//	free(statement);
-// }
+typedef struct state {
+	tokens       *tokens;
+	size_t        index;
+	debug_context context;
+	arena        *arena;
+} state_t;
+
+static statement *statement_allocate(state_t *state) {
+	return (statement *)arena_alloc(state->arena, sizeof(statement));
+}
 
 static void statements_init(statements *statements) {
-	statements->size = 0;
+	statements->s        = NULL;
+	statements->size     = 0;
+	statements->capacity = 0;
 }
 
-static void statements_add(statements *statements, statement *statement) {
+static void statements_add(state_t *state, statements *statements, statement *statement) {
+	if (statements->size >= statements->capacity) {
+		statements->capacity = statements->capacity == 0 ? 8 : statements->capacity * 2;
+		statements->s        = arena_grow(state->arena, statements->s, statements->size, statements->capacity, sizeof(statements->s[0]));
+	}
 	statements->s[statements->size] = statement;
 	statements->size += 1;
 }
 
-static expression *expression_allocate(void) {
-	expression   *e       = (expression *)malloc(sizeof(expression));
-	debug_context context = {0};
-	check(e != NULL, context, "Could not allocate expression");
+static expression *expression_allocate(state_t *state) {
+	expression *e = (expression *)arena_alloc(state->arena, sizeof(expression));
 	init_type_ref(&e->type, NO_NAME);
 	return e;
 }
 
-// static void expression_free(expression *expression) {
-//	free(expression);
-// }
-
-typedef struct state {
-	tokens       *tokens;
-	size_t        index;
-	debug_context context;
-} state_t;
+static void allocate_local_variables(state_t *state, block *b) {
+	if (b->vars.capacity > 0) {
+		b->vars.v = (local_variable *)arena_alloc(state->arena, b->vars.capacity * sizeof(local_variable));
+	}
+}
 
 static token current(state_t *state) {
 	token token = tokens_get(state->tokens, state->index);
@@ -84,6 +90,9 @@ void parse(const char *filename, tokens *tokens) {
 	state.context.filename = filename;
 	state.tokens           = tokens;
 	state.index            = 0;
+	state.arena            = arena_create();
+
+	arrput(arenas, state.arena);
 
 	for (;;) {
 		token token = current(&state);
@@ -96,23 +105,34 @@ void parse(const char *filename, tokens *tokens) {
 	}
 }
 
-static statement *parse_block(state_t *state, block *parent_block) {
+void parser_reset(void) {
+	for (ptrdiff_t i = 0; i < arrlen(arenas); ++i) {
+		arena_destroy(arenas[i]);
+	}
+	arrfree(arenas);
+}
+
+// parameters_size reserves local variable slots for the parameters of a function block
+static statement *parse_block(state_t *state, block *parent_block, uint8_t parameters_size) {
 	match_token(state, TOKEN_LEFT_CURLY, "Expected an opening curly bracket");
 	advance_state(state);
 
 	statements statements;
 	statements_init(&statements);
 
-	statement *new_block       = statement_allocate();
-	new_block->kind            = STATEMENT_BLOCK;
-	new_block->block.parent    = parent_block;
-	new_block->block.vars.size = 0;
+	statement *new_block           = statement_allocate(state);
+	new_block->kind                = STATEMENT_BLOCK;
+	new_block->block.parent        = parent_block;
+	new_block->block.vars.v        = NULL;
+	new_block->block.vars.size     = 0;
+	new_block->block.vars.capacity = parameters_size;
 
 	for (;;) {
 		switch (current(state).kind) {
 		case TOKEN_RIGHT_CURLY: {
 			advance_state(state);
 			new_block->block.statements = statements;
+			allocate_local_variables(state, &new_block->block);
 			return new_block;
 		}
 		case TOKEN_NONE: {
@@ -121,7 +141,7 @@ static statement *parse_block(state_t *state, block *parent_block) {
 			return NULL;
 		}
 		default:
-			statements_add(&statements, parse_statement(state, &new_block->block));
+			statements_add(state, &statements, parse_statement(state, &new_block->block));
 			break;
 		}
 	}
@@ -320,16 +340,27 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		advance_state(state);
 
 		statement *if_block = parse_statement(state, parent_block);
-		statement *s        = statement_allocate();
+		statement *s        = statement_allocate(state);
 		s->kind             = STATEMENT_IF;
 		s->iffy.test        = test;
 		s->iffy.if_block    = if_block;
 
-		s->iffy.else_size = 0;
+		s->iffy.else_tests    = NULL;
+		s->iffy.else_blocks   = NULL;
+		s->iffy.else_size     = 0;
+		s->iffy.else_capacity = 0;
 
 		while (current(state).kind == TOKEN_ELSE) {
 			advance_state(state);
 
+			if (s->iffy.else_size >= s->iffy.else_capacity) {
+				check(s->iffy.else_capacity < UINT16_MAX / 2, state->context, "Too many else branches");
+				uint16_t capacity     = s->iffy.else_capacity == 0 ? 4 : s->iffy.else_capacity * 2;
+				s->iffy.else_tests    = arena_grow(state->arena, s->iffy.else_tests, s->iffy.else_size, capacity, sizeof(expression *));
+				s->iffy.else_blocks   = arena_grow(state->arena, s->iffy.else_blocks, s->iffy.else_size, capacity, sizeof(statement *));
+				s->iffy.else_capacity = capacity;
+			}
+
 			if (current(state).kind == TOKEN_IF) {
 				advance_state(state);
 				match_token(state, TOKEN_LEFT_PAREN, "Expected an opening bracket");
@@ -351,7 +382,6 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 			}
 
 			s->iffy.else_size += 1;
-			assert(s->iffy.else_size < 64);
 		}
 
 		return s;
@@ -367,7 +397,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 
 		statement *while_block = parse_statement(state, parent_block);
 
-		statement *s          = statement_allocate();
+		statement *s          = statement_allocate(state);
 		s->kind               = STATEMENT_WHILE;
 		s->whiley.test        = test;
 		s->whiley.while_block = while_block;
@@ -379,7 +409,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 
 		statement *do_block = parse_statement(state, parent_block);
 
-		statement *s          = statement_allocate();
+		statement *s          = statement_allocate(state);
 		s->kind               = STATEMENT_DO_WHILE;
 		s->whiley.while_block = do_block;
 
@@ -403,11 +433,13 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		statements outer_block_statements;
 		statements_init(&outer_block_statements);
 
-		statement *outer_block        = statement_allocate();
-		outer_block->kind             = STATEMENT_BLOCK;
-		outer_block->block.parent     = parent_block;
-		outer_block->block.vars.size  = 0;
-		outer_block->block.statements = outer_block_statements;
+		statement *outer_block           = statement_allocate(state);
+		outer_block->kind                = STATEMENT_BLOCK;
+		outer_block->block.parent        = parent_block;
+		outer_block->block.vars.v        = NULL;
+		outer_block->block.vars.size     = 0;
+		outer_block->block.vars.capacity = 0;
+		outer_block->block.statements    = outer_block_statements;
 
 		advance_state(state);
 
@@ -415,7 +447,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		advance_state(state);
 
 		statement *pre = parse_statement(state, &outer_block->block);
-		statements_add(&outer_block->block.statements, pre);
+		statements_add(state, &outer_block->block.statements, pre);
 
 		expression *test = parse_expression(state);
 		match_token(state, TOKEN_SEMICOLON, "Expected a semicolon");
@@ -428,23 +460,25 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 
 		statement *inner_block = parse_statement(state, &outer_block->block);
 
-		statement *post_statement  = statement_allocate();
+		statement *post_statement  = statement_allocate(state);
 		post_statement->kind       = STATEMENT_EXPRESSION;
 		post_statement->expression = post_expression;
 
-		statements_add(&inner_block->block.statements, post_statement);
+		statements_add(state, &inner_block->block.statements, post_statement);
 
-		statement *s          = statement_allocate();
+		statement *s          = statement_allocate(state);
 		s->kind               = STATEMENT_WHILE;
 		s->whiley.test        = test;
 		s->whiley.while_block = inner_block;
 
-		statements_add(&outer_block->block.statements, s);
+		statements_add(state, &outer_block->block.statements, s);
+
+		allocate_local_variables(state, &outer_block->block);
 
 		return outer_block;
 	}
 	case TOKEN_LEFT_CURLY: {
-		return parse_block(state, parent_block);
+		return parse_block(state, parent_block, 0);
 	}
 	case TOKEN_VAR: {
 		advance_state(state);
@@ -469,7 +503,9 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		match_token(state, TOKEN_SEMICOLON, "Expected a semicolon");
 		advance_state(state);
 
-		statement *statement                      = statement_allocate();
+		parent_block->vars.capacity += 1;
+
+		statement *statement                      = statement_allocate(state);
 		statement->kind                           = STATEMENT_LOCAL_VARIABLE;
 		statement->local_variable.var.name        = name.identifier;
 		statement->local_variable.var.type        = type;
@@ -484,7 +520,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		match_token(state, TOKEN_SEMICOLON, "Expected a semicolon");
 		advance_state(state);
 
-		statement *statement  = statement_allocate();
+		statement *statement  = statement_allocate(state);
 		statement->kind       = STATEMENT_RETURN_EXPRESSION;
 		statement->expression = expr;
 		return statement;
@@ -495,7 +531,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		match_token(state, TOKEN_SEMICOLON, "Expected a semicolon");
 		advance_state(state);
 
-		statement *statement = statement_allocate();
+		statement *statement = statement_allocate(state);
 		statement->kind      = STATEMENT_DISCARD;
 
 		return statement;
@@ -505,7 +541,7 @@ static statement *parse_statement(state_t *state, block *parent_block) {
 		match_token(state, TOKEN_SEMICOLON, "Expected a semicolon");
 		advance_state(state);
 
-		statement *statement  = statement_allocate();
+		statement *statement  = statement_allocate(state);
 		statement->kind       = STATEMENT_EXPRESSION;
 		statement->expression = expr;
 		return statement;
@@ -531,7 +567,7 @@ static expression *parse_assign(state_t *state) {
 			    op == OPERATOR_MULTIPLY_ASSIGN) {
 				advance_state(state);
 				expression *right        = parse_logical(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -560,7 +596,7 @@ static expression *parse_logical(state_t *state) {
 			if (op == OPERATOR_OR || op == OPERATOR_AND) {
 				advance_state(state);
 				expression *right        = parse_bitwise(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -589,7 +625,7 @@ static expression *parse_bitwise(state_t *state) {
 			if (op == OPERATOR_BITWISE_XOR || op == OPERATOR_BITWISE_OR || op == OPERATOR_BITWISE_AND) {
 				advance_state(state);
 				expression *right        = parse_equality(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -618,7 +654,7 @@ static expression *parse_equality(state_t *state) {
 			if (op == OPERATOR_EQUALS || op == OPERATOR_NOT_EQUALS) {
 				advance_state(state);
 				expression *right        = parse_comparison(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -647,7 +683,7 @@ static expression *parse_comparison(state_t *state) {
 			if (op == OPERATOR_GREATER || op == OPERATOR_GREATER_EQUAL || op == OPERATOR_LESS || op == OPERATOR_LESS_EQUAL) {
 				advance_state(state);
 				expression *right        = parse_shift(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -676,7 +712,7 @@ static expression *parse_shift(state_t *state) {
 			if (op == OPERATOR_LEFT_SHIFT || op == OPERATOR_RIGHT_SHIFT) {
 				advance_state(state);
 				expression *right        = parse_addition(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -705,7 +741,7 @@ static expression *parse_addition(state_t *state) {
 			if (op == OPERATOR_MINUS || op == OPERATOR_PLUS) {
 				advance_state(state);
 				expression *right        = parse_multiplication(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -734,7 +770,7 @@ static expression *parse_multiplication(state_t *state) {
 			if (op == OPERATOR_DIVIDE || op == OPERATOR_MULTIPLY || op == OPERATOR_MOD) {
 				advance_state(state);
 				expression *right        = parse_unary(state);
-				expression *expression   = expression_allocate();
+				expression *expression   = expression_allocate(state);
 				expression->kind         = EXPRESSION_BINARY;
 				expression->binary.left  = expr;
 				expression->binary.op    = op;
@@ -762,7 +798,7 @@ static expression *parse_unary(state_t *state) {
 			if (op == OPERATOR_NOT || op == OPERATOR_MINUS) {
 				advance_state(state);
 				expression *right       = parse_unary(state);
-				expression *expression  = expression_allocate();
+				expression *expression  = expression_allocate(state);
 				expression->kind        = EXPRESSION_UNARY;
 				expression->unary.op    = op;
 				expression->unary.right = right;
@@ -789,7 +825,7 @@ static expression *parse_member_or_element_access(state_t *state, expression *of
 
 		advance_state(state);
 
-		expression *member         = expression_allocate();
+		expression *member         = expression_allocate(state);
 		member->kind               = EXPRESSION_MEMBER;
 		member->member.of          = of;
 		member->member.member_name = token.identifier;
@@ -807,7 +843,7 @@ static expression *parse_member_or_element_access(state_t *state, expression *of
 
 		advance_state(state);
 
-		expression *element            = expression_allocate();
+		expression *element            = expression_allocate(state);
 		element->kind                  = EXPRESSION_ELEMENT;
 		element->element.of            = of;
 		element->element.element_index = index;
@@ -833,7 +869,7 @@ static expression *parse_primary(state_t *state) {
 	case TOKEN_BOOLEAN: {
 		bool value = current(state).boolean;
 		advance_state(state);
-		left          = expression_allocate();
+		left          = expression_allocate(state);
 		left->kind    = EXPRESSION_BOOLEAN;
 		left->boolean = value;
 		break;
@@ -841,7 +877,7 @@ static expression *parse_primary(state_t *state) {
 	case TOKEN_FLOAT: {
 		double value = current(state).number;
 		advance_state(state);
-		left         = expression_allocate();
+		left         = expression_allocate(state);
 		left->kind   = EXPRESSION_FLOAT;
 		left->number = value;
 		break;
@@ -849,7 +885,7 @@ static expression *parse_primary(state_t *state) {
 	case TOKEN_INT: {
 		double value = current(state).number;
 		advance_state(state);
-		left         = expression_allocate();
+		left         = expression_allocate(state);
 		left->kind   = EXPRESSION_INT;
 		left->number = value;
 		break;
@@ -857,7 +893,7 @@ static expression *parse_primary(state_t *state) {
 	/*case TOKEN_STRING: {
 		token token = current(state);
 		advance_state(state);
-		left = expression_allocate();
+		left = expression_allocate(state);
 		left->kind = EXPRESSION_STRING;
 		left->string = add_name(token.string);
 		break;
@@ -869,7 +905,7 @@ static expression *parse_primary(state_t *state) {
 			left = parse_call(state, token.identifier);
 		}
 		else {
-			expression *var = expression_allocate();
+			expression *var = expression_allocate(state);
 			var->kind       = EXPRESSION_VARIABLE;
 			var->variable   = token.identifier;
 			left            = var;
@@ -881,7 +917,7 @@ static expression *parse_primary(state_t *state) {
 		expression *expr = parse_expression(state);
 		match_token(state, TOKEN_RIGHT_PAREN, "Expected a closing bracket");
 		advance_state(state);
-		left           = expression_allocate();
+		left           = expression_allocate(state);
 		left->kind     = EXPRESSION_GROUPING;
 		left->grouping = expr;
 		break;
@@ -896,7 +932,9 @@ static expression *parse_primary(state_t *state) {
 
 static expressions parse_parameters(state_t *state) {
 	expressions e;
-	e.size = 0;
+	e.e        = NULL;
+	e.size     = 0;
+	e.capacity = 0;
 
 	if (current(state).kind == TOKEN_RIGHT_PAREN) {
 		advance_state(state);
@@ -904,6 +942,10 @@ static expressions parse_parameters(state_t *state) {
 	}
 
 	for (;;) {
+		if (e.size >= e.capacity) {
+			e.capacity = e.capacity == 0 ? 4 : e.capacity * 2;
+			e.e        = arena_grow(state->arena, e.e, e.size, e.capacity, sizeof(expression *));
+		}
 		e.e[e.size] = parse_expression(state);
 		e.size += 1;
 
@@ -924,7 +966,7 @@ static expression *parse_call(state_t *state, name_id func_name) {
 
 	expression *call = NULL;
 
-	call                  = expression_allocate();
+	call                  = expression_allocate(state);
 	call->kind            = EXPRESSION_CALL;
 	call->call.func_name  = func_name;
 	call->call.parameters = parse_parameters(state);
@@ -1096,7 +1138,7 @@ static definition parse_function(state_t *state) {
 
 	type_ref return_type = parse_type_ref(state);
 
-	statement *block = parse_block(state, NULL);
+	statement *block = parse_block(state, NULL, parameters_size);
 
 	definition d;
 	d.kind             = DEFINITION_FUNCTION;
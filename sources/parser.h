@@ -12,8 +12,9 @@
 struct expression;
 
 typedef struct expressions {
-	struct expression *e[256];
-	size_t             size;
+	struct expression **e;
+	size_t              size;
+	size_t              capacity;
 } expressions;
 
 typedef struct expression {
@@ -72,8 +73,9 @@ typedef struct expression {
 struct statement;
 
 typedef struct statements {
-	struct statement *s[256];
-	size_t            size;
+	struct statement **s;
+	size_t             size;
+	size_t             capacity;
 } statements;
 
 typedef struct local_variable {
@@ -82,9 +84,11 @@ typedef struct local_variable {
 	uint64_t variable_id;
 } local_variable;
 
+// capacity is counted by the parser, the typer fills in the variables
 typedef struct local_variables {
-	local_variable v[256];
-	size_t         size;
+	local_variable *v;
+	size_t          size;
+	size_t          capacity;
 } local_variables;
 
 typedef struct block {
@@ -108,11 +112,12 @@ typedef struct statement {
 	union {
 		expression *expression;
 		struct {
-			expression       *test;
-			struct statement *if_block;
-			expression       *else_tests[64];
-			struct statement *else_blocks[64];
-			uint16_t          else_size;
+			expression        *test;
+			struct statement  *if_block;
+			expression       **else_tests;
+			struct statement **else_blocks;
+			uint16_t           else_size;
+			uint16_t           else_capacity;
 		} iffy;
 		struct {
 			expression       *test;
@@ -151,3 +156,6 @@ typedef struct definition {
 } definition;
 
 void parse(const char *filename, tokens *tokens);
+
+// frees all nodes of all parsed files
+void parser_reset(void);
@@ -36,6 +36,10 @@ size_t get_sets_count(void) {
 	return sets_count;
 }
 
+void sets_reset(void) {
+	sets_count = 0;
+}
+
 void add_definition_to_set(descriptor_set *set, definition def) {
 	assert(def.kind != DEFINITION_FUNCTION && def.kind != DEFINITION_STRUCT);
 
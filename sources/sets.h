@@ -20,6 +20,8 @@ descriptor_set *get_set(size_t index);
 
 size_t get_sets_count(void);
 
+void sets_reset(void);
+
 void add_definition_to_set(descriptor_set *set, definition def);
 
 #endif
@@ -3,9 +3,19 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KONG_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 token tokens_get(tokens *tokens, size_t index) {
 	debug_context context = {0};
 	check(tokens->current_size > index, context, "Token index out of bounds");
@@ -37,20 +47,30 @@ typedef enum mode {
 
 typedef struct tokenizer_state {
 	const char *iterator;
+	const char *end;
 	char        next;
 	char        next_next;
 	int         line, column;
 	bool        line_end;
 } tokenizer_state;
 
-static void tokenizer_state_init(debug_context *context, tokenizer_state *state, const char *source) {
+// the source does not need to be null-terminated, reading past the end yields zeros
+static char tokenizer_state_peek(tokenizer_state *state) {
+	return state->iterator < state->end ? *state->iterator : 0;
+}
+
+static void tokenizer_state_init(debug_context *context, tokenizer_state *state, const char *source, size_t size) {
+	// an embedded zero ends the source like before
+	const char *zero = (const char *)memchr(source, 0, size);
+
 	state->line = state->column = 0;
 	state->iterator             = source;
-	state->next                 = *state->iterator;
-	if (*state->iterator != 0) {
+	state->end                  = zero != NULL ? zero : source + size;
+	state->next                 = tokenizer_state_peek(state);
+	if (state->next != 0) {
 		state->iterator += 1;
 	}
-	state->next_next = *state->iterator;
+	state->next_next = tokenizer_state_peek(state);
 	state->line_end  = false;
 
 	context->column = 0;
@@ -59,10 +79,10 @@ static void tokenizer_state_init(debug_context *context, tokenizer_state *state,
 
 static void tokenizer_state_advance(debug_context *context, tokenizer_state *state) {
 	state->next = state->next_next;
-	if (*state->iterator != 0) {
+	if (tokenizer_state_peek(state) != 0) {
 		state->iterator += 1;
 	}
-	state->next_next = *state->iterator;
+	state->next_next = tokenizer_state_peek(state);
 
 	if (state->line_end) {
 		state->line_end = false;
@@ -81,6 +101,164 @@ static void tokenizer_state_advance(debug_context *context, tokenizer_state *sta
 	context->line   = state->line;
 }
 
+// only valid while state->next is not zero
+static const char *tokenizer_state_position(tokenizer_state *state) {
+	return state->iterator - 1;
+}
+
+#ifdef _MSC_VER
+static uint32_t count_bits(uint32_t mask) {
+	uint32_t count = 0;
+	while (mask != 0) {
+		mask &= mask - 1;
+		++count;
+	}
+	return count;
+}
+
+static uint32_t lowest_bit(uint32_t mask) {
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+}
+
+static uint32_t highest_bit(uint32_t mask) {
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return index;
+}
+#else
+static uint32_t count_bits(uint32_t mask) {
+	return (uint32_t)__builtin_popcount(mask);
+}
+
+static uint32_t lowest_bit(uint32_t mask) {
+	return (uint32_t)__builtin_ctz(mask);
+}
+
+static uint32_t highest_bit(uint32_t mask) {
+	return 31 - (uint32_t)__builtin_clz(mask);
+}
+#endif
+
+// Same as calling tokenizer_state_advance count times, the line and column are computed from the newlines in the skipped range
+static void tokenizer_state_skip(debug_context *context, tokenizer_state *state, size_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	const char *start     = tokenizer_state_position(state);
+	size_t      newlines  = 0;
+	size_t      last_line = 0; // offset after the last newline
+	size_t      index     = 1;
+
+	// the current character only ends a line when advance flagged it
+	if (state->line_end) {
+		newlines  = 1;
+		last_line = 1;
+	}
+
+#ifdef KONG_SSE2
+	__m128i newline = _mm_set1_epi8('\n');
+	for (; index + 16 <= count; index += 16) {
+		__m128i  chars = _mm_loadu_si128((const __m128i *)&start[index]);
+		uint32_t mask  = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, newline));
+		if (mask != 0) {
+			newlines += count_bits(mask);
+			last_line = index + highest_bit(mask) + 1;
+		}
+	}
+#endif
+
+	for (; index < count; ++index) {
+		if (start[index] == '\n') {
+			newlines += 1;
+			last_line = index + 1;
+		}
+	}
+
+	if (newlines == 0) {
+		state->column += (int)count;
+	}
+	else {
+		state->line += (int)newlines;
+		state->column = (int)(count - last_line);
+	}
+
+	state->iterator  = start + count;
+	state->next      = tokenizer_state_peek(state);
+	if (state->next != 0) {
+		state->iterator += 1;
+	}
+	state->next_next = tokenizer_state_peek(state);
+	state->line_end  = state->next == '\n';
+
+	context->column = state->column;
+	context->line   = state->line;
+}
+
+static size_t scan_whitespace(const char *start, const char *end) {
+	const char *current = start;
+
+#ifdef KONG_SSE2
+	__m128i space = _mm_set1_epi8(' ');
+	__m128i low   = _mm_set1_epi8(9);
+	__m128i high  = _mm_set1_epi8(13);
+	while (current + 16 <= end) {
+		__m128i  chars      = _mm_loadu_si128((const __m128i *)current);
+		__m128i  in_range   = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(chars, low), chars), _mm_cmpeq_epi8(_mm_min_epu8(chars, high), chars));
+		uint32_t whitespace = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, space), in_range));
+		if (whitespace != 0xffff) {
+			return (size_t)(current - start) + lowest_bit(~whitespace);
+		}
+		current += 16;
+	}
+#endif
+
+	while (current < end && is_whitespace(*current)) {
+		++current;
+	}
+	return (size_t)(current - start);
+}
+
+// letters, digits and underscores, other identifier characters are left to the regular state machine
+static size_t scan_identifier(const char *start, const char *end) {
+	const char *current = start;
+
+#ifdef KONG_SSE2
+	__m128i lower_a    = _mm_set1_epi8('a' - 1);
+	__m128i lower_z    = _mm_set1_epi8('z' + 1);
+	__m128i upper_a    = _mm_set1_epi8('A' - 1);
+	__m128i upper_z    = _mm_set1_epi8('Z' + 1);
+	__m128i digit_0    = _mm_set1_epi8('0' - 1);
+	__m128i digit_9    = _mm_set1_epi8('9' + 1);
+	__m128i underscore = _mm_set1_epi8('_');
+	while (current + 16 <= end) {
+		__m128i chars = _mm_loadu_si128((const __m128i *)current);
+		__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chars, lower_a), _mm_cmplt_epi8(chars, lower_z));
+		__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, upper_a), _mm_cmplt_epi8(chars, upper_z));
+		__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, digit_0), _mm_cmplt_epi8(chars, digit_9));
+		uint32_t identifier =
+		    (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(lower, upper), _mm_or_si128(digit, _mm_cmpeq_epi8(chars, underscore))));
+		if (identifier != 0xffff) {
+			return (size_t)(current - start) + lowest_bit(~identifier);
+		}
+		current += 16;
+	}
+#endif
+
+	while (current < end && ((*current >= 'a' && *current <= 'z') || (*current >= 'A' && *current <= 'Z') || (*current >= '0' && *current <= '9') ||
+	                         *current == '_')) {
+		++current;
+	}
+	return (size_t)(current - start);
+}
+
+static size_t scan_until(const char *start, const char *end, char ch) {
+	const char *found = (const char *)memchr(start, ch, (size_t)(end - start));
+	return found != NULL ? (size_t)(found - start) : (size_t)(end - start);
+}
+
 typedef struct tokenizer_buffer {
 	char  *buf;
 	size_t current_size;
@@ -89,8 +267,10 @@ typedef struct tokenizer_buffer {
 } tokenizer_buffer;
 
 static void tokenizer_buffer_init(tokenizer_buffer *buffer) {
-	buffer->max_size     = 1024 * 1024;
-	buffer->buf          = (char *)malloc(buffer->max_size);
+	buffer->max_size      = 256;
+	buffer->buf           = (char *)malloc(buffer->max_size);
+	debug_context context = {0};
+	check(buffer->buf != NULL, context, "Could not allocate token buffer");
 	buffer->current_size = 0;
 	buffer->column = buffer->line = 0;
 }
@@ -101,21 +281,35 @@ static void tokenizer_buffer_reset(tokenizer_buffer *buffer, tokenizer_state *st
 	buffer->line         = state->line;
 }
 
+// always keeps room for a terminating zero
+static void tokenizer_buffer_grow_if_needed(tokenizer_buffer *buffer, size_t size) {
+	while (size >= buffer->max_size) {
+		buffer->max_size *= 2;
+		char         *new_buf = (char *)realloc(buffer->buf, buffer->max_size);
+		debug_context context = {0};
+		check(new_buf != NULL, context, "Could not allocate token buffer");
+		buffer->buf = new_buf;
+	}
+}
+
 static void tokenizer_buffer_add(tokenizer_buffer *buffer, char ch) {
-	debug_context context = {0};
-	check(buffer->current_size < buffer->max_size, context, "Token buffer is too small");
+	tokenizer_buffer_grow_if_needed(buffer, buffer->current_size + 1);
 	buffer->buf[buffer->current_size] = ch;
 	buffer->current_size += 1;
 }
 
+static void tokenizer_buffer_add_chars(tokenizer_buffer *buffer, const char *chars, size_t count) {
+	tokenizer_buffer_grow_if_needed(buffer, buffer->current_size + count);
+	memcpy(&buffer->buf[buffer->current_size], chars, count);
+	buffer->current_size += count;
+}
+
 static bool tokenizer_buffer_equals(tokenizer_buffer *buffer, const char *str) {
 	buffer->buf[buffer->current_size] = 0;
 	return strcmp(buffer->buf, str) == 0;
 }
 
 static name_id tokenizer_buffer_to_name(tokenizer_buffer *buffer) {
-	debug_context context = {0};
-	check(buffer->current_size < buffer->max_size, context, "Token buffer is too small");
 	buffer->buf[buffer->current_size] = 0;
 	buffer->current_size += 1;
 	return add_name(buffer->buf);
@@ -134,68 +328,129 @@ token token_create(int kind, tokenizer_state *state) {
 	return token;
 }
 
-static void tokens_init(tokens *tokens) {
-	tokens->max_size     = 1024 * 1024;
-	tokens->t            = malloc(tokens->max_size * sizeof(token));
+// sources average well above four characters per token so this rarely has to grow
+static void tokens_init(tokens *tokens, size_t source_size) {
+	tokens->max_size      = source_size / 4 + 16;
+	tokens->t             = (token *)malloc(tokens->max_size * sizeof(token));
+	debug_context context = {0};
+	check(tokens->t != NULL, context, "Could not allocate tokens");
 	tokens->current_size = 0;
 }
 
 static void tokens_add(tokens *tokens, token token) {
+	if (tokens->current_size >= tokens->max_size) {
+		tokens->max_size *= 2;
+		struct token *new_t   = (struct token *)realloc(tokens->t, tokens->max_size * sizeof(struct token));
+		debug_context context = {0};
+		check(new_t != NULL, context, "Out of tokens");
+		tokens->t = new_t;
+	}
 	tokens->t[tokens->current_size] = token;
 	tokens->current_size += 1;
-	debug_context context = {0};
-	check(tokens->current_size <= tokens->max_size, context, "Out of tokens");
+}
+
+// keywords are dispatched on length and first character so ordinary identifiers mostly skip all comparisons
+static int keyword_kind(const char *buf, size_t length) {
+	switch (length) {
+	case 2:
+		switch (buf[0]) {
+		case 'i':
+			if (buf[1] == 'f') {
+				return TOKEN_IF;
+			}
+			if (buf[1] == 'n') {
+				return TOKEN_IN;
+			}
+			break;
+		case 'd':
+			if (buf[1] == 'o') {
+				return TOKEN_DO;
+			}
+			break;
+		}
+		break;
+	case 3:
+		switch (buf[0]) {
+		case 'f':
+			if (memcmp(buf, "for", 3) == 0) {
+				return TOKEN_FOR;
+			}
+			if (memcmp(buf, "fun", 3) == 0) {
+				return TOKEN_FUNCTION;
+			}
+			break;
+		case 'v':
+			if (memcmp(buf, "var", 3) == 0) {
+				return TOKEN_VAR;
+			}
+			break;
+		}
+		break;
+	case 4:
+		switch (buf[0]) {
+		case 't':
+			if (memcmp(buf, "true", 4) == 0) {
+				return TOKEN_BOOLEAN;
+			}
+			break;
+		case 'e':
+			if (memcmp(buf, "else", 4) == 0) {
+				return TOKEN_ELSE;
+			}
+			break;
+		}
+		break;
+	case 5:
+		switch (buf[0]) {
+		case 'f':
+			if (memcmp(buf, "false", 5) == 0) {
+				return TOKEN_BOOLEAN;
+			}
+			break;
+		case 'w':
+			if (memcmp(buf, "while", 5) == 0) {
+				return TOKEN_WHILE;
+			}
+			break;
+		case 'c':
+			if (memcmp(buf, "const", 5) == 0) {
+				return TOKEN_CONST;
+			}
+			break;
+		}
+		break;
+	case 6:
+		switch (buf[0]) {
+		case 's':
+			if (memcmp(buf, "struct", 6) == 0) {
+				return TOKEN_STRUCT;
+			}
+			break;
+		case 'r':
+			if (memcmp(buf, "return", 6) == 0) {
+				return TOKEN_RETURN;
+			}
+			break;
+		}
+		break;
+	case 7:
+		if (memcmp(buf, "discard", 7) == 0) {
+			return TOKEN_DISCARD;
+		}
+		break;
+	}
+
+	return TOKEN_IDENTIFIER;
 }
 
 static void tokens_add_identifier(tokenizer_state *state, tokens *tokens, tokenizer_buffer *buffer) {
-	token token;
+	int   kind  = keyword_kind(buffer->buf, buffer->current_size);
+	token token = token_create(kind, state);
 
-	if (tokenizer_buffer_equals(buffer, "true")) {
-		token         = token_create(TOKEN_BOOLEAN, state);
-		token.boolean = true;
-	}
-	else if (tokenizer_buffer_equals(buffer, "false")) {
-		token         = token_create(TOKEN_BOOLEAN, state);
-		token.boolean = false;
-	}
-	else if (tokenizer_buffer_equals(buffer, "if")) {
-		token = token_create(TOKEN_IF, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "else")) {
-		token = token_create(TOKEN_ELSE, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "while")) {
-		token = token_create(TOKEN_WHILE, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "do")) {
-		token = token_create(TOKEN_DO, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "for")) {
-		token = token_create(TOKEN_FOR, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "in")) {
-		token = token_create(TOKEN_IN, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "struct")) {
-		token = token_create(TOKEN_STRUCT, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "fun")) {
-		token = token_create(TOKEN_FUNCTION, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "var")) {
-		token = token_create(TOKEN_VAR, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "const")) {
-		token = token_create(TOKEN_CONST, state);
-	}
-	else if (tokenizer_buffer_equals(buffer, "return")) {
-		token = token_create(TOKEN_RETURN, state);
+	if (kind == TOKEN_BOOLEAN) {
+		token.boolean = buffer->buf[0] == 't';
 	}
-	else if (tokenizer_buffer_equals(buffer, "discard")) {
-		token = token_create(TOKEN_DISCARD, state);
-	}
-	else {
-		token            = token_create(TOKEN_IDENTIFIER, state);
+	else if (kind == TOKEN_IDENTIFIER) {
 		token.identifier = tokenizer_buffer_to_name(buffer);
 	}
 
@@ -204,18 +459,18 @@ static void tokens_add_identifier(tokenizer_state *state, tokens *tokens, tokeni
 	tokens_add(tokens, token);
 }
 
-tokens tokenize(const char *filename, const char *source) {
+tokens tokenize(const char *filename, const char *source, size_t size) {
 	mode mode           = MODE_SELECT;
 	bool number_has_dot = false;
 
 	tokens tokens;
-	tokens_init(&tokens);
+	tokens_init(&tokens, size);
 
 	debug_context context = {0};
 	context.filename      = filename;
 
 	tokenizer_state state;
-	tokenizer_state_init(&context, &state, source);
+	tokenizer_state_init(&context, &state, source, size);
 
 	tokenizer_buffer buffer;
 	tokenizer_buffer_init(&buffer);
@@ -244,6 +499,7 @@ tokens tokenize(const char *filename, const char *source) {
 			}
 
 			tokens_add(&tokens, token_create(TOKEN_NONE, &state));
+			free(buffer.buf);
 			return tokens;
 		}
 		else {
@@ -279,6 +535,8 @@ tokens tokenize(const char *filename, const char *source) {
 					tokenizer_buffer_add(&buffer, ch);
 				}
 				else if (is_whitespace(ch)) {
+					tokenizer_state_skip(&context, &state, scan_whitespace(tokenizer_state_position(&state), state.end));
+					break;
 				}
 				else if (ch == '(') {
 					tokens_add(&tokens, token_create(TOKEN_LEFT_PAREN, &state));
@@ -329,8 +587,11 @@ tokens tokenize(const char *filename, const char *source) {
 			case MODE_LINE_COMMENT: {
 				if (ch == '\n') {
 					mode = MODE_SELECT;
+					tokenizer_state_advance(&context, &state);
+				}
+				else {
+					tokenizer_state_skip(&context, &state, scan_until(tokenizer_state_position(&state), state.end, '\n'));
 				}
-				tokenizer_state_advance(&context, &state);
 				break;
 			}
 			case MODE_COMMENT: {
@@ -342,8 +603,11 @@ tokens tokenize(const char *filename, const char *source) {
 							tokenizer_state_advance(&context, &state);
 						}
 					}
+					tokenizer_state_advance(&context, &state);
+				}
+				else {
+					tokenizer_state_skip(&context, &state, scan_until(tokenizer_state_position(&state), state.end, '*'));
 				}
-				tokenizer_state_advance(&context, &state);
 				break;
 			}
 			case MODE_NUMBER: {
@@ -530,8 +794,16 @@ tokens tokenize(const char *filename, const char *source) {
 					mode = MODE_SELECT;
 				}
 				else {
-					tokenizer_buffer_add(&buffer, ch);
-					tokenizer_state_advance(&context, &state);
+					const char *position = tokenizer_state_position(&state);
+					size_t      count    = scan_identifier(position, state.end);
+					if (count == 0) {
+						tokenizer_buffer_add(&buffer, ch);
+						tokenizer_state_advance(&context, &state);
+					}
+					else {
+						tokenizer_buffer_add_chars(&buffer, position, count);
+						tokenizer_state_skip(&context, &state, count);
+					}
 				}
 				break;
 			}
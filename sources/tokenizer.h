@@ -85,4 +85,4 @@ typedef struct tokens {
 
 token tokens_get(tokens *arr, size_t index);
 
-tokens tokenize(const char *filename, const char *source);
+tokens tokenize(const char *filename, const char *source, size_t size);
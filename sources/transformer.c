@@ -1,25 +1,2961 @@
 #include "transformer.h"
 
+#include "analyzer.h"
 #include "compiler.h"
+#include "errors.h"
 #include "functions.h"
+#include "globals.h"
+#include "ir.h"
+#include "parser.h"
 #include "types.h"
 
+#include "libs/stb_ds.h"
+
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-opcodes new_code;
+static opcodes new_code;
+
+// the names the passes compare against, looked up once per transform so the comparisons do not take the name lock
+static struct {
+	name_id dot;
+	name_id length;
+	name_id abs;
+	name_id floor;
+	name_id ceil;
+	name_id frac;
+	name_id saturate;
+	name_id sqrt;
+	name_id min;
+	name_id max;
+	name_id clamp;
+	name_id set_mesh_output_counts;
+	name_id set_mesh_vertex;
+	name_id set_mesh_triangle;
+	name_id dispatch_mesh;
+	name_id trace_ray;
+	name_id inline_attribute;
+	name_id noinline_attribute;
+} names;
+
+static void init_names(void) {
+	names.dot                    = add_name("dot");
+	names.length                 = add_name("length");
+	names.abs                    = add_name("abs");
+	names.floor                  = add_name("floor");
+	names.ceil                   = add_name("ceil");
+	names.frac                   = add_name("frac");
+	names.saturate               = add_name("saturate");
+	names.sqrt                   = add_name("sqrt");
+	names.min                    = add_name("min");
+	names.max                    = add_name("max");
+	names.clamp                  = add_name("clamp");
+	names.set_mesh_output_counts = add_name("set_mesh_output_counts");
+	names.set_mesh_vertex        = add_name("set_mesh_vertex");
+	names.set_mesh_triangle      = add_name("set_mesh_triangle");
+	names.dispatch_mesh          = add_name("dispatch_mesh");
+	names.trace_ray              = add_name("trace_ray");
+	names.inline_attribute       = add_name("inline");
+	names.noinline_attribute     = add_name("noinline");
+}
+
+static void copy_opcode(opcode *o) {
+	opcodes_reserve(&new_code, new_code.size + o->size);
+
+	uint8_t *new_data = &new_code.o[new_code.size];
+
+	memcpy(new_data, o, o->size);
+
+	new_code.size += o->size;
+}
+
+// calls of built-in functions that only compute their result
+static bool is_pure_call(opcode *o) {
+	if (o->op_call.callee == NO_FUNCTION || get_function(o->op_call.callee)->block != NULL) {
+		return false;
+	}
+
+	name_id name = o->op_call.func;
+	return name != names.set_mesh_output_counts && name != names.set_mesh_vertex && name != names.set_mesh_triangle && name != names.dispatch_mesh &&
+	       name != names.trace_ray;
+}
+
+static bool is_parameter(function *f, uint32_t variable_index) {
+	for (size_t var_index = 0; var_index < f->block->block.vars.size; ++var_index) {
+		local_variable *var = &f->block->block.vars.v[var_index];
+		if (var->variable_id != variable_index) {
+			continue;
+		}
+		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
+			if (f->parameter_names[parameter_index] == var->name) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// whether the instruction can go when nothing reads what it writes
+static bool is_removable(function *f, opcode *o, ir_operands *operands) {
+	switch (o->type) {
+	case OPCODE_CALL:
+		if (!is_pure_call(o)) {
+			return false;
+		}
+		break;
+	case OPCODE_VAR:
+	case OPCODE_RETURN:
+	case OPCODE_DISCARD:
+	case OPCODE_IF:
+	case OPCODE_WHILE_START:
+	case OPCODE_WHILE_CONDITION:
+	case OPCODE_WHILE_END:
+	case OPCODE_BLOCK_START:
+	case OPCODE_BLOCK_END:
+		return false;
+	default:
+		break;
+	}
+
+	for (uint8_t definition_index = 0; definition_index < operands->definitions_size; ++definition_index) {
+		variable *v = operands->definitions[definition_index];
+		// parameters can be inout, like ray payloads
+		if (v->kind == VARIABLE_GLOBAL || (v->kind == VARIABLE_LOCAL && is_parameter(f, v->index))) {
+			return false;
+		}
+	}
+
+	return operands->definitions_size > 0;
+}
+
+// drops everything behind a return or discard up to the end of the enclosing block or loop
+static uint32_t remove_unreachable_code(ir_function *ir) {
+	uint32_t removed     = 0;
+	bool     unreachable = false;
+	uint32_t depth       = 0;
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+
+			if (!unreachable) {
+				if (o->type == OPCODE_RETURN || o->type == OPCODE_DISCARD) {
+					unreachable = true;
+					depth       = 0;
+				}
+				continue;
+			}
+
+			if (o->type == OPCODE_BLOCK_START || o->type == OPCODE_WHILE_START) {
+				depth += 1;
+			}
+			else if (o->type == OPCODE_BLOCK_END || o->type == OPCODE_WHILE_END) {
+				if (depth == 0) {
+					unreachable = false;
+					continue;
+				}
+				depth -= 1;
+			}
+
+			ir_location location = {
+			    .block       = block_index,
+			    .instruction = instruction_index,
+			};
+			ir_remove(ir, location);
+			removed += 1;
+		}
+	}
+
+	return removed;
+}
+
+#define BITS_WORD(index) ((index) / 64)
+#define BITS_MASK(index) (1ull << ((index) % 64))
+
+static void compute_live_out(ir_function *ir, uint64_t *live_in, uint64_t *live_out, size_t words) {
+	uint32_t blocks_size = (uint32_t)arrlenu(ir->blocks);
+
+	memset(live_in, 0, blocks_size * words * sizeof(uint64_t));
+	memset(live_out, 0, blocks_size * words * sizeof(uint64_t));
+
+	uint64_t     *live    = (uint64_t *)malloc(words * sizeof(uint64_t));
+	debug_context context = {0};
+	check(live != NULL, context, "Could not allocate the liveness");
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+
+		for (uint32_t block_index = blocks_size; block_index > 0; --block_index) {
+			ir_block *block = &ir->blocks[block_index - 1];
+			uint64_t *out   = &live_out[(block_index - 1) * words];
+			uint64_t *in    = &live_in[(block_index - 1) * words];
+
+			for (size_t successor_index = 0; successor_index < arrlenu(block->successors); ++successor_index) {
+				uint64_t *successor_in = &live_in[block->successors[successor_index] * words];
+				for (size_t word = 0; word < words; ++word) {
+					out[word] |= successor_in[word];
+				}
+			}
+
+			memcpy(live, out, words * sizeof(uint64_t));
+
+			for (size_t instruction_index = arrlenu(block->instructions); instruction_index > 0; --instruction_index) {
+				opcode *o = block->instructions[instruction_index - 1];
+				if (o == NULL) {
+					continue;
+				}
+
+				ir_operands operands;
+				ir_operands_of(o, &operands);
+
+				for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+					uint32_t index = operands.definitions[definition_index]->index;
+					live[BITS_WORD(index)] &= ~BITS_MASK(index);
+				}
+				for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+					uint32_t index = operands.uses[use_index]->index;
+					live[BITS_WORD(index)] |= BITS_MASK(index);
+				}
+			}
+
+			for (size_t word = 0; word < words; ++word) {
+				if ((live[word] & ~in[word]) != 0) {
+					in[word] |= live[word];
+					changed = true;
+				}
+			}
+		}
+	}
+
+	free(live);
+}
+
+static uint32_t remove_dead_instructions(ir_function *ir, uint64_t *live_out, size_t words) {
+	uint32_t removed = 0;
+
+	uint64_t     *live    = (uint64_t *)malloc(words * sizeof(uint64_t));
+	debug_context context = {0};
+	check(live != NULL, context, "Could not allocate the liveness");
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+
+		memcpy(live, &live_out[block_index * words], words * sizeof(uint64_t));
+
+		for (uint32_t instruction_index = (uint32_t)arrlenu(block->instructions); instruction_index > 0; --instruction_index) {
+			opcode *o = block->instructions[instruction_index - 1];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+
+			if (is_removable(ir->f, o, &operands)) {
+				bool dead = true;
+				for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+					uint32_t index = operands.definitions[definition_index]->index;
+					if ((live[BITS_WORD(index)] & BITS_MASK(index)) != 0) {
+						dead = false;
+					}
+				}
+
+				if (dead) {
+					ir_location location = {
+					    .block       = block_index,
+					    .instruction = instruction_index - 1,
+					};
+					ir_remove(ir, location);
+					removed += 1;
+					continue;
+				}
+			}
+
+			for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+				uint32_t index = operands.definitions[definition_index]->index;
+				live[BITS_WORD(index)] &= ~BITS_MASK(index);
+			}
+			for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+				uint32_t index = operands.uses[use_index]->index;
+				live[BITS_WORD(index)] |= BITS_MASK(index);
+			}
+		}
+	}
+
+	free(live);
+
+	return removed;
+}
+
+// keeps what the side effects depend on, unlike liveness this also drops values that only feed themselves around a loop,
+// expects up to date definitions and uses
+static uint32_t remove_unneeded_instructions(ir_function *ir) {
+	uint32_t blocks_size = (uint32_t)arrlenu(ir->blocks);
+
+	size_t       *offsets = (size_t *)malloc((blocks_size + 1) * sizeof(size_t));
+	debug_context context = {0};
+	check(offsets != NULL, context, "Could not allocate the instruction marks");
+	offsets[0] = 0;
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		offsets[block_index + 1] = offsets[block_index] + arrlenu(ir->blocks[block_index].instructions);
+	}
+
+	bool *needed = (bool *)calloc(offsets[blocks_size] + 1, sizeof(bool));
+	check(needed != NULL, context, "Could not allocate the instruction marks");
+
+	ir_location *worklist = NULL;
+
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+
+			if (!is_removable(ir->f, o, &operands)) {
+				ir_location location = {
+				    .block       = block_index,
+				    .instruction = instruction_index,
+				};
+				needed[offsets[block_index] + instruction_index] = true;
+				arrput(worklist, location);
+			}
+		}
+	}
+
+	while (arrlenu(worklist) > 0) {
+		ir_location location = arrpop(worklist);
+
+		ir_operands operands;
+		ir_operands_of(ir->blocks[location.block].instructions[location.instruction], &operands);
+
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			ir_variable *v = &ir->variables[operands.uses[use_index]->index];
+			for (uint32_t definition_index = 0; definition_index < v->definitions_size; ++definition_index) {
+				ir_location definition = v->definitions[definition_index];
+				if (!needed[offsets[definition.block] + definition.instruction]) {
+					needed[offsets[definition.block] + definition.instruction] = true;
+					arrput(worklist, definition);
+				}
+			}
+		}
+	}
+
+	uint32_t removed = 0;
+
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			if (block->instructions[instruction_index] != NULL && !needed[offsets[block_index] + instruction_index]) {
+				ir_location location = {
+				    .block       = block_index,
+				    .instruction = instruction_index,
+				};
+				ir_remove(ir, location);
+				removed += 1;
+			}
+		}
+	}
+
+	arrfree(worklist);
+	free(needed);
+	free(offsets);
+
+	return removed;
+}
+
+// ifs with nothing left between the start and the end of their block
+static uint32_t remove_empty_ifs(ir_function *ir) {
+	ir_location previous[2];
+	uint32_t    previous_size = 0;
+	uint32_t    removed       = 0;
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_location location = {
+			    .block       = block_index,
+			    .instruction = instruction_index,
+			};
+
+			if (o->type == OPCODE_BLOCK_END && previous_size == 2) {
+				opcode *if_opcode    = ir->blocks[previous[0].block].instructions[previous[0].instruction];
+				opcode *start_opcode = ir->blocks[previous[1].block].instructions[previous[1].instruction];
+				if (if_opcode->type == OPCODE_IF && start_opcode->type == OPCODE_BLOCK_START && start_opcode->op_block.id == if_opcode->op_if.start_id &&
+				    o->op_block.id == if_opcode->op_if.end_id) {
+					ir_remove(ir, previous[0]);
+					ir_remove(ir, previous[1]);
+					ir_remove(ir, location);
+					removed += 1;
+					previous_size = 0;
+					continue;
+				}
+			}
+
+			if (previous_size == 2) {
+				previous[0]   = previous[1];
+				previous_size = 1;
+			}
+			previous[previous_size] = location;
+			previous_size += 1;
+		}
+	}
+
+	return removed;
+}
+
+// declarations of locals that are neither written nor read anymore, expects up to date definitions and uses
+static uint32_t remove_unused_locals(ir_function *ir) {
+	uint32_t removed = 0;
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL || o->type != OPCODE_VAR) {
+				continue;
+			}
+
+			ir_variable *v = &ir->variables[o->op_var.var.index];
+			if (v->definitions_size == 0 && v->uses_size == 0) {
+				ir_location location = {
+				    .block       = block_index,
+				    .instruction = instruction_index,
+				};
+				ir_remove(ir, location);
+				removed += 1;
+			}
+		}
+	}
+
+	return removed;
+}
+
+static void eliminate_dead_code(function *f) {
+	ir_function ir;
+	if (!ir_build(&ir, f)) {
+		return;
+	}
+
+	uint32_t removed = remove_unreachable_code(&ir);
+
+	size_t        words       = (ir.variables_size + 63) / 64;
+	size_t        blocks_size = arrlenu(ir.blocks);
+	uint64_t     *live_in     = (uint64_t *)malloc(blocks_size * words * sizeof(uint64_t));
+	uint64_t     *live_out    = (uint64_t *)malloc(blocks_size * words * sizeof(uint64_t));
+	debug_context context     = {0};
+	check(live_in != NULL && live_out != NULL, context, "Could not allocate the liveness");
+
+	// removing an instruction can make the instructions that fed it dead
+	bool outdated = removed > 0;
+	for (;;) {
+		compute_live_out(&ir, live_in, live_out, words);
+		uint32_t dead = remove_dead_instructions(&ir, live_out, words);
+
+		if (outdated || dead > 0) {
+			ir_update(&ir);
+		}
+		uint32_t unneeded = remove_unneeded_instructions(&ir) + remove_empty_ifs(&ir);
+		outdated          = unneeded > 0;
+
+		removed += dead + unneeded;
+		if (dead + unneeded == 0) {
+			break;
+		}
+	}
+
+	free(live_in);
+	free(live_out);
+
+	if (outdated) {
+		ir_update(&ir);
+	}
+	removed += remove_unused_locals(&ir);
+
+	if (removed > 0) {
+		ir_write(&ir, &f->code);
+	}
+
+	ir_free(&ir);
+}
+
+// what is known about the value of a variable, nothing when the type is NO_TYPE
+typedef struct constant {
+	type_id type;
+	union {
+		float    floats[4];
+		int32_t  ints[4];
+		uint32_t uints[4];
+		bool     bools[4];
+	};
+} constant;
+
+static void copy_component(constant *from, uint32_t from_index, constant *to, uint32_t to_index) {
+	if (vector_base_type(from->type) == bool_id) {
+		to->bools[to_index] = from->bools[from_index];
+	}
+	else {
+		to->uints[to_index] = from->uints[from_index];
+	}
+}
+
+static bool fold_component(int op, type_id base, constant *left, uint32_t left_index, constant *right, uint32_t right_index, constant *result,
+                           uint32_t index) {
+	if (base == float_id) {
+		float a = left->floats[left_index];
+		float b = right->floats[right_index];
+		switch (op) {
+		case OPCODE_ADD:
+			result->floats[index] = a + b;
+			return true;
+		case OPCODE_SUB:
+			result->floats[index] = a - b;
+			return true;
+		case OPCODE_MULTIPLY:
+			result->floats[index] = a * b;
+			return true;
+		case OPCODE_DIVIDE:
+			if (b == 0.0f) {
+				return false;
+			}
+			result->floats[index] = a / b;
+			return true;
+		case OPCODE_EQUALS:
+			result->bools[index] = a == b;
+			return true;
+		case OPCODE_NOT_EQUALS:
+			result->bools[index] = a != b;
+			return true;
+		case OPCODE_GREATER:
+			result->bools[index] = a > b;
+			return true;
+		case OPCODE_GREATER_EQUAL:
+			result->bools[index] = a >= b;
+			return true;
+		case OPCODE_LESS:
+			result->bools[index] = a < b;
+			return true;
+		case OPCODE_LESS_EQUAL:
+			result->bools[index] = a <= b;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	if (base == int_id) {
+		int32_t a = left->ints[left_index];
+		int32_t b = right->ints[right_index];
+		// wrap around like the gpu does instead of overflowing
+		switch (op) {
+		case OPCODE_ADD:
+			result->ints[index] = (int32_t)((uint32_t)a + (uint32_t)b);
+			return true;
+		case OPCODE_SUB:
+			result->ints[index] = (int32_t)((uint32_t)a - (uint32_t)b);
+			return true;
+		case OPCODE_MULTIPLY:
+			result->ints[index] = (int32_t)((uint32_t)a * (uint32_t)b);
+			return true;
+		case OPCODE_DIVIDE:
+			if (b == 0 || (a == INT32_MIN && b == -1)) {
+				return false;
+			}
+			result->ints[index] = a / b;
+			return true;
+		case OPCODE_MOD:
+			// the sign of a negative remainder differs between the targets
+			if (a < 0 || b <= 0) {
+				return false;
+			}
+			result->ints[index] = a % b;
+			return true;
+		case OPCODE_BITWISE_XOR:
+			result->ints[index] = a ^ b;
+			return true;
+		case OPCODE_BITWISE_AND:
+			result->ints[index] = a & b;
+			return true;
+		case OPCODE_BITWISE_OR:
+			result->ints[index] = a | b;
+			return true;
+		case OPCODE_LEFT_SHIFT:
+			if (b < 0 || b > 31) {
+				return false;
+			}
+			result->ints[index] = (int32_t)((uint32_t)a << b);
+			return true;
+		case OPCODE_RIGHT_SHIFT:
+			if (a < 0 || b < 0 || b > 31) {
+				return false;
+			}
+			result->ints[index] = a >> b;
+			return true;
+		case OPCODE_EQUALS:
+			result->bools[index] = a == b;
+			return true;
+		case OPCODE_NOT_EQUALS:
+			result->bools[index] = a != b;
+			return true;
+		case OPCODE_GREATER:
+			result->bools[index] = a > b;
+			return true;
+		case OPCODE_GREATER_EQUAL:
+			result->bools[index] = a >= b;
+			return true;
+		case OPCODE_LESS:
+			result->bools[index] = a < b;
+			return true;
+		case OPCODE_LESS_EQUAL:
+			result->bools[index] = a <= b;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	if (base == uint_id) {
+		uint32_t a = left->uints[left_index];
+		uint32_t b = right->uints[right_index];
+		switch (op) {
+		case OPCODE_ADD:
+			result->uints[index] = a + b;
+			return true;
+		case OPCODE_SUB:
+			result->uints[index] = a - b;
+			return true;
+		case OPCODE_MULTIPLY:
+			result->uints[index] = a * b;
+			return true;
+		case OPCODE_DIVIDE:
+			if (b == 0) {
+				return false;
+			}
+			result->uints[index] = a / b;
+			return true;
+		case OPCODE_MOD:
+			if (b == 0) {
+				return false;
+			}
+			result->uints[index] = a % b;
+			return true;
+		case OPCODE_BITWISE_XOR:
+			result->uints[index] = a ^ b;
+			return true;
+		case OPCODE_BITWISE_AND:
+			result->uints[index] = a & b;
+			return true;
+		case OPCODE_BITWISE_OR:
+			result->uints[index] = a | b;
+			return true;
+		case OPCODE_LEFT_SHIFT:
+			if (b > 31) {
+				return false;
+			}
+			result->uints[index] = a << b;
+			return true;
+		case OPCODE_RIGHT_SHIFT:
+			if (b > 31) {
+				return false;
+			}
+			result->uints[index] = a >> b;
+			return true;
+		case OPCODE_EQUALS:
+			result->bools[index] = a == b;
+			return true;
+		case OPCODE_NOT_EQUALS:
+			result->bools[index] = a != b;
+			return true;
+		case OPCODE_GREATER:
+			result->bools[index] = a > b;
+			return true;
+		case OPCODE_GREATER_EQUAL:
+			result->bools[index] = a >= b;
+			return true;
+		case OPCODE_LESS:
+			result->bools[index] = a < b;
+			return true;
+		case OPCODE_LESS_EQUAL:
+			result->bools[index] = a <= b;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	if (base == bool_id) {
+		bool a = left->bools[left_index];
+		bool b = right->bools[right_index];
+		switch (op) {
+		case OPCODE_EQUALS:
+			result->bools[index] = a == b;
+			return true;
+		case OPCODE_NOT_EQUALS:
+			result->bools[index] = a != b;
+			return true;
+		case OPCODE_AND:
+			result->bools[index] = a && b;
+			return true;
+		case OPCODE_OR:
+			result->bools[index] = a || b;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+static bool is_comparison(int op) {
+	return op == OPCODE_EQUALS || op == OPCODE_NOT_EQUALS || op == OPCODE_GREATER || op == OPCODE_GREATER_EQUAL || op == OPCODE_LESS ||
+	       op == OPCODE_LESS_EQUAL;
+}
+
+// a scalar operand is applied to every component of a vector one, matrices are left alone
+static bool fold_binary(int op, constant *left, constant *right, constant *result) {
+	type_id base = vector_base_type(left->type);
+	if (vector_base_type(right->type) != base) {
+		return false;
+	}
+
+	uint32_t left_size  = vector_size(left->type);
+	uint32_t right_size = vector_size(right->type);
+	if (left_size != right_size && left_size != 1 && right_size != 1) {
+		return false;
+	}
+
+	uint32_t size = left_size > right_size ? left_size : right_size;
+	if ((is_comparison(op) || op == OPCODE_AND || op == OPCODE_OR) && size != 1) {
+		return false;
+	}
+
+	result->type = is_comparison(op) ? bool_id : vector_to_size(base, size);
+	for (uint32_t index = 0; index < size; ++index) {
+		if (!fold_component(op, base, left, left_size == 1 ? 0 : index, right, right_size == 1 ? 0 : index, result, index)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool convert_component(constant *from, uint32_t from_index, type_id to_base, constant *to, uint32_t to_index) {
+	type_id from_base = vector_base_type(from->type);
+
+	if (to_base == float_id) {
+		if (from_base == float_id) {
+			to->floats[to_index] = from->floats[from_index];
+		}
+		else if (from_base == int_id) {
+			to->floats[to_index] = (float)from->ints[from_index];
+		}
+		else if (from_base == uint_id) {
+			to->floats[to_index] = (float)from->uints[from_index];
+		}
+		else {
+			to->floats[to_index] = from->bools[from_index] ? 1.0f : 0.0f;
+		}
+		return true;
+	}
+
+	if (to_base == int_id || to_base == uint_id) {
+		if (from_base == float_id) {
+			double number = from->floats[from_index];
+			// converting out of range floats is undefined
+			if (to_base == int_id && number > -2147483649.0 && number < 2147483648.0) {
+				to->ints[to_index] = (int32_t)number;
+				return true;
+			}
+			if (to_base == uint_id && number > -1.0 && number < 4294967296.0) {
+				to->uints[to_index] = (uint32_t)number;
+				return true;
+			}
+			return false;
+		}
+		else if (from_base == bool_id) {
+			to->uints[to_index] = from->bools[from_index] ? 1 : 0;
+		}
+		else {
+			to->uints[to_index] = from->uints[from_index];
+		}
+		return true;
+	}
+
+	if (from_base == float_id) {
+		to->bools[to_index] = from->floats[from_index] != 0.0f;
+	}
+	else if (from_base == bool_id) {
+		to->bools[to_index] = from->bools[from_index];
+	}
+	else {
+		to->bools[to_index] = from->uints[from_index] != 0;
+	}
+	return true;
+}
+
+// float3(1.0, 2.0, 3.0), float4(v, 1.0), float3(1.0) or int(x)
+static bool fold_constructor(opcode *o, constant *values, constant *result) {
+	type_id  base  = vector_base_type(o->op_call.var.type);
+	uint32_t size  = vector_size(o->op_call.var.type);
+	uint32_t count = 0;
+
+	for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+		constant *parameter = &values[o->op_call.parameters[parameter_index].index];
+		if (parameter->type == NO_TYPE || count + vector_size(parameter->type) > 4) {
+			return false;
+		}
+		for (uint32_t component = 0; component < vector_size(parameter->type); ++component) {
+			if (!convert_component(parameter, component, base, result, count)) {
+				return false;
+			}
+			count += 1;
+		}
+	}
+
+	if (count != 1 && count != size) {
+		return false;
+	}
+
+	result->type = o->op_call.var.type;
+	for (uint32_t component = count; component < size; ++component) {
+		copy_component(result, 0, result, component);
+	}
+	return true;
+}
+
+static float frac(float x) {
+	return x - floorf(x);
+}
+
+static float saturate(float x) {
+	return fminf(fmaxf(x, 0.0f), 1.0f);
+}
+
+// the float math built-ins that give the same result everywhere, applied per component
+static bool fold_built_in(opcode *o, constant *values, constant *result) {
+	constant *parameters[3];
+	if (o->op_call.parameters_size == 0 || o->op_call.parameters_size > 3) {
+		return false;
+	}
+	for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+		parameters[parameter_index] = &values[o->op_call.parameters[parameter_index].index];
+		if (parameters[parameter_index]->type == NO_TYPE || vector_base_type(parameters[parameter_index]->type) != float_id ||
+		    parameters[parameter_index]->type != parameters[0]->type) {
+			return false;
+		}
+	}
+
+	name_id  name = o->op_call.func;
+	uint32_t size = vector_size(parameters[0]->type);
+
+	if (name == names.dot || name == names.length) {
+		constant *right = name == names.dot ? parameters[1] : parameters[0];
+		if (o->op_call.parameters_size != (name == names.dot ? 2 : 1)) {
+			return false;
+		}
+		float sum = 0.0f;
+		for (uint32_t component = 0; component < size; ++component) {
+			sum += parameters[0]->floats[component] * right->floats[component];
+		}
+		result->type      = float_id;
+		result->floats[0] = name == names.dot ? sum : sqrtf(sum);
+		return true;
+	}
+
+	result->type = parameters[0]->type;
+	for (uint32_t component = 0; component < size; ++component) {
+		float a = parameters[0]->floats[component];
+		if (o->op_call.parameters_size == 1) {
+			if (name == names.abs) {
+				result->floats[component] = fabsf(a);
+			}
+			else if (name == names.floor) {
+				result->floats[component] = floorf(a);
+			}
+			else if (name == names.ceil) {
+				result->floats[component] = ceilf(a);
+			}
+			else if (name == names.frac) {
+				result->floats[component] = frac(a);
+			}
+			else if (name == names.saturate) {
+				result->floats[component] = saturate(a);
+			}
+			else if (name == names.sqrt && a >= 0.0f) {
+				result->floats[component] = sqrtf(a);
+			}
+			else {
+				return false;
+			}
+		}
+		else if (o->op_call.parameters_size == 2) {
+			float b = parameters[1]->floats[component];
+			if (name == names.min) {
+				result->floats[component] = fminf(a, b);
+			}
+			else if (name == names.max) {
+				result->floats[component] = fmaxf(a, b);
+			}
+			else {
+				return false;
+			}
+		}
+		else if (name == names.clamp) {
+			result->floats[component] = fminf(fmaxf(a, parameters[1]->floats[component]), parameters[2]->floats[component]);
+		}
+		else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool fold_instruction(opcode *o, constant *values, constant *result) {
+	switch (o->type) {
+	case OPCODE_LOAD_FLOAT_CONSTANT:
+		result->type      = float_id;
+		result->floats[0] = o->op_load_float_constant.number;
+		return true;
+	case OPCODE_LOAD_INT_CONSTANT:
+		result->type    = int_id;
+		result->ints[0] = o->op_load_int_constant.number;
+		return true;
+	case OPCODE_LOAD_BOOL_CONSTANT:
+		result->type     = bool_id;
+		result->bools[0] = o->op_load_bool_constant.boolean;
+		return true;
+	case OPCODE_STORE_VARIABLE:
+		*result = values[o->op_store_var.from.index];
+		return result->type != NO_TYPE;
+	case OPCODE_NOT: {
+		constant *from = &values[o->op_not.from.index];
+		if (from->type != bool_id) {
+			return false;
+		}
+		result->type     = bool_id;
+		result->bools[0] = !from->bools[0];
+		return true;
+	}
+	case OPCODE_NEGATE: {
+		constant *from = &values[o->op_negate.from.index];
+		if (from->type == NO_TYPE) {
+			return false;
+		}
+		type_id base = vector_base_type(from->type);
+		*result      = *from;
+		for (uint32_t component = 0; component < vector_size(from->type); ++component) {
+			if (base == float_id) {
+				result->floats[component] = -from->floats[component];
+			}
+			else if (base == int_id) {
+				result->ints[component] = (int32_t)(0u - from->uints[component]);
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+	case OPCODE_LOAD_ACCESS_LIST: {
+		constant *from = &values[o->op_load_access_list.from.index];
+		access   *a    = &o->op_load_access_list.access_list[0];
+		if (from->type == NO_TYPE || o->op_load_access_list.access_list_size != 1 || a->kind != ACCESS_SWIZZLE) {
+			return false;
+		}
+		for (uint32_t component = 0; component < a->access_swizzle.swizzle.size; ++component) {
+			if (a->access_swizzle.swizzle.indices[component] >= vector_size(from->type)) {
+				return false;
+			}
+			copy_component(from, a->access_swizzle.swizzle.indices[component], result, component);
+		}
+		result->type = vector_to_size(from->type, a->access_swizzle.swizzle.size);
+		return true;
+	}
+	case OPCODE_CALL:
+		if (!is_pure_call(o) || !is_vector_or_scalar(o->op_call.var.type)) {
+			return false;
+		}
+		if (o->op_call.func == get_type(o->op_call.var.type)->name) {
+			return fold_constructor(o, values, result);
+		}
+		return fold_built_in(o, values, result);
+	case OPCODE_MULTIPLY:
+	case OPCODE_DIVIDE:
+	case OPCODE_MOD:
+	case OPCODE_ADD:
+	case OPCODE_SUB:
+	case OPCODE_EQUALS:
+	case OPCODE_NOT_EQUALS:
+	case OPCODE_GREATER:
+	case OPCODE_GREATER_EQUAL:
+	case OPCODE_LESS:
+	case OPCODE_LESS_EQUAL:
+	case OPCODE_AND:
+	case OPCODE_OR:
+	case OPCODE_BITWISE_XOR:
+	case OPCODE_BITWISE_AND:
+	case OPCODE_BITWISE_OR:
+	case OPCODE_LEFT_SHIFT:
+	case OPCODE_RIGHT_SHIFT: {
+		constant *left  = &values[o->op_binary.left.index];
+		constant *right = &values[o->op_binary.right.index];
+		if (left->type == NO_TYPE || right->type == NO_TYPE) {
+			return false;
+		}
+		return fold_binary(o->type, left, right, result);
+	}
+	default:
+		return false;
+	}
+}
+
+// the c-style backends print floats with %f, values that would lose digits stay computed
+static bool prints_exactly(float number) {
+	if (!isfinite(number)) {
+		return false;
+	}
+	char text[64];
+	snprintf(text, sizeof(text), "%f", number);
+	return strtof(text, NULL) == number;
+}
+
+// replaces the computation of a scalar temporary that has a known value with a load of that value
+static bool load_constant(ir_function *ir, ir_location location, variable to, constant *value) {
+	opcode o;
+	if (to.kind != VARIABLE_INTERNAL || value->type != to.type) {
+		return false;
+	}
+
+	if (value->type == float_id && prints_exactly(value->floats[0])) {
+		o.type                          = OPCODE_LOAD_FLOAT_CONSTANT;
+		o.size                          = OP_SIZE(o, op_load_float_constant);
+		o.op_load_float_constant.number = value->floats[0];
+		o.op_load_float_constant.to     = to;
+	}
+	else if (value->type == int_id) {
+		o.type                        = OPCODE_LOAD_INT_CONSTANT;
+		o.size                        = OP_SIZE(o, op_load_int_constant);
+		o.op_load_int_constant.number = value->ints[0];
+		o.op_load_int_constant.to     = to;
+	}
+	else if (value->type == bool_id) {
+		o.type                          = OPCODE_LOAD_BOOL_CONSTANT;
+		o.size                          = OP_SIZE(o, op_load_bool_constant);
+		o.op_load_bool_constant.boolean = value->bools[0];
+		o.op_load_bool_constant.to      = to;
+	}
+	else {
+		return false;
+	}
+
+	ir->blocks[location.block].instructions[location.instruction] = ir_copy_opcode(ir, &o);
+	return true;
+}
+
+// whether a return or discard follows before the block that ends with the label end_id is closed
+static bool leaves_block(ir_function *ir, ir_location start, uint32_t end_id) {
+	for (uint32_t block_index = start.block; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = block_index == start.block ? start.instruction : 0; instruction_index < arrlenu(block->instructions);
+		     ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+			if (o->type == OPCODE_RETURN || o->type == OPCODE_DISCARD) {
+				return true;
+			}
+			if (o->type == OPCODE_BLOCK_END && o->op_block.id == end_id) {
+				return false;
+			}
+		}
+	}
+	return false;
+}
+
+// drops ifs that never run with their blocks, ifs that always run keep their block as a plain scope. A block that always runs
+// but returns stays behind its if so nothing unreachable follows a return.
+static uint32_t remove_constant_ifs(ir_function *ir, constant *values) {
+	uint32_t removed     = 0;
+	uint32_t skipped_end = 0;
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o == NULL) {
+				continue;
+			}
+
+			ir_location location = {
+			    .block       = block_index,
+			    .instruction = instruction_index,
+			};
+
+			if (skipped_end != 0) {
+				if (o->type == OPCODE_BLOCK_END && o->op_block.id == skipped_end) {
+					skipped_end = 0;
+				}
+				ir_remove(ir, location);
+				removed += 1;
+				continue;
+			}
+
+			if (o->type != OPCODE_IF || values[o->op_if.condition.index].type != bool_id) {
+				continue;
+			}
+
+			if (!values[o->op_if.condition.index].bools[0]) {
+				skipped_end = o->op_if.end_id;
+			}
+			else if (leaves_block(ir, location, o->op_if.end_id)) {
+				continue;
+			}
+
+			ir_remove(ir, location);
+			removed += 1;
+		}
+	}
+
+	return removed;
+}
+
+// Blocks are in code order and only loops jump back so every block comes after its dominators and the back edges can be
+// ignored. Unreachable blocks get no dominator.
+static uint32_t *find_immediate_dominators(ir_function *ir) {
+	uint32_t      blocks_size = (uint32_t)arrlenu(ir->blocks);
+	uint32_t     *dominators  = (uint32_t *)malloc(blocks_size * sizeof(uint32_t));
+	debug_context context     = {0};
+	check(dominators != NULL || blocks_size == 0, context, "Could not allocate the dominators");
+
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		uint32_t dominator = IR_NO_BLOCK;
+
+		ir_block *block = &ir->blocks[block_index];
+		for (size_t predecessor_index = 0; predecessor_index < arrlenu(block->predecessors); ++predecessor_index) {
+			uint32_t predecessor = block->predecessors[predecessor_index];
+			if (predecessor >= block_index || (predecessor != 0 && dominators[predecessor] == IR_NO_BLOCK)) {
+				continue;
+			}
+
+			if (dominator == IR_NO_BLOCK) {
+				dominator = predecessor;
+				continue;
+			}
+
+			while (dominator != predecessor) {
+				while (dominator > predecessor) {
+					dominator = dominators[dominator];
+				}
+				while (predecessor > dominator) {
+					predecessor = dominators[predecessor];
+				}
+			}
+		}
+
+		dominators[block_index] = dominator;
+	}
+
+	return dominators;
+}
+
+// whether the only definition of a variable runs before every read of it, a definition inside an if does not
+static bool dominates_uses(ir_function *ir, uint32_t *dominators, uint32_t variable_index) {
+	ir_variable *v          = &ir->variables[variable_index];
+	ir_location  definition = v->definitions[0];
+
+	for (uint32_t use_index = 0; use_index < v->uses_size; ++use_index) {
+		ir_location use = v->uses[use_index];
+		if (use.block == definition.block) {
+			if (use.instruction <= definition.instruction) {
+				return false;
+			}
+			continue;
+		}
+
+		uint32_t block = use.block;
+		while (block != definition.block && block != IR_NO_BLOCK) {
+			block = dominators[block];
+		}
+		if (block == IR_NO_BLOCK) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// globals, parameters, variables handed to functions that can write them and variables whose only definition does not
+// dominate their reads never get a known value
+static bool *find_fixed_variables(ir_function *ir) {
+	bool         *fixed   = (bool *)calloc(ir->variables_size, sizeof(bool));
+	debug_context context = {0};
+	check(fixed != NULL || ir->variables_size == 0, context, "Could not allocate the fixed variables");
+
+	function *f = ir->f;
+	for (size_t var_index = 0; var_index < f->block->block.vars.size; ++var_index) {
+		local_variable *var = &f->block->block.vars.v[var_index];
+		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
+			if (f->parameter_names[parameter_index] == var->name && var->variable_id < ir->variables_size) {
+				fixed[var->variable_id] = true;
+			}
+		}
+	}
+
+	for (uint32_t block_index = 0; block_index < arrlenu(ir->blocks); ++block_index) {
+		ir_block *block = &ir->blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o->type != OPCODE_CALL || is_pure_call(o)) {
+				continue;
+			}
+			for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+				fixed[o->op_call.parameters[parameter_index].index] = true;
+			}
+		}
+	}
+
+	uint32_t *dominators = find_immediate_dominators(ir);
+	for (uint32_t variable_index = 0; variable_index < ir->variables_size; ++variable_index) {
+		if (ir->variables[variable_index].definitions_size == 1 && !dominates_uses(ir, dominators, variable_index)) {
+			fixed[variable_index] = true;
+		}
+	}
+	free(dominators);
+
+	return fixed;
+}
+
+static void seed_global_constants(ir_function *ir, constant *values) {
+	for (global_id i = 0; get_global(i) != NULL; ++i) {
+		global *g = get_global(i);
+		if (g->value.kind == GLOBAL_VALUE_NONE || g->var_index == 0 || g->var_index >= ir->variables_size ||
+		    ir->variables[g->var_index].definitions_size > 0) {
+			continue;
+		}
+
+		constant *value = &values[g->var_index];
+		switch (g->value.kind) {
+		case GLOBAL_VALUE_FLOAT:
+		case GLOBAL_VALUE_FLOAT2:
+		case GLOBAL_VALUE_FLOAT3:
+		case GLOBAL_VALUE_FLOAT4:
+			value->type = vector_to_size(float_id, g->value.kind - GLOBAL_VALUE_FLOAT + 1);
+			memcpy(value->floats, g->value.value.floats, sizeof(value->floats));
+			break;
+		case GLOBAL_VALUE_INT:
+		case GLOBAL_VALUE_INT2:
+		case GLOBAL_VALUE_INT3:
+		case GLOBAL_VALUE_INT4:
+			value->type = vector_to_size(int_id, g->value.kind - GLOBAL_VALUE_INT + 1);
+			memcpy(value->ints, g->value.value.ints, sizeof(value->ints));
+			break;
+		case GLOBAL_VALUE_UINT:
+		case GLOBAL_VALUE_UINT2:
+		case GLOBAL_VALUE_UINT3:
+		case GLOBAL_VALUE_UINT4:
+			value->type = vector_to_size(uint_id, g->value.kind - GLOBAL_VALUE_UINT + 1);
+			memcpy(value->uints, g->value.value.uints, sizeof(value->uints));
+			break;
+		case GLOBAL_VALUE_BOOL:
+			value->type     = bool_id;
+			value->bools[0] = g->value.value.b;
+			break;
+		case GLOBAL_VALUE_NONE:
+			break;
+		}
+
+		if (value->type != g->type) {
+			value->type = NO_TYPE;
+		}
+	}
+}
+
+// Propagates the values of global consts and of variables that are written exactly once through the code, computes what only
+// depends on them and turns ifs with a known condition into plain code. The inputs of folded instructions are left for
+// eliminate_dead_code.
+static void fold_constants(function *f) {
+	ir_function ir;
+	if (!ir_build(&ir, f)) {
+		return;
+	}
+
+	constant     *values  = (constant *)malloc(ir.variables_size * sizeof(constant));
+	debug_context context = {0};
+	check(values != NULL || ir.variables_size == 0, context, "Could not allocate the constants");
+	for (uint32_t variable_index = 0; variable_index < ir.variables_size; ++variable_index) {
+		values[variable_index].type = NO_TYPE;
+	}
+
+	bool *fixed = find_fixed_variables(&ir);
+	seed_global_constants(&ir, values);
+
+	// a value never changes once it is known so this ends when a pass finds nothing new
+	bool changed = true;
+	while (changed) {
+		changed = false;
+
+		for (uint32_t block_index = 0; block_index < arrlenu(ir.blocks); ++block_index) {
+			ir_block *block = &ir.blocks[block_index];
+			for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+				opcode     *o = block->instructions[instruction_index];
+				ir_operands operands;
+				ir_operands_of(o, &operands);
+
+				if (operands.definitions_size != 1) {
+					continue;
+				}
+
+				variable *to = operands.definitions[0];
+				if (to->kind == VARIABLE_GLOBAL || fixed[to->index] || ir.variables[to->index].definitions_size != 1 || values[to->index].type != NO_TYPE) {
+					continue;
+				}
+
+				// partial and compound stores read what they write
+				bool reads_itself = false;
+				for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+					reads_itself = reads_itself || operands.uses[use_index]->index == to->index;
+				}
+				if (reads_itself) {
+					continue;
+				}
+
+				constant value;
+				if (!fold_instruction(o, values, &value)) {
+					continue;
+				}
+
+				// the literals of bools are typed as floats
+				if (value.type != to->type && o->type != OPCODE_LOAD_BOOL_CONSTANT) {
+					continue;
+				}
+
+				values[to->index] = value;
+				changed           = true;
+			}
+		}
+	}
+
+	uint32_t folded = 0;
+	for (uint32_t block_index = 0; block_index < arrlenu(ir.blocks); ++block_index) {
+		ir_block *block = &ir.blocks[block_index];
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+			if (o->type == OPCODE_LOAD_FLOAT_CONSTANT || o->type == OPCODE_LOAD_INT_CONSTANT || o->type == OPCODE_LOAD_BOOL_CONSTANT) {
+				continue;
+			}
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+			if (operands.definitions_size != 1 || values[operands.definitions[0]->index].type == NO_TYPE) {
+				continue;
+			}
+
+			ir_location location = {
+			    .block       = block_index,
+			    .instruction = instruction_index,
+			};
+			if (load_constant(&ir, location, *operands.definitions[0], &values[operands.definitions[0]->index])) {
+				folded += 1;
+			}
+		}
+	}
+
+	folded += remove_constant_ifs(&ir, values);
+
+	if (folded > 0) {
+		ir_write(&ir, &f->code);
+	}
+
+	free(fixed);
+	free(values);
+	ir_free(&ir);
+}
+
+// a computation whose result can be reused until something it reads changes
+typedef struct available_value {
+	opcode  *o;
+	variable result;
+	uint32_t depth; // scopes opened around it, the result is not visible after its scope closes
+} available_value;
+
+static bool same_variable(variable a, variable b) {
+	return a.index == b.index && a.type == b.type;
+}
+
+static bool same_access_list(access *a, access *b, uint8_t size) {
+	for (uint8_t access_index = 0; access_index < size; ++access_index) {
+		if (a[access_index].kind != b[access_index].kind || a[access_index].type != b[access_index].type) {
+			return false;
+		}
+
+		switch (a[access_index].kind) {
+		case ACCESS_MEMBER:
+			if (a[access_index].access_member.name != b[access_index].access_member.name) {
+				return false;
+			}
+			break;
+		case ACCESS_ELEMENT:
+			if (!same_variable(a[access_index].access_element.index, b[access_index].access_element.index)) {
+				return false;
+			}
+			break;
+		case ACCESS_SWIZZLE:
+			if (a[access_index].access_swizzle.swizzle.size != b[access_index].access_swizzle.swizzle.size ||
+			    memcmp(a[access_index].access_swizzle.swizzle.indices, b[access_index].access_swizzle.swizzle.indices,
+			           a[access_index].access_swizzle.swizzle.size * sizeof(a[access_index].access_swizzle.swizzle.indices[0])) != 0) {
+				return false;
+			}
+			break;
+		}
+	}
+	return true;
+}
+
+static bool is_commutative(opcode *o) {
+	switch (o->type) {
+	case OPCODE_ADD:
+	case OPCODE_MULTIPLY:
+	case OPCODE_EQUALS:
+	case OPCODE_NOT_EQUALS:
+	case OPCODE_AND:
+	case OPCODE_OR:
+	case OPCODE_BITWISE_XOR:
+	case OPCODE_BITWISE_AND:
+	case OPCODE_BITWISE_OR:
+		// matrix products depend on the order
+		return o->op_binary.left.type == o->op_binary.right.type && !is_matrix(o->op_binary.left.type);
+	default:
+		return false;
+	}
+}
+
+static bool same_computation(opcode *a, opcode *b) {
+	if (a->type != b->type) {
+		return false;
+	}
+
+	switch (a->type) {
+	case OPCODE_LOAD_FLOAT_CONSTANT:
+		return a->op_load_float_constant.to.type == b->op_load_float_constant.to.type &&
+		       memcmp(&a->op_load_float_constant.number, &b->op_load_float_constant.number, sizeof(float)) == 0;
+	case OPCODE_LOAD_INT_CONSTANT:
+		return a->op_load_int_constant.to.type == b->op_load_int_constant.to.type && a->op_load_int_constant.number == b->op_load_int_constant.number;
+	case OPCODE_LOAD_BOOL_CONSTANT:
+		return a->op_load_bool_constant.to.type == b->op_load_bool_constant.to.type &&
+		       a->op_load_bool_constant.boolean == b->op_load_bool_constant.boolean;
+	case OPCODE_NOT:
+		return a->op_not.to.type == b->op_not.to.type && same_variable(a->op_not.from, b->op_not.from);
+	case OPCODE_NEGATE:
+		return a->op_negate.to.type == b->op_negate.to.type && same_variable(a->op_negate.from, b->op_negate.from);
+	case OPCODE_LOAD_ACCESS_LIST:
+		return a->op_load_access_list.to.type == b->op_load_access_list.to.type && same_variable(a->op_load_access_list.from, b->op_load_access_list.from) &&
+		       a->op_load_access_list.access_list_size == b->op_load_access_list.access_list_size &&
+		       same_access_list(a->op_load_access_list.access_list, b->op_load_access_list.access_list, a->op_load_access_list.access_list_size);
+	case OPCODE_CALL:
+		if (a->op_call.func != b->op_call.func || a->op_call.var.type != b->op_call.var.type || a->op_call.parameters_size != b->op_call.parameters_size) {
+			return false;
+		}
+		for (uint8_t parameter_index = 0; parameter_index < a->op_call.parameters_size; ++parameter_index) {
+			if (!same_variable(a->op_call.parameters[parameter_index], b->op_call.parameters[parameter_index])) {
+				return false;
+			}
+		}
+		return true;
+	default:
+		if (a->op_binary.result.type != b->op_binary.result.type) {
+			return false;
+		}
+		if (same_variable(a->op_binary.left, b->op_binary.left) && same_variable(a->op_binary.right, b->op_binary.right)) {
+			return true;
+		}
+		return is_commutative(a) && same_variable(a->op_binary.left, b->op_binary.right) && same_variable(a->op_binary.right, b->op_binary.left);
+	}
+}
+
+// computations that only depend on their operands and write a temporary nothing else writes
+static bool is_reusable(ir_function *ir, opcode *o, ir_operands *operands) {
+	switch (o->type) {
+	case OPCODE_LOAD_FLOAT_CONSTANT:
+	case OPCODE_LOAD_INT_CONSTANT:
+	case OPCODE_LOAD_BOOL_CONSTANT:
+	case OPCODE_NOT:
+	case OPCODE_NEGATE:
+	case OPCODE_LOAD_ACCESS_LIST:
+	case OPCODE_MULTIPLY:
+	case OPCODE_DIVIDE:
+	case OPCODE_MOD:
+	case OPCODE_ADD:
+	case OPCODE_SUB:
+	case OPCODE_EQUALS:
+	case OPCODE_NOT_EQUALS:
+	case OPCODE_GREATER:
+	case OPCODE_GREATER_EQUAL:
+	case OPCODE_LESS:
+	case OPCODE_LESS_EQUAL:
+	case OPCODE_AND:
+	case OPCODE_OR:
+	case OPCODE_BITWISE_XOR:
+	case OPCODE_BITWISE_AND:
+	case OPCODE_BITWISE_OR:
+	case OPCODE_LEFT_SHIFT:
+	case OPCODE_RIGHT_SHIFT:
+		break;
+	case OPCODE_CALL:
+		if (!is_pure_call(o)) {
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+
+	return operands->definitions_size == 1 && operands->definitions[0]->kind == VARIABLE_INTERNAL &&
+	       ir->variables[operands->definitions[0]->index].definitions_size == 1;
+}
+
+static bool reads_variable(opcode *o, uint32_t variable_index) {
+	ir_operands operands;
+	ir_operands_of(o, &operands);
+	for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+		if (operands.uses[use_index]->index == variable_index) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// what a call of a user function or of an intrinsic like trace_ray can change: globals and its parameters
+static bool reads_call_results(opcode *o, opcode *call) {
+	ir_operands operands;
+	ir_operands_of(o, &operands);
+	for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+		if (operands.uses[use_index]->kind == VARIABLE_GLOBAL) {
+			return true;
+		}
+		for (uint8_t parameter_index = 0; parameter_index < call->op_call.parameters_size; ++parameter_index) {
+			if (operands.uses[use_index]->index == call->op_call.parameters[parameter_index].index) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// forgets the values that o changes
+static void kill_available_values(available_value **available, opcode *o) {
+	ir_operands operands;
+	ir_operands_of(o, &operands);
+
+	bool call = o->type == OPCODE_CALL && !is_pure_call(o);
+	if (operands.definitions_size == 0 && !call) {
+		return;
+	}
+
+	for (size_t value_index = 0; value_index < arrlenu(*available);) {
+		opcode *value  = (*available)[value_index].o;
+		bool    killed = call && reads_call_results(value, o);
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size && !killed; ++definition_index) {
+			killed = reads_variable(value, operands.definitions[definition_index]->index);
+		}
+
+		if (killed) {
+			arrdel(*available, value_index);
+		}
+		else {
+			++value_index;
+		}
+	}
+}
+
+static void close_scope(available_value **available, uint32_t depth) {
+	for (size_t value_index = 0; value_index < arrlenu(*available);) {
+		if ((*available)[value_index].depth > depth) {
+			arrdel(*available, value_index);
+		}
+		else {
+			++value_index;
+		}
+	}
+}
+
+// Reuses the result of an earlier load or computation with the same operands when nothing in between can have changed them,
+// like the repeated reads of a uniform member. Values flow from a block to the blocks it dominates, minus what the code that
+// can run in between, including the rest of a loop, writes.
+static void eliminate_common_subexpressions(function *f) {
+	ir_function ir;
+	if (!ir_build(&ir, f)) {
+		return;
+	}
+
+	uint32_t      blocks_size  = (uint32_t)arrlenu(ir.blocks);
+	uint32_t     *dominators   = find_immediate_dominators(&ir);
+	uint32_t     *replacements = (uint32_t *)calloc(ir.variables_size, sizeof(uint32_t));
+	debug_context context      = {0};
+	check(replacements != NULL || ir.variables_size == 0, context, "Could not allocate the replacements");
+
+	available_value **available_at_end = (available_value **)calloc(blocks_size, sizeof(available_value *));
+	check(available_at_end != NULL || blocks_size == 0, context, "Could not allocate the available values");
+
+	uint32_t removed = 0;
+	uint32_t depth   = 0;
+
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		ir_block *block = &ir.blocks[block_index];
+
+		available_value *available = NULL;
+		uint32_t         dominator = dominators[block_index];
+		if (dominator != IR_NO_BLOCK) {
+			arrsetlen(available, arrlenu(available_at_end[dominator]));
+			if (arrlenu(available) > 0) {
+				memcpy(available, available_at_end[dominator], arrlenu(available) * sizeof(available_value));
+			}
+			close_scope(&available, depth);
+
+			uint32_t last = block_index - 1;
+			for (size_t predecessor_index = 0; predecessor_index < arrlenu(block->predecessors); ++predecessor_index) {
+				if (block->predecessors[predecessor_index] > last) {
+					last = block->predecessors[predecessor_index];
+				}
+			}
+			for (uint32_t between = dominator + 1; between <= last && arrlenu(available) > 0; ++between) {
+				for (size_t instruction_index = 0; instruction_index < arrlenu(ir.blocks[between].instructions); ++instruction_index) {
+					if (ir.blocks[between].instructions[instruction_index] != NULL) {
+						kill_available_values(&available, ir.blocks[between].instructions[instruction_index]);
+					}
+				}
+			}
+		}
+
+		for (uint32_t instruction_index = 0; instruction_index < arrlenu(block->instructions); ++instruction_index) {
+			opcode *o = block->instructions[instruction_index];
+
+			ir_operands operands;
+			ir_operands_of(o, &operands);
+			for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+				if (replacements[operands.uses[use_index]->index] != 0) {
+					operands.uses[use_index]->index = replacements[operands.uses[use_index]->index];
+				}
+			}
+
+			if (o->type == OPCODE_BLOCK_START || o->type == OPCODE_WHILE_START) {
+				depth += 1;
+				continue;
+			}
+			if (o->type == OPCODE_BLOCK_END || o->type == OPCODE_WHILE_END) {
+				depth -= 1;
+				close_scope(&available, depth);
+				continue;
+			}
+
+			bool reusable = is_reusable(&ir, o, &operands);
+			if (reusable) {
+				bool found = false;
+				for (size_t value_index = 0; value_index < arrlenu(available); ++value_index) {
+					if (same_computation(available[value_index].o, o)) {
+						replacements[operands.definitions[0]->index] = available[value_index].result.index;
+						found                                        = true;
+						break;
+					}
+				}
+
+				if (found) {
+					ir_location location = {
+					    .block       = block_index,
+					    .instruction = instruction_index,
+					};
+					ir_remove(&ir, location);
+					removed += 1;
+					continue;
+				}
+			}
+
+			kill_available_values(&available, o);
+
+			if (reusable) {
+				available_value value = {
+				    .o      = o,
+				    .result = *operands.definitions[0],
+				    .depth  = depth,
+				};
+				arrput(available, value);
+			}
+		}
+
+		available_at_end[block_index] = available;
+	}
+
+	if (removed > 0) {
+		ir_write(&ir, &f->code);
+	}
+
+	for (uint32_t block_index = 0; block_index < blocks_size; ++block_index) {
+		arrfree(available_at_end[block_index]);
+	}
+	free(available_at_end);
+	free(replacements);
+	free(dominators);
+	ir_free(&ir);
+}
+
+// divisions and indexed loads can fault or read out of bounds, they must not run when the original program did not run them
+static bool can_trap(opcode *o) {
+	switch (o->type) {
+	case OPCODE_DIVIDE:
+	case OPCODE_MOD:
+		return true;
+	case OPCODE_LOAD_ACCESS_LIST:
+		for (uint8_t access_index = 0; access_index < o->op_load_access_list.access_list_size; ++access_index) {
+			if (o->op_load_access_list.access_list[access_index].kind == ACCESS_ELEMENT) {
+				return true;
+			}
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+// Moves the instructions of a loop that compute the same value in every iteration in front of the loop, the loops are done
+// inner ones first so what leaves an inner loop can move on out of the outer one. Only the condition and the top level of
+// the body are looked at, code in nested ifs and loops might not run at all. The body itself might not run at all either so
+// instructions that can trap are only moved out of the condition of a while loop, which always runs once.
+static void hoist_loop(ir_function *ir, uint32_t start_id, bool *changed_in_loop) {
+	function *f     = ir->f;
+	size_t    start = 0;
+	while (start < f->code.size) {
+		opcode *o = (opcode *)&f->code.o[start];
+		if (o->type == OPCODE_WHILE_START && o->op_while_start.start_id == start_id) {
+			break;
+		}
+		start += o->size;
+	}
+
+	size_t end   = start;
+	bool   calls = false;
+	memset(changed_in_loop, 0, ir->variables_size * sizeof(bool));
+
+	for (;;) {
+		opcode *o = (opcode *)&f->code.o[end];
+		end += o->size;
+
+		ir_operands operands;
+		ir_operands_of(o, &operands);
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+			changed_in_loop[operands.definitions[definition_index]->index] = true;
+		}
+		// a local declared in the loop starts over in every iteration and does not exist in front of it
+		if (o->type == OPCODE_VAR) {
+			changed_in_loop[o->op_var.var.index] = true;
+		}
+		if (o->type == OPCODE_CALL && !is_pure_call(o)) {
+			calls = true;
+		}
+
+		if (o->type == OPCODE_WHILE_END && o->op_while_end.start_id == start_id) {
+			break;
+		}
+	}
+
+	new_code.size = 0;
+
+	if (start > 0) {
+		opcodes_reserve(&new_code, start);
+		memcpy(new_code.o, f->code.o, start);
+		new_code.size = start;
+	}
+
+	bool          hoisted       = false;
+	bool          runs_on_entry = true;
+	uint32_t      depth         = 0;
+	bool         *moved         = (bool *)calloc(end - start, sizeof(bool));
+	debug_context context = {0};
+	check(moved != NULL, context, "Could not allocate the loop instructions");
+
+	for (size_t index = start; index < end; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+
+		if (o->type == OPCODE_BLOCK_START || (o->type == OPCODE_WHILE_CONDITION && depth == 1)) {
+			runs_on_entry = false;
+		}
+
+		switch (o->type) {
+		case OPCODE_WHILE_START:
+		case OPCODE_BLOCK_START:
+			++depth;
+			continue;
+		case OPCODE_WHILE_END:
+		case OPCODE_BLOCK_END:
+			--depth;
+			continue;
+		default:
+			break;
+		}
+
+		ir_operands operands;
+		ir_operands_of(o, &operands);
+
+		// the loop itself is depth one and its body two
+		if (depth > 2 || !is_reusable(ir, o, &operands) || (!runs_on_entry && can_trap(o))) {
+			continue;
+		}
+
+		bool invariant = true;
+		for (uint8_t use_index = 0; use_index < operands.uses_size && invariant; ++use_index) {
+			variable *v = operands.uses[use_index];
+			invariant   = !changed_in_loop[v->index] && (v->kind != VARIABLE_GLOBAL || !calls);
+		}
+
+		if (invariant) {
+			changed_in_loop[operands.definitions[0]->index] = false;
+			moved[index - start]                            = true;
+			hoisted                                         = true;
+			emit_op(&new_code, o);
+		}
+	}
+
+	if (hoisted) {
+		for (size_t index = start; index < end; index += ((opcode *)&f->code.o[index])->size) {
+			if (!moved[index - start]) {
+				emit_op(&new_code, (opcode *)&f->code.o[index]);
+			}
+		}
+
+		opcodes_reserve(&new_code, new_code.size + (f->code.size - end));
+		memcpy(&new_code.o[new_code.size], &f->code.o[end], f->code.size - end);
+		new_code.size += f->code.size - end;
+
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+	}
+
+	free(moved);
+}
+
+static void hoist_loop_invariants(function *f) {
+	uint32_t *loops = NULL;
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+		if (o->type == OPCODE_WHILE_END) {
+			arrput(loops, o->op_while_end.start_id);
+		}
+	}
+
+	ir_function ir;
+	if (arrlenu(loops) == 0 || !ir_build(&ir, f)) {
+		arrfree(loops);
+		return;
+	}
+
+	bool         *changed_in_loop = (bool *)malloc(ir.variables_size * sizeof(bool));
+	debug_context context         = {0};
+	check(changed_in_loop != NULL || ir.variables_size == 0, context, "Could not allocate the loop variables");
+
+	// moving instructions does not change how often variables are defined so the counts of the ir stay valid
+	for (size_t loop_index = 0; loop_index < arrlenu(loops); ++loop_index) {
+		hoist_loop(&ir, loops[loop_index], changed_in_loop);
+	}
+
+	free(changed_in_loop);
+	ir_free(&ir);
+	arrfree(loops);
+}
+
+// Backends that can not write swizzles of several components get them split into one load and store per component before
+// anything else runs. Fusing puts those back together when the other passes are done: component loads that only feed a
+// vector constructor become one swizzle load and stores to all components of a vector become one store of a constructed
+// vector. Stores to some of the components are only fused when the backend can write swizzles.
+
+static bool is_component_access(access *access_list, uint8_t access_list_size) {
+	access *last = &access_list[access_list_size - 1];
+	return last->kind == ACCESS_SWIZZLE && last->access_swizzle.swizzle.size == 1;
+}
+
+static bool is_straight_line(opcode *o) {
+	switch (o->type) {
+	case OPCODE_RETURN:
+	case OPCODE_DISCARD:
+	case OPCODE_IF:
+	case OPCODE_WHILE_START:
+	case OPCODE_WHILE_CONDITION:
+	case OPCODE_WHILE_END:
+	case OPCODE_WHILE_BODY:
+	case OPCODE_BLOCK_START:
+	case OPCODE_BLOCK_END:
+		return false;
+	default:
+		return true;
+	}
+}
+
+// whether o can change what an access of v reads or, when reads is set, depends on it
+static bool touches_access(opcode *o, variable v, access *access_list, uint8_t access_list_size, bool reads) {
+	if (!is_straight_line(o) || (o->type == OPCODE_CALL && !is_pure_call(o) && v.kind == VARIABLE_GLOBAL)) {
+		return true;
+	}
+
+	ir_operands operands;
+	ir_operands_of(o, &operands);
+
+	for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+		uint32_t index = operands.definitions[definition_index]->index;
+		if (index == v.index) {
+			return true;
+		}
+		for (uint8_t access_index = 0; access_index < access_list_size; ++access_index) {
+			if (access_list[access_index].kind == ACCESS_ELEMENT && access_list[access_index].access_element.index.index == index) {
+				return true;
+			}
+		}
+	}
+
+	return reads && reads_variable(o, v.index);
+}
+
+// the instructions of a function in order with the only definition of every temporary, where it is and how often every
+// variable is read
+typedef struct indexed_code {
+	opcode  **code; // stb_ds array
+	opcode  **definitions;
+	uint32_t *positions;
+	uint32_t *uses;
+} indexed_code;
+
+static void index_code(function *f, indexed_code *indexed) {
+	indexed->definitions = (opcode **)realloc(indexed->definitions, f->variables_end * sizeof(opcode *));
+	indexed->positions   = (uint32_t *)realloc(indexed->positions, f->variables_end * sizeof(uint32_t));
+	indexed->uses        = (uint32_t *)realloc(indexed->uses, f->variables_end * sizeof(uint32_t));
+
+	debug_context context = {0};
+	check(indexed->definitions != NULL && indexed->positions != NULL && indexed->uses != NULL, context, "Could not allocate the code index");
+
+	memset(indexed->definitions, 0, f->variables_end * sizeof(opcode *));
+	memset(indexed->positions, 0, f->variables_end * sizeof(uint32_t));
+	memset(indexed->uses, 0, f->variables_end * sizeof(uint32_t));
+	arrfree(indexed->code);
+
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+
+		ir_operands operands;
+		ir_operands_of(o, &operands);
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+			variable *v = operands.definitions[definition_index];
+			if (v->kind != VARIABLE_INTERNAL || v->index >= f->variables_end || indexed->positions[v->index] == UINT32_MAX) {
+				continue;
+			}
+			if (indexed->definitions[v->index] != NULL) {
+				indexed->definitions[v->index] = NULL;
+				indexed->positions[v->index]   = UINT32_MAX;
+			}
+			else {
+				indexed->definitions[v->index] = o;
+				indexed->positions[v->index]   = (uint32_t)arrlenu(indexed->code);
+			}
+		}
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			if (operands.uses[use_index]->index < f->variables_end) {
+				indexed->uses[operands.uses[use_index]->index] += 1;
+			}
+		}
+
+		arrput(indexed->code, o);
+	}
+}
+
+static type_id stored_vector_type(opcode *store) {
+	uint8_t prefix_size = store->op_store_access_list.access_list_size - 1;
+	return prefix_size > 0 ? store->op_store_access_list.access_list[prefix_size - 1].type : store->op_store_access_list.to.type;
+}
+
+static uint32_t stored_component(opcode *store) {
+	return store->op_store_access_list.access_list[store->op_store_access_list.access_list_size - 1].access_swizzle.swizzle.indices[0];
+}
+
+// the values of a run of component stores go into one vector which is written in place of the last store
+static void write_fused_store(opcode **stores, uint32_t stores_size, indexed_code *indexed) {
+	opcode  *first       = stores[0];
+	uint8_t  prefix_size = first->op_store_access_list.access_list_size - 1;
+	type_id  vector_type = stored_vector_type(first);
+	bool     full        = stores_size == vector_size(vector_type);
+	type_id  value_type  = full ? vector_type : vector_to_size(vector_type, stores_size);
+
+	// the components of a whole vector go in its order, the ones of a swizzle in the order of the stores
+	variable parameters[4];
+	uint32_t indices[4];
+	for (uint32_t store_index = 0; store_index < stores_size; ++store_index) {
+		uint32_t component = stored_component(stores[store_index]);
+		uint32_t position  = full ? component : store_index;
+
+		parameters[position] = stores[store_index]->op_store_access_list.from;
+		indices[position]    = component;
+	}
+
+	// a vector that was only taken apart to be stored is stored as it is
+	variable value  = {0};
+	bool     intact = true;
+	for (uint32_t position = 0; position < stores_size && intact; ++position) {
+		opcode *load = indexed->definitions[parameters[position].index];
+		intact       = load != NULL && load->type == OPCODE_LOAD_ACCESS_LIST && load->op_load_access_list.access_list_size == 1 &&
+		         load->op_load_access_list.from.kind == VARIABLE_INTERNAL && load->op_load_access_list.from.type == value_type &&
+		         (position == 0 || load->op_load_access_list.from.index == value.index) && is_component_access(load->op_load_access_list.access_list, 1) &&
+		         load->op_load_access_list.access_list[0].access_swizzle.swizzle.indices[0] == position;
+		if (intact) {
+			value = load->op_load_access_list.from;
+		}
+	}
+
+	if (!intact) {
+		value = allocate_variable(value_type, VARIABLE_INTERNAL);
+
+		opcode constructor_call = {
+		    .type = OPCODE_CALL,
+		    .op_call =
+		        {
+		            .func            = get_type(value_type)->name,
+		            .callee          = find_function(get_type(value_type)->name),
+		            .parameters      = {parameters[0], parameters[1], parameters[2], parameters[3]},
+		            .parameters_size = (uint8_t)stores_size,
+		            .var             = value,
+		        },
+		};
+		constructor_call.size = OP_SIZE_CALL(constructor_call);
+		emit_op(&new_code, &constructor_call);
+	}
+
+	if (full && prefix_size == 0) {
+		opcode store = {
+		    .type = OPCODE_STORE_VARIABLE,
+		    .op_store_var =
+		        {
+		            .from = value,
+		            .to   = first->op_store_access_list.to,
+		        },
+		};
+		store.size = OP_SIZE(store, op_store_var);
+		emit_op(&new_code, &store);
+		return;
+	}
+
+	opcode store;
+	memcpy(&store, first, first->size);
+	store.op_store_access_list.from = value;
+
+	if (full) {
+		store.op_store_access_list.access_list_size = prefix_size;
+	}
+	else {
+		access *swizzle_access                      = &store.op_store_access_list.access_list[prefix_size];
+		swizzle_access->type                        = value_type;
+		swizzle_access->access_swizzle.swizzle.size = stores_size;
+		memcpy(swizzle_access->access_swizzle.swizzle.indices, indices, sizeof(indices));
+	}
+
+	store.size = OP_SIZE_ACCESS_LIST(store, op_store_access_list);
+	emit_op(&new_code, &store);
+}
+
+static bool is_component_store(opcode *o) {
+	return o->type == OPCODE_STORE_ACCESS_LIST && o->op_store_access_list.from.kind == VARIABLE_INTERNAL && !is_texture(o->op_store_access_list.to.type) &&
+	       is_component_access(o->op_store_access_list.access_list, o->op_store_access_list.access_list_size);
+}
+
+static bool fits_store_run(opcode *first, opcode *o, uint32_t components) {
+	return is_component_store(o) && same_variable(first->op_store_access_list.to, o->op_store_access_list.to) &&
+	       first->op_store_access_list.access_list_size == o->op_store_access_list.access_list_size &&
+	       same_access_list(first->op_store_access_list.access_list, o->op_store_access_list.access_list, o->op_store_access_list.access_list_size - 1) &&
+	       (components & (1u << stored_component(o))) == 0;
+}
+
+// writes the code with fused stores to new_code, returns false and writes nothing when no stores fit together
+static bool fuse_component_stores(function *f, indexed_code *indexed, bool swizzle_stores) {
+	uint32_t  code_size = (uint32_t)arrlenu(indexed->code);
+	bool     *removed   = (bool *)calloc(code_size + 1, sizeof(bool));
+	uint32_t *fused_at  = (uint32_t *)calloc(code_size + 1, sizeof(uint32_t));
+	opcode  **runs      = NULL; // four stores per run, unused ones are NULL
+
+	debug_context context = {0};
+	check(removed != NULL && fused_at != NULL, context, "Could not allocate the fused stores");
+
+	for (uint32_t index = 0; index < code_size; ++index) {
+		opcode *first = indexed->code[index];
+		if (removed[index] || !is_component_store(first)) {
+			continue;
+		}
+
+		uint8_t  prefix_size = first->op_store_access_list.access_list_size - 1;
+		uint32_t size        = vector_size(stored_vector_type(first));
+
+		uint32_t positions[4]   = {index};
+		uint32_t positions_size = 1;
+		uint32_t components     = 1u << stored_component(first);
+
+		for (uint32_t next = index + 1; next < code_size && positions_size < size; ++next) {
+			opcode *o = indexed->code[next];
+			if (!removed[next] && fits_store_run(first, o, components)) {
+				components |= 1u << stored_component(o);
+				positions[positions_size] = next;
+				positions_size += 1;
+			}
+			else if (touches_access(o, first->op_store_access_list.to, first->op_store_access_list.access_list, prefix_size, true)) {
+				break;
+			}
+		}
+
+		// a whole vector without an access is written as a variable which only locals can take
+		bool full = positions_size == size && (prefix_size > 0 || first->op_store_access_list.to.kind == VARIABLE_LOCAL);
+		if (positions_size < 2 || (!full && !swizzle_stores) || (positions_size == size && !full)) {
+			continue;
+		}
+
+		for (uint32_t position_index = 0; position_index < 4; ++position_index) {
+			arrput(runs, position_index < positions_size ? indexed->code[positions[position_index]] : NULL);
+			if (position_index < positions_size) {
+				removed[positions[position_index]] = true;
+			}
+		}
+		fused_at[positions[positions_size - 1]] = (uint32_t)arrlenu(runs) / 4;
+	}
+
+	bool fused = arrlenu(runs) > 0;
+
+	if (fused) {
+		new_code.size = 0;
+
+		begin_function_variables(f);
+
+		for (uint32_t index = 0; index < code_size; ++index) {
+			if (fused_at[index] != 0) {
+				opcode **stores      = &runs[(fused_at[index] - 1) * 4];
+				uint32_t stores_size = 0;
+				while (stores_size < 4 && stores[stores_size] != NULL) {
+					++stores_size;
+				}
+				write_fused_store(stores, stores_size, indexed);
+			}
+			else if (!removed[index]) {
+				emit_op(&new_code, indexed->code[index]);
+			}
+		}
+
+		end_function_variables(f);
+	}
+
+	arrfree(runs);
+	free(fused_at);
+	free(removed);
+
+	return fused;
+}
+
+static bool is_vector_constructor(opcode *o) {
+	return o->type == OPCODE_CALL && is_vector(o->op_call.var.type) && o->op_call.func == get_type(o->op_call.var.type)->name &&
+	       o->op_call.parameters_size == vector_size(o->op_call.var.type);
+}
+
+// whether a parameter of a constructor comes from the same vector as the first one
+static bool fits_load_run(opcode *first, opcode *load, opcode *constructor) {
+	return load != NULL && load->type == OPCODE_LOAD_ACCESS_LIST && load->op_load_access_list.to.type == vector_base_type(constructor->op_call.var.type) &&
+	       !is_texture(load->op_load_access_list.from.type) &&
+	       is_component_access(load->op_load_access_list.access_list, load->op_load_access_list.access_list_size) &&
+	       same_variable(first->op_load_access_list.from, load->op_load_access_list.from) &&
+	       first->op_load_access_list.access_list_size == load->op_load_access_list.access_list_size &&
+	       same_access_list(first->op_load_access_list.access_list, load->op_load_access_list.access_list, load->op_load_access_list.access_list_size - 1);
+}
+
+// writes the code with fused loads to new_code, returns false and writes nothing when no constructor only takes components
+static bool fuse_component_loads(indexed_code *indexed) {
+	uint32_t  code_size = (uint32_t)arrlenu(indexed->code);
+	bool     *removed   = (bool *)calloc(code_size + 1, sizeof(bool));
+	uint32_t *replaced  = (uint32_t *)calloc(code_size + 1, sizeof(uint32_t));
+	opcode   *loads     = NULL;
+
+	debug_context context = {0};
+	check(removed != NULL && replaced != NULL, context, "Could not allocate the fused loads");
+
+	for (uint32_t index = 0; index < code_size; ++index) {
+		opcode *o = indexed->code[index];
+		if (!is_vector_constructor(o)) {
+			continue;
+		}
+
+		opcode  *first = NULL;
+		uint32_t start = index;
+		for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+			variable parameter = o->op_call.parameters[parameter_index];
+			opcode  *load      = parameter.kind == VARIABLE_INTERNAL && indexed->uses[parameter.index] == 1 ? indexed->definitions[parameter.index] : NULL;
+			if (parameter_index == 0) {
+				first = load;
+			}
+			if (first == NULL || !fits_load_run(first, load, o) || indexed->positions[parameter.index] > index) {
+				first = NULL;
+				break;
+			}
+			start = indexed->positions[parameter.index] < start ? indexed->positions[parameter.index] : start;
+		}
+
+		if (first == NULL) {
+			continue;
+		}
+
+		uint8_t prefix_size = first->op_load_access_list.access_list_size - 1;
+		bool    unchanged   = true;
+		for (uint32_t between = start + 1; between < index && unchanged; ++between) {
+			unchanged = !touches_access(indexed->code[between], first->op_load_access_list.from, first->op_load_access_list.access_list, prefix_size, false);
+		}
+
+		if (!unchanged) {
+			continue;
+		}
+
+		opcode load;
+		memcpy(&load, first, first->size);
+		load.op_load_access_list.to = o->op_call.var;
+
+		access *swizzle_access                      = &load.op_load_access_list.access_list[prefix_size];
+		swizzle_access->type                        = o->op_call.var.type;
+		swizzle_access->access_swizzle.swizzle.size = o->op_call.parameters_size;
+
+		// a whole vector in order needs no swizzle unless there is nothing else to access
+		bool identity = prefix_size > 0 && first->op_load_access_list.access_list[prefix_size - 1].type == o->op_call.var.type;
+		for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+			uint32_t position  = indexed->positions[o->op_call.parameters[parameter_index].index];
+			uint32_t component = indexed->code[position]->op_load_access_list.access_list[prefix_size].access_swizzle.swizzle.indices[0];
+
+			swizzle_access->access_swizzle.swizzle.indices[parameter_index] = component;
+			identity                                                        = identity && component == parameter_index;
+			removed[position]                                               = true;
+		}
 
-static void copy_opcode(opcode *o) {
-	uint8_t *new_data = &new_code.o[new_code.size];
+		if (identity) {
+			load.op_load_access_list.access_list_size = prefix_size;
+		}
 
-	assert(new_code.size + o->size < OPCODES_SIZE);
+		load.size = OP_SIZE_ACCESS_LIST(load, op_load_access_list);
+		arrput(loads, load);
+		replaced[index] = (uint32_t)arrlenu(loads);
+	}
 
-	memcpy(new_data, o, o->size);
+	bool fused = arrlenu(loads) > 0;
 
-	new_code.size += o->size;
+	if (fused) {
+		new_code.size = 0;
+
+		for (uint32_t index = 0; index < code_size; ++index) {
+			if (replaced[index] != 0) {
+				emit_op(&new_code, &loads[replaced[index] - 1]);
+			}
+			else if (!removed[index]) {
+				emit_op(&new_code, indexed->code[index]);
+			}
+		}
+	}
+
+	arrfree(loads);
+	free(replaced);
+	free(removed);
+
+	return fused;
+}
+
+// Stores go first, the constructors they leave behind can then turn into swizzle loads. Returns whether the code changed, the
+// components of a vector that is stored as it is are left for eliminate_dead_code.
+static bool fuse_components(function *f, bool swizzle_stores) {
+	indexed_code indexed = {0};
+	bool         changed = false;
+
+	index_code(f, &indexed);
+	if (fuse_component_stores(f, &indexed, swizzle_stores)) {
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+		changed          = true;
+
+		index_code(f, &indexed);
+	}
+
+	if (fuse_component_loads(&indexed)) {
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+		changed          = true;
+	}
+
+	arrfree(indexed.code);
+	free(indexed.definitions);
+	free(indexed.positions);
+	free(indexed.uses);
+
+	return changed;
+}
+
+// Inlining pastes the code of a user function in place of a call. Variables and labels of the callee are moved behind the
+// ones of the caller, parameters become copies of the arguments unless the callee never writes them and the final return
+// value replaces the result of the call.
+
+#define INLINE_MAX_OPCODES 24
+
+#define FUNCTION_VISITING  1
+#define FUNCTION_OPTIMIZED 2
+
+static uint8_t  *function_states;
+static uint32_t *call_sites;
+static bool     *entry_points;
+
+static uint32_t count_opcodes(function *f) {
+	uint32_t count = 0;
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		++count;
+	}
+	return count;
+}
+
+static bool writes_variable(function *f, uint32_t variable_index) {
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		ir_operands operands;
+		ir_operands_of((opcode *)&f->code.o[index], &operands);
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+			if (operands.definitions[definition_index]->index == variable_index) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static bool calls_user_functions(function *f) {
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+		if (o->type == OPCODE_CALL && o->op_call.callee != NO_FUNCTION && get_function(o->op_call.callee)->block != NULL) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// resources can only be passed along, not copied into locals
+static bool is_copyable(type_id t) {
+	return !is_texture(t) && !is_sampler(t) && t != bvh_type_id && get_type(t)->array_size == 0;
+}
+
+// Backends recognize the inputs and outputs of entry points by their types, so code that brings more variables of those
+// types into an entry point stays a call.
+static bool uses_stage_types(function *f, function *callee) {
+	uint32_t start = first_function_variable_index();
+
+	for (size_t index = 0; index < callee->code.size; index += ((opcode *)&callee->code.o[index])->size) {
+		opcode *o = (opcode *)&callee->code.o[index];
+
+		variable   *variables[70];
+		uint8_t     variables_size = 0;
+		ir_operands operands;
+		ir_operands_of(o, &operands);
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			variables[variables_size++] = operands.uses[use_index];
+		}
+		for (uint8_t definition_index = 0; definition_index < operands.definitions_size; ++definition_index) {
+			variables[variables_size++] = operands.definitions[definition_index];
+		}
+		if (o->type == OPCODE_VAR) {
+			variables[variables_size++] = &o->op_var.var;
+		}
+
+		for (uint8_t variable_index = 0; variable_index < variables_size; ++variable_index) {
+			type_id t = variables[variable_index]->type;
+			if (variables[variable_index]->index < start || get_type(t)->built_in) {
+				continue;
+			}
+			if (t == f->return_type.type) {
+				return true;
+			}
+			for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
+				if (t == f->parameter_types[parameter_index].type) {
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+// the only return has to be the last instruction of the function and not be nested
+static bool returns_at_end(function *f) {
+	uint32_t depth = 0;
+
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+
+		switch (o->type) {
+		case OPCODE_BLOCK_START:
+		case OPCODE_WHILE_START:
+			++depth;
+			break;
+		case OPCODE_BLOCK_END:
+		case OPCODE_WHILE_END:
+			--depth;
+			break;
+		case OPCODE_RETURN:
+			if (depth != 0 || index + o->size != f->code.size) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return true;
+}
+
+static bool should_inline(function *f, opcode *call) {
+	if (call->op_call.callee == NO_FUNCTION) {
+		return false;
+	}
+
+	function   *callee    = get_function(call->op_call.callee);
+	function_id callee_id = call->op_call.callee;
+
+	if (callee->block == NULL || callee == f || function_states[callee_id] != FUNCTION_OPTIMIZED || entry_points[callee_id] ||
+	    has_attribute(&callee->attributes, names.noinline_attribute)) {
+		return false;
+	}
+
+	if (!has_attribute(&callee->attributes, names.inline_attribute) && count_opcodes(callee) > INLINE_MAX_OPCODES && call_sites[callee_id] > 1) {
+		return false;
+	}
+
+	if (call->op_call.parameters_size != callee->parameters_size || !returns_at_end(callee)) {
+		return false;
+	}
+
+	return !entry_points[get_function_id(f)] || !uses_stage_types(f, callee);
+}
+
+typedef struct inlined_variables {
+	uint32_t  start;
+	uint32_t  offset;   // added to the variables and labels of the callee
+	variable *replaced; // the arguments the parameters are replaced with, indexed by callee variable minus start
+	bool     *is_replaced;
+} inlined_variables;
+
+static variable map_variable(inlined_variables *mapping, variable v) {
+	if (v.index < mapping->start) {
+		return v;
+	}
+	if (mapping->is_replaced[v.index - mapping->start]) {
+		return mapping->replaced[v.index - mapping->start];
+	}
+	v.index += mapping->offset;
+	return v;
+}
+
+static void map_opcode(inlined_variables *mapping, opcode *o) {
+	variable   *mapped[70];
+	uint8_t     mapped_size = 0;
+	ir_operands operands;
+	ir_operands_of(o, &operands);
+
+	// compound stores list their target as a use and a definition
+	for (uint8_t index = 0; index < operands.uses_size + operands.definitions_size; ++index) {
+		variable *v = index < operands.uses_size ? operands.uses[index] : operands.definitions[index - operands.uses_size];
+
+		bool seen = false;
+		for (uint8_t mapped_index = 0; mapped_index < mapped_size && !seen; ++mapped_index) {
+			seen = mapped[mapped_index] == v;
+		}
+
+		if (!seen) {
+			*v                    = map_variable(mapping, *v);
+			mapped[mapped_size++] = v;
+		}
+	}
+
+	switch (o->type) {
+	case OPCODE_VAR:
+		o->op_var.var = map_variable(mapping, o->op_var.var);
+		break;
+	case OPCODE_IF:
+		o->op_if.start_id += mapping->offset;
+		o->op_if.end_id += mapping->offset;
+		break;
+	case OPCODE_WHILE_START:
+		o->op_while_start.start_id += mapping->offset;
+		o->op_while_start.continue_id += mapping->offset;
+		o->op_while_start.end_id += mapping->offset;
+		break;
+	case OPCODE_WHILE_CONDITION:
+		o->op_while.end_id += mapping->offset;
+		break;
+	case OPCODE_WHILE_END:
+		o->op_while_end.start_id += mapping->offset;
+		o->op_while_end.continue_id += mapping->offset;
+		o->op_while_end.end_id += mapping->offset;
+		break;
+	case OPCODE_BLOCK_START:
+	case OPCODE_BLOCK_END:
+		o->op_block.id += mapping->offset;
+		break;
+	default:
+		break;
+	}
+}
+
+// Writes the code of the callee to new_code and sets the variable that holds the result, returns false and writes nothing
+// when the call has to stay.
+static bool inline_call(function *f, opcode *call, variable *result) {
+	function *callee = get_function(call->op_call.callee);
+	uint32_t  start  = first_function_variable_index();
+	uint32_t  size   = callee->variables_end - start;
+
+	inlined_variables mapping;
+	mapping.start       = start;
+	mapping.offset      = f->variables_end - start;
+	mapping.replaced    = (variable *)malloc(size * sizeof(variable));
+	mapping.is_replaced = (bool *)calloc(size, sizeof(bool));
+
+	debug_context context = {0};
+	check((mapping.replaced != NULL && mapping.is_replaced != NULL) || size == 0, context, "Could not allocate the inlined variables");
+	check(f->variables_end <= UINT32_MAX - size, context, "Too many variables");
+
+	variable parameters[256];
+	bool     copied[256] = {0};
+	bool     inlinable   = true;
+
+	for (uint8_t parameter_index = 0; parameter_index < callee->parameters_size && inlinable; ++parameter_index) {
+		inlinable = false;
+		for (size_t var_index = 0; var_index < callee->block->block.vars.size; ++var_index) {
+			local_variable *var = &callee->block->block.vars.v[var_index];
+			if (var->name == callee->parameter_names[parameter_index]) {
+				parameters[parameter_index].kind  = VARIABLE_LOCAL;
+				parameters[parameter_index].index = var->variable_id;
+				parameters[parameter_index].type  = var->type.type;
+				inlinable                         = true;
+				break;
+			}
+		}
+		if (!inlinable) {
+			break;
+		}
+
+		variable parameter = parameters[parameter_index];
+		variable argument  = call->op_call.parameters[parameter_index];
+
+		// a global can change while the callee runs unless it is a resource or nothing in the callee writes it
+		bool stable = argument.kind != VARIABLE_GLOBAL || !is_copyable(argument.type) ||
+		              (!writes_variable(callee, argument.index) && !calls_user_functions(callee));
+
+		if (argument.type == parameter.type && stable && !writes_variable(callee, parameter.index)) {
+			mapping.replaced[parameter.index - start]    = argument;
+			mapping.is_replaced[parameter.index - start] = true;
+		}
+		else if (is_copyable(parameter.type)) {
+			copied[parameter_index] = true;
+		}
+		else {
+			inlinable = false;
+		}
+	}
+
+	opcode *last = NULL;
+	for (size_t index = 0; index < callee->code.size; index += ((opcode *)&callee->code.o[index])->size) {
+		last = (opcode *)&callee->code.o[index];
+	}
+	bool returns = last != NULL && last->type == OPCODE_RETURN;
+
+	if (inlinable && call->op_call.var.index != 0) {
+		// the result has to be a variable of the callee that nothing changes afterwards
+		inlinable = returns && last->size > offsetof(opcode, op_return) && last->op_return.var.index >= start &&
+		            !mapping.is_replaced[last->op_return.var.index - start] && last->op_return.var.type == call->op_call.var.type;
+	}
+
+	if (!inlinable) {
+		free(mapping.replaced);
+		free(mapping.is_replaced);
+		return false;
+	}
+
+	for (uint8_t parameter_index = 0; parameter_index < callee->parameters_size; ++parameter_index) {
+		if (!copied[parameter_index]) {
+			continue;
+		}
+
+		variable parameter = map_variable(&mapping, parameters[parameter_index]);
+
+		opcode var;
+		var.type       = OPCODE_VAR;
+		var.size       = OP_SIZE(var, op_var);
+		var.op_var.var = parameter;
+		emit_op(&new_code, &var);
+
+		opcode store;
+		store.type              = OPCODE_STORE_VARIABLE;
+		store.size              = OP_SIZE(store, op_store_var);
+		store.op_store_var.from = call->op_call.parameters[parameter_index];
+		store.op_store_var.to   = parameter;
+		emit_op(&new_code, &store);
+	}
+
+	for (size_t index = 0; index < callee->code.size; index += ((opcode *)&callee->code.o[index])->size) {
+		opcode *o = (opcode *)&callee->code.o[index];
+		if (o == last && returns) {
+			break;
+		}
+
+		opcode copy;
+		memcpy(&copy, o, o->size);
+		map_opcode(&mapping, &copy);
+		emit_op(&new_code, &copy);
+	}
+
+	if (call->op_call.var.index != 0) {
+		*result = map_variable(&mapping, last->op_return.var);
+	}
+
+	f->variables_end += size;
+
+	free(mapping.replaced);
+	free(mapping.is_replaced);
+
+	return true;
+}
+
+static void inline_calls(function *f) {
+	struct {
+		uint32_t key;
+		variable value;
+	} *results = NULL;
+
+	bool inlined = false;
+
+	new_code.size = 0;
+
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode copy;
+		memcpy(&copy, (opcode *)&f->code.o[index], ((opcode *)&f->code.o[index])->size);
+
+		ir_operands operands;
+		ir_operands_of(&copy, &operands);
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			ptrdiff_t result_index = hmgeti(results, operands.uses[use_index]->index);
+			if (result_index >= 0) {
+				*operands.uses[use_index] = results[result_index].value;
+			}
+		}
+
+		variable result;
+		if (copy.type == OPCODE_CALL && should_inline(f, &copy) && inline_call(f, &copy, &result)) {
+			if (copy.op_call.var.index != 0) {
+				hmput(results, copy.op_call.var.index, result);
+			}
+			inlined = true;
+		}
+		else {
+			emit_op(&new_code, &copy);
+		}
+	}
+
+	hmfree(results);
+
+	if (inlined) {
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+	}
+}
+
+// A local that is written once with a temporary or an unchanged parameter and only read after that write in the same scope
+// is the same value under another name. Its reads take the value directly and the copy goes, the declaration is left for
+// eliminate_dead_code.
+
+static bool is_propagated_copy(ir_function *ir, opcode *o, bool *passed) {
+	if (o->type != OPCODE_STORE_VARIABLE) {
+		return false;
+	}
+
+	variable from = o->op_store_var.from;
+	variable to   = o->op_store_var.to;
+
+	if (to.kind != VARIABLE_LOCAL || to.index >= ir->variables_size || ir->variables[to.index].definitions_size != 1 || passed[to.index] ||
+	    is_parameter(ir->f, to.index) || from.type != to.type || !is_copyable(to.type) || !get_type(to.type)->built_in) {
+		return false;
+	}
+
+	if (from.kind == VARIABLE_INTERNAL) {
+		return from.index < ir->variables_size && ir->variables[from.index].definitions_size == 1;
+	}
+
+	return from.kind == VARIABLE_LOCAL && from.index < ir->variables_size && ir->variables[from.index].definitions_size == 0 && !passed[from.index] &&
+	       is_parameter(ir->f, from.index);
+}
+
+static void propagate_copies(function *f) {
+	ir_function ir;
+	if (!ir_build(&ir, f)) {
+		return;
+	}
+
+	opcode  **code       = NULL;
+	uint32_t *scope_ends = NULL; // for every instruction where the innermost block or loop around it ends
+	uint32_t *scopes     = NULL; // stb_ds stack of the instructions that opened the blocks and loops
+
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+
+		if (o->type == OPCODE_BLOCK_END || o->type == OPCODE_WHILE_END) {
+			uint32_t start = arrpop(scopes);
+			for (uint32_t inner = start; inner < arrlenu(code); ++inner) {
+				scope_ends[inner] = scope_ends[inner] == UINT32_MAX ? (uint32_t)arrlenu(code) : scope_ends[inner];
+			}
+		}
+
+		arrput(code, o);
+		arrput(scope_ends, UINT32_MAX);
+
+		if (o->type == OPCODE_BLOCK_START || o->type == OPCODE_WHILE_START) {
+			arrput(scopes, (uint32_t)arrlenu(code));
+		}
+	}
+
+	uint32_t      code_size    = (uint32_t)arrlenu(code);
+	bool         *passed       = (bool *)calloc(ir.variables_size + 1, sizeof(bool));
+	uint32_t     *first_uses   = (uint32_t *)malloc((ir.variables_size + 1) * sizeof(uint32_t));
+	uint32_t     *last_uses    = (uint32_t *)calloc(ir.variables_size + 1, sizeof(uint32_t));
+	variable     *replacements = (variable *)calloc(ir.variables_size + 1, sizeof(variable));
+	debug_context context      = {0};
+	check(passed != NULL && first_uses != NULL && last_uses != NULL && replacements != NULL, context, "Could not allocate the copies");
+
+	memset(first_uses, 0xff, (ir.variables_size + 1) * sizeof(uint32_t));
+
+	for (uint32_t index = 0; index < code_size; ++index) {
+		opcode *o = code[index];
+
+		// calls like trace_ray write what they are handed
+		if (o->type == OPCODE_CALL && !is_pure_call(o)) {
+			for (uint8_t parameter_index = 0; parameter_index < o->op_call.parameters_size; ++parameter_index) {
+				if (o->op_call.parameters[parameter_index].index < ir.variables_size) {
+					passed[o->op_call.parameters[parameter_index].index] = true;
+				}
+			}
+		}
+
+		ir_operands operands;
+		ir_operands_of(o, &operands);
+		for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+			uint32_t variable_index = operands.uses[use_index]->index;
+			if (variable_index < ir.variables_size) {
+				first_uses[variable_index] = first_uses[variable_index] == UINT32_MAX ? index : first_uses[variable_index];
+				last_uses[variable_index]  = index;
+			}
+		}
+	}
+
+	bool *removed    = (bool *)calloc(code_size + 1, sizeof(bool));
+	bool  propagated = false;
+	check(removed != NULL, context, "Could not allocate the copies");
+
+	for (uint32_t index = 0; index < code_size; ++index) {
+		opcode *o = code[index];
+		if (!is_propagated_copy(&ir, o, passed)) {
+			continue;
+		}
+
+		uint32_t to        = o->op_store_var.to.index;
+		uint32_t scope_end = scope_ends[index] == UINT32_MAX ? code_size : scope_ends[index];
+		if (first_uses[to] != UINT32_MAX && (first_uses[to] < index || last_uses[to] >= scope_end)) {
+			continue;
+		}
+
+		replacements[to] = o->op_store_var.from;
+		removed[index]   = true;
+		propagated       = true;
+	}
+
+	if (propagated) {
+		new_code.size = 0;
+
+		for (uint32_t index = 0; index < code_size; ++index) {
+			if (removed[index]) {
+				continue;
+			}
+
+			opcode copy;
+			memcpy(&copy, code[index], code[index]->size);
+
+			ir_operands operands;
+			ir_operands_of(&copy, &operands);
+			for (uint8_t use_index = 0; use_index < operands.uses_size; ++use_index) {
+				variable *use = operands.uses[use_index];
+				if (use->index < ir.variables_size && replacements[use->index].index != 0) {
+					*use = replacements[use->index];
+				}
+			}
+
+			emit_op(&new_code, &copy);
+		}
+
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+	}
+
+	free(removed);
+	free(replacements);
+	free(last_uses);
+	free(first_uses);
+	free(passed);
+	arrfree(scopes);
+	arrfree(scope_ends);
+	arrfree(code);
+	ir_free(&ir);
+}
+
+// only the entry points and what they call end up in the output
+static bool *find_exported_functions(void) {
+	function_id functions_count = 0;
+	while (get_function(functions_count) != NULL) {
+		++functions_count;
+	}
+
+	bool         *exported = (bool *)calloc(functions_count + 1, sizeof(bool));
+	debug_context context  = {0};
+	check(exported != NULL, context, "Could not allocate the exported functions");
+
+	function *entry_points[1024];
+	size_t    entry_points_size = 0;
+	find_entry_points(entry_points, &entry_points_size);
+
+	for (size_t entry_point_index = 0; entry_point_index < entry_points_size; ++entry_point_index) {
+		function *functions[256];
+		size_t    functions_size = 1;
+		functions[0]             = entry_points[entry_point_index];
+		find_referenced_functions(functions[0], functions, &functions_size);
+
+		for (size_t function_index = 0; function_index < functions_size; ++function_index) {
+			exported[get_function_id(functions[function_index])] = true;
+		}
+	}
+
+	return exported;
+}
+
+// callees are optimized first so inlining pastes code that is already optimized
+static void optimize_function(function *f, uint32_t flags) {
+	function_id id = get_function_id(f);
+	if (function_states[id] != 0) {
+		return;
+	}
+	function_states[id] = FUNCTION_VISITING;
+
+	for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+		opcode *o = (opcode *)&f->code.o[index];
+		if (o->type == OPCODE_CALL && o->op_call.callee != NO_FUNCTION && get_function(o->op_call.callee)->block != NULL) {
+			optimize_function(get_function(o->op_call.callee), flags);
+		}
+	}
+
+	if ((flags & TRANSFORM_FLAG_INLINE) != 0) {
+		inline_calls(f);
+	}
+	if ((flags & TRANSFORM_FLAG_FOLD_CONSTANTS) != 0) {
+		fold_constants(f);
+	}
+	if ((flags & TRANSFORM_FLAG_PROPAGATE_COPIES) != 0) {
+		propagate_copies(f);
+	}
+	if ((flags & TRANSFORM_FLAG_LOOP_INVARIANTS) != 0) {
+		hoist_loop_invariants(f);
+	}
+	if ((flags & TRANSFORM_FLAG_COMMON_SUBEXPRESSIONS) != 0) {
+		eliminate_common_subexpressions(f);
+	}
+	if ((flags & TRANSFORM_FLAG_DEAD_CODE) != 0) {
+		eliminate_dead_code(f);
+	}
+
+	function_states[id] = FUNCTION_OPTIMIZED;
+}
+
+static void optimize_functions(uint32_t flags) {
+	function_id functions_count = 0;
+	while (get_function(functions_count) != NULL) {
+		++functions_count;
+	}
+
+	bool *exported  = find_exported_functions();
+	function_states = (uint8_t *)calloc(functions_count + 1, sizeof(uint8_t));
+	call_sites      = (uint32_t *)calloc(functions_count + 1, sizeof(uint32_t));
+	entry_points    = (bool *)calloc(functions_count + 1, sizeof(bool));
+
+	debug_context context = {0};
+	check(function_states != NULL && call_sites != NULL && entry_points != NULL, context, "Could not allocate the function states");
+
+	for (function_id i = 0; i < functions_count; ++i) {
+		function *f = get_function(i);
+		if (!exported[i]) {
+			continue;
+		}
+
+		for (size_t index = 0; index < f->code.size; index += ((opcode *)&f->code.o[index])->size) {
+			opcode *o = (opcode *)&f->code.o[index];
+			if (o->type == OPCODE_CALL && o->op_call.callee != NO_FUNCTION) {
+				call_sites[o->op_call.callee] += 1;
+			}
+		}
+	}
+
+	function *entry_point_functions[1024];
+	size_t    entry_points_size = 0;
+	find_entry_points(entry_point_functions, &entry_points_size);
+
+	for (size_t entry_point_index = 0; entry_point_index < entry_points_size; ++entry_point_index) {
+		entry_points[get_function_id(entry_point_functions[entry_point_index])] = true;
+	}
+
+	for (size_t entry_point_index = 0; entry_point_index < entry_points_size; ++entry_point_index) {
+		optimize_function(entry_point_functions[entry_point_index], flags);
+	}
+
+	// fused accesses would hide the single components from common subexpressions in the functions they get inlined into
+	if ((flags & TRANSFORM_FLAG_FUSE_COMPONENTS) != 0) {
+		for (function_id i = 0; i < functions_count; ++i) {
+			function *f = get_function(i);
+			if (function_states[i] == FUNCTION_OPTIMIZED && fuse_components(f, (flags & TRANSFORM_FLAG_SWIZZLE_STORES) != 0) &&
+			    (flags & TRANSFORM_FLAG_DEAD_CODE) != 0) {
+				eliminate_dead_code(f);
+			}
+		}
+	}
+
+	free(exported);
+	free(function_states);
+	free(call_sites);
+	free(entry_points);
+	function_states = NULL;
+	call_sites      = NULL;
+	entry_points    = NULL;
 }
 
 void transform(uint32_t flags) {
+	init_names();
+
 	for (function_id i = 0; get_function(i) != NULL; ++i) {
 		function *f = get_function(i);
 
@@ -32,6 +2968,8 @@ void transform(uint32_t flags) {
 
 		new_code.size = 0;
 
+		begin_function_variables(f);
+
 		size_t index = 0;
 		while (index < size) {
 			opcode *o = (opcode *)&data[index];
@@ -41,16 +2979,12 @@ void transform(uint32_t flags) {
 				access a = o->op_store_access_list.access_list[o->op_store_access_list.access_list_size - 1];
 
 				if ((flags & TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE) != 0 && a.kind == ACCESS_SWIZZLE && a.access_swizzle.swizzle.size > 1) {
-					assert(is_vector(o->op_store_access_list.from.type.type));
+					assert(is_vector(o->op_store_access_list.from.type));
 
-					type_id from_base_type = vector_base_type(o->op_store_access_list.from.type.type);
-
-					type_ref from_base_type_ref;
-					init_type_ref(&from_base_type_ref, NO_NAME);
-					from_base_type_ref.type = from_base_type;
+					type_id from_base_type = vector_base_type(o->op_store_access_list.from.type);
 
 					for (uint32_t swizzle_index = 0; swizzle_index < a.access_swizzle.swizzle.size; ++swizzle_index) {
-						variable from = allocate_variable(from_base_type_ref, o->op_store_access_list.from.kind);
+						variable from = allocate_variable(from_base_type, o->op_store_access_list.from.kind);
 
 						opcode from_opcode = {
 						    .type = OPCODE_LOAD_ACCESS_LIST,
@@ -73,11 +3007,12 @@ void transform(uint32_t flags) {
                                     }},
 						        },
 						};
-						from_opcode.size = OP_SIZE(from_opcode, op_load_access_list);
+						from_opcode.size = OP_SIZE_ACCESS_LIST(from_opcode, op_load_access_list);
 
 						copy_opcode(&from_opcode);
 
-						opcode new_opcode = *o;
+						opcode new_opcode;
+						memcpy(&new_opcode, o, o->size);
 
 						new_opcode.op_store_access_list.from = from;
 
@@ -98,20 +3033,17 @@ void transform(uint32_t flags) {
 				access a = o->op_load_access_list.access_list[o->op_load_access_list.access_list_size - 1];
 
 				if ((flags & TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE) != 0 && a.kind == ACCESS_SWIZZLE && a.access_swizzle.swizzle.size > 1) {
-					assert(is_vector(o->op_load_access_list.to.type.type));
-
-					type_id to_type = vector_base_type(o->op_load_access_list.to.type.type);
+					assert(is_vector(o->op_load_access_list.to.type));
 
-					type_ref t;
-					init_type_ref(&t, NO_NAME);
-					t.type = to_type;
+					type_id to_type = vector_base_type(o->op_load_access_list.to.type);
 
 					variable to[4];
 
 					for (uint32_t swizzle_index = 0; swizzle_index < a.access_swizzle.swizzle.size; ++swizzle_index) {
-						to[swizzle_index] = allocate_variable(t, o->op_load_access_list.to.kind);
+						to[swizzle_index] = allocate_variable(to_type, o->op_load_access_list.to.kind);
 
-						opcode new_opcode = *o;
+						opcode new_opcode;
+						memcpy(&new_opcode, o, o->size);
 
 						new_opcode.op_load_access_list.to = to[swizzle_index];
 
@@ -127,13 +3059,14 @@ void transform(uint32_t flags) {
 					    .type = OPCODE_CALL,
 					    .op_call =
 					        {
-					            .func            = get_type(o->op_load_access_list.to.type.type)->name,
+					            .func            = get_type(o->op_load_access_list.to.type)->name,
+					            .callee          = find_function(get_type(o->op_load_access_list.to.type)->name),
 					            .parameters      = {to[0], to[1], to[2], to[3]},
 					            .parameters_size = a.access_swizzle.swizzle.size,
 					            .var             = o->op_load_access_list.to,
 					        },
 					};
-					constructor_call.size = OP_SIZE(constructor_call, op_call);
+					constructor_call.size = OP_SIZE_CALL(constructor_call);
 					copy_opcode(&constructor_call);
 				}
 				else {
@@ -145,8 +3078,8 @@ void transform(uint32_t flags) {
 			case OPCODE_SUB:
 			case OPCODE_MULTIPLY:
 			case OPCODE_DIVIDE: {
-				type_id left_type  = o->op_binary.left.type.type;
-				type_id right_type = o->op_binary.right.type.type;
+				type_id left_type  = o->op_binary.left.type;
+				type_id right_type = o->op_binary.right.type;
 
 				if (is_matrix(left_type) || is_matrix(right_type)) {
 					copy_opcode(o);
@@ -161,9 +3094,7 @@ void transform(uint32_t flags) {
 						variable last;
 
 						if (is_vector(left_type)) {
-							type_ref t;
-							init_type_ref(&t, NO_NAME);
-							t.type = vector_base_type(left_type);
+							type_id t = vector_base_type(left_type);
 
 							last = allocate_variable(t, o->op_binary.left.kind);
 
@@ -177,7 +3108,7 @@ void transform(uint32_t flags) {
 							                {
 							                    {
 							                        .kind = ACCESS_SWIZZLE,
-							                        .type = t.type,
+							                        .type = t,
 							                        .access_swizzle =
 							                            {
 							                                .swizzle =
@@ -191,7 +3122,7 @@ void transform(uint32_t flags) {
 							            .access_list_size = 1,
 							        },
 							};
-							load_call.size = OP_SIZE(load_call, op_load_access_list);
+							load_call.size = OP_SIZE_ACCESS_LIST(load_call, op_load_access_list);
 
 							copy_opcode(&load_call);
 						}
@@ -201,9 +3132,7 @@ void transform(uint32_t flags) {
 
 						variable vec;
 						{
-							type_ref t;
-							init_type_ref(&t, NO_NAME);
-							t.type = vector_to_size(left_type, right_size);
+							type_id t = vector_to_size(left_type, right_size);
 
 							vec = allocate_variable(t, VARIABLE_INTERNAL);
 
@@ -212,11 +3141,12 @@ void transform(uint32_t flags) {
 							    .op_call =
 							        {
 							            .func            = get_type(right_type)->name,
+							            .callee          = find_function(get_type(right_type)->name),
 							            .parameters_size = right_size,
 							            .var             = vec,
 							        },
 							};
-							constructor_call.size = OP_SIZE(constructor_call, op_call);
+							constructor_call.size = OP_SIZE_CALL(constructor_call);
 
 							constructor_call.op_call.parameters[0] = o->op_binary.left;
 
@@ -228,7 +3158,8 @@ void transform(uint32_t flags) {
 						}
 
 						{
-							opcode bin         = *o;
+							opcode bin;
+							memcpy(&bin, o, o->size);
 							bin.op_binary.left = vec;
 
 							copy_opcode(&bin);
@@ -238,9 +3169,7 @@ void transform(uint32_t flags) {
 						variable last;
 
 						if (is_vector(right_type)) {
-							type_ref t;
-							init_type_ref(&t, NO_NAME);
-							t.type = vector_base_type(right_type);
+							type_id t = vector_base_type(right_type);
 
 							last = allocate_variable(t, o->op_binary.right.kind);
 
@@ -254,7 +3183,7 @@ void transform(uint32_t flags) {
 							                {
 							                    {
 							                        .kind = ACCESS_SWIZZLE,
-							                        .type = t.type,
+							                        .type = t,
 							                        .access_swizzle =
 							                            {
 							                                .swizzle =
@@ -268,7 +3197,7 @@ void transform(uint32_t flags) {
 							            .access_list_size = 1,
 							        },
 							};
-							load_call.size = OP_SIZE(load_call, op_load_access_list);
+							load_call.size = OP_SIZE_ACCESS_LIST(load_call, op_load_access_list);
 
 							copy_opcode(&load_call);
 						}
@@ -278,9 +3207,7 @@ void transform(uint32_t flags) {
 
 						variable vec;
 						{
-							type_ref t;
-							init_type_ref(&t, NO_NAME);
-							t.type = vector_to_size(left_type, left_size);
+							type_id t = vector_to_size(left_type, left_size);
 
 							vec = allocate_variable(t, VARIABLE_INTERNAL);
 
@@ -289,11 +3216,12 @@ void transform(uint32_t flags) {
 							    .op_call =
 							        {
 							            .func            = get_type(left_type)->name,
+							            .callee          = find_function(get_type(left_type)->name),
 							            .parameters_size = left_size,
 							            .var             = vec,
 							        },
 							};
-							constructor_call.size = OP_SIZE(constructor_call, op_call);
+							constructor_call.size = OP_SIZE_CALL(constructor_call);
 
 							constructor_call.op_call.parameters[0] = o->op_binary.right;
 
@@ -305,7 +3233,8 @@ void transform(uint32_t flags) {
 						}
 
 						{
-							opcode bin          = *o;
+							opcode bin;
+							memcpy(&bin, o, o->size);
 							bin.op_binary.right = vec;
 
 							copy_opcode(&bin);
@@ -325,6 +3254,17 @@ void transform(uint32_t flags) {
 			index += o->size;
 		}
 
-		f->code = new_code;
+		end_function_variables(f);
+
+		// swap so the old buffer is reused for the next function
+		opcodes old_code = f->code;
+		f->code          = new_code;
+		new_code         = old_code;
+	}
+
+	if ((flags & TRANSFORM_FLAGS_OPTIMIZE) != 0) {
+		optimize_functions(flags);
 	}
+
+	analyzer_reset();
 }
@@ -5,6 +5,19 @@
 
 #define TRANSFORM_FLAG_ONE_COMPONENT_SWIZZLE (1 << 0)
 #define TRANSFORM_FLAG_BINARY_UNIFY_LENGTH   (1 << 1)
+#define TRANSFORM_FLAG_DEAD_CODE             (1 << 2)
+#define TRANSFORM_FLAG_FOLD_CONSTANTS        (1 << 3)
+#define TRANSFORM_FLAG_COMMON_SUBEXPRESSIONS (1 << 4)
+#define TRANSFORM_FLAG_INLINE                (1 << 5)
+#define TRANSFORM_FLAG_LOOP_INVARIANTS       (1 << 6)
+#define TRANSFORM_FLAG_FUSE_COMPONENTS       (1 << 7)
+#define TRANSFORM_FLAG_SWIZZLE_STORES        (1 << 8)
+#define TRANSFORM_FLAG_PROPAGATE_COPIES      (1 << 9)
+
+// the passes that only make the code smaller or faster, the rest is needed by some backends
+#define TRANSFORM_FLAGS_OPTIMIZE                                                                                                     \
+	(TRANSFORM_FLAG_INLINE | TRANSFORM_FLAG_FOLD_CONSTANTS | TRANSFORM_FLAG_LOOP_INVARIANTS | TRANSFORM_FLAG_COMMON_SUBEXPRESSIONS | \
+	 TRANSFORM_FLAG_PROPAGATE_COPIES | TRANSFORM_FLAG_FUSE_COMPONENTS | TRANSFORM_FLAG_DEAD_CODE)
 
 void transform(uint32_t flags);
 
@@ -3,6 +3,7 @@
 #include "errors.h"
 #include "functions.h"
 #include "globals.h"
+#include "jobs.h"
 #include "log.h"
 #include "names.h"
 #include "parser.h"
@@ -593,12 +594,9 @@ void resolve_types_in_expression(statement *parent, expression *e) {
 			}
 		}
 		else {
-			for (function_id i = 0; get_function(i) != NULL; ++i) {
-				function *f = get_function(i);
-				if (f->name == e->call.func_name) {
-					e->type = f->return_type;
-					break;
-				}
+			function_id f = find_function(e->call.func_name);
+			if (f != NO_FUNCTION) {
+				e->type = get_function(f)->return_type;
 			}
 		}
 
@@ -682,6 +680,7 @@ void resolve_types_in_block(statement *parent, statement *block) {
 				resolve_types_in_expression(block, s->local_variable.init);
 			}
 
+			assert(block->block.vars.size < block->block.vars.capacity);
 			block->block.vars.v[block->block.vars.size].name = var_name;
 			block->block.vars.v[block->block.vars.size].type = s->local_variable.var.type;
 			++block->block.vars.size;
@@ -691,6 +690,59 @@ void resolve_types_in_block(statement *parent, statement *block) {
 	}
 }
 
+// Local variables can name array types that do not exist yet. Adding types is not thread safe, so they are looked up before the
+// functions are typed in parallel, in the order the typer would otherwise meet them.
+static void find_local_variable_types(statement *block) {
+	for (size_t i = 0; i < block->block.statements.size; ++i) {
+		statement *s = block->block.statements.s[i];
+		switch (s->kind) {
+		case STATEMENT_IF: {
+			find_local_variable_types(s->iffy.if_block);
+			for (uint16_t else_index = 0; else_index < s->iffy.else_size; ++else_index) {
+				find_local_variable_types(s->iffy.else_blocks[else_index]);
+			}
+			break;
+		}
+		case STATEMENT_WHILE:
+		case STATEMENT_DO_WHILE: {
+			find_local_variable_types(s->whiley.while_block);
+			break;
+		}
+		case STATEMENT_BLOCK: {
+			find_local_variable_types(s);
+			break;
+		}
+		case STATEMENT_LOCAL_VARIABLE: {
+			if (s->local_variable.var.type.type == NO_TYPE && s->local_variable.var.type.unresolved.name != NO_NAME) {
+				s->local_variable.var.type.type = find_type_by_ref(&s->local_variable.var.type);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+static void resolve_types_job(void *data, size_t index) {
+	function *f = get_function((function_id)index);
+
+	if (f->block == NULL) {
+		// built in
+		return;
+	}
+
+	for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
+		assert(f->block->block.vars.size < f->block->block.vars.capacity);
+		f->block->block.vars.v[f->block->block.vars.size].name        = f->parameter_names[parameter_index];
+		f->block->block.vars.v[f->block->block.vars.size].type        = f->parameter_types[parameter_index];
+		f->block->block.vars.v[f->block->block.vars.size].variable_id = 0;
+		++f->block->block.vars.size;
+	}
+
+	resolve_types_in_block(NULL, f->block);
+}
+
 void resolve_types(void) {
 	for (type_id i = 0; get_type(i) != NULL; ++i) {
 		type *s = get_type(i);
@@ -729,21 +781,13 @@ void resolve_types(void) {
 		}
 	}
 
-	for (function_id i = 0; get_function(i) != NULL; ++i) {
-		function *f = get_function(i);
-
-		if (f->block == NULL) {
-			// built in
-			continue;
+	function_id functions_count = 0;
+	for (; get_function(functions_count) != NULL; ++functions_count) {
+		function *f = get_function(functions_count);
+		if (f->block != NULL) {
+			find_local_variable_types(f->block);
 		}
-
-		for (uint8_t parameter_index = 0; parameter_index < f->parameters_size; ++parameter_index) {
-			f->block->block.vars.v[f->block->block.vars.size].name        = f->parameter_names[parameter_index];
-			f->block->block.vars.v[f->block->block.vars.size].type        = f->parameter_types[parameter_index];
-			f->block->block.vars.v[f->block->block.vars.size].variable_id = 0;
-			++f->block->block.vars.size;
-		}
-
-		resolve_types_in_block(NULL, f->block);
 	}
+
+	jobs_run(resolve_types_job, NULL, functions_count);
 }
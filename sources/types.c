@@ -1,6 +1,7 @@
 #include "types.h"
 
 #include "errors.h"
+#include "name_map.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -10,6 +11,13 @@ static type   *types           = NULL;
 static type_id types_size      = 1024;
 static type_id next_type_index = 0;
 
+static type   *snapshot_types      = NULL;
+static type_id snapshot_types_size = 0;
+
+// types_by_name points to the newest type of each name, older types of the same name (like array variants) are chained from there
+static name_map types_by_name           = {0};
+static type_id *previous_type_with_name = NULL;
+
 type_id void_id;
 type_id float_id;
 type_id float2_id;
@@ -46,6 +54,12 @@ typedef struct prefix {
 	size_t size;
 } prefix;
 
+static void index_type(type_id t) {
+	uint32_t previous          = name_map_get(&types_by_name, types[t].name);
+	previous_type_with_name[t] = previous == NAME_MAP_NOT_FOUND ? NO_TYPE : previous;
+	name_map_set(&types_by_name, types[t].name, t);
+}
+
 void init_type_ref(type_ref *t, name_id name) {
 	t->type                  = NO_TYPE;
 	t->unresolved.name       = name;
@@ -56,8 +70,14 @@ void types_init(void) {
 	type         *new_types = realloc(types, types_size * sizeof(type));
 	debug_context context   = {0};
 	check(new_types != NULL, context, "Could not allocate types");
-	types           = new_types;
+	types = new_types;
+
+	type_id *new_previous_type_with_name = realloc(previous_type_with_name, types_size * sizeof(type_id));
+	check(new_previous_type_with_name != NULL, context, "Could not allocate types");
+	previous_type_with_name = new_previous_type_with_name;
+
 	next_type_index = 0;
+	name_map_clear(&types_by_name);
 
 	void_id                     = add_type(add_name("void"));
 	get_type(void_id)->built_in = true;
@@ -171,6 +191,25 @@ void types_init(void) {
 	}
 }
 
+void types_snapshot(void) {
+	free(snapshot_types);
+	snapshot_types = malloc(next_type_index * sizeof(type));
+	debug_context context = {0};
+	check(snapshot_types != NULL, context, "Could not allocate types snapshot");
+	memcpy(snapshot_types, types, next_type_index * sizeof(type));
+	snapshot_types_size = next_type_index;
+}
+
+void types_restore(void) {
+	memcpy(types, snapshot_types, snapshot_types_size * sizeof(type));
+	next_type_index = snapshot_types_size;
+
+	name_map_clear(&types_by_name);
+	for (type_id i = 0; i < next_type_index; ++i) {
+		index_type(i);
+	}
+}
+
 static void grow_if_needed(uint64_t size) {
 	while (size >= types_size) {
 		types_size *= 2;
@@ -178,9 +217,18 @@ static void grow_if_needed(uint64_t size) {
 		debug_context context   = {0};
 		check(new_types != NULL, context, "Could not allocate types");
 		types = new_types;
+
+		type_id *new_previous_type_with_name = realloc(previous_type_with_name, types_size * sizeof(type_id));
+		check(new_previous_type_with_name != NULL, context, "Could not allocate types");
+		previous_type_with_name = new_previous_type_with_name;
 	}
 }
 
+static type_id newest_type_with_name(name_id name) {
+	uint32_t t = name_map_get(&types_by_name, name);
+	return t == NAME_MAP_NOT_FOUND ? NO_TYPE : t;
+}
+
 static bool types_equal(type *a, type *b) {
 	return a->name == b->name && a->attributes.attributes_count == 0 && b->attributes.attributes_count == 0 && a->members.size == 0 && b->members.size == 0 &&
 	       a->built_in == b->built_in && a->array_size == b->array_size && a->base == b->base && a->tex_kind == b->tex_kind && a->tex_format == b->tex_format;
@@ -201,15 +249,21 @@ type_id add_type(name_id name) {
 	types[s].tex_kind                    = TEXTURE_KIND_NONE;
 	types[s].tex_format                  = TEXTURE_FORMAT_UNDEFINED;
 
+	index_type(s);
+
 	return s;
 }
 
 type_id add_full_type(type *t) {
-	for (type_id type_index = 0; type_index < next_type_index; ++type_index) {
-		if (types_equal(&types[type_index], t)) {
-			return type_index;
+	type_id equal_type = NO_TYPE;
+	for (type_id i = newest_type_with_name(t->name); i != NO_TYPE; i = previous_type_with_name[i]) {
+		if (types_equal(&types[i], t)) {
+			equal_type = i;
 		}
 	}
+	if (equal_type != NO_TYPE) {
+		return equal_type;
+	}
 
 	grow_if_needed(next_type_index + 1);
 
@@ -218,19 +272,21 @@ type_id add_full_type(type *t) {
 
 	types[s] = *t;
 
+	index_type(s);
+
 	return s;
 }
 
 type_id find_type_by_name(name_id name) {
 	debug_context context = {0};
 	check(name != NO_NAME, context, "Attempted to find a no-name");
-	for (type_id i = 0; i < next_type_index; ++i) {
-		if (types[i].name == name) {
-			return i;
-		}
+
+	type_id oldest = NO_TYPE;
+	for (type_id i = newest_type_with_name(name); i != NO_TYPE; i = previous_type_with_name[i]) {
+		oldest = i;
 	}
 
-	return NO_TYPE;
+	return oldest;
 }
 
 type_id find_type_by_ref(type_ref *t) {
@@ -241,17 +297,19 @@ type_id find_type_by_ref(type_ref *t) {
 	debug_context context = {0};
 	check(t->unresolved.name != NO_NAME, context, "Attempted to find a no-name");
 
-	type_id base_type_id = NO_TYPE;
+	type_id base_type_id = newest_type_with_name(t->unresolved.name);
+	type_id found        = NO_TYPE;
 
-	for (type_id i = 0; i < next_type_index; ++i) {
-		if (types[i].name == t->unresolved.name) {
-			if (types[i].array_size == t->unresolved.array_size) {
-				return i;
-			}
-			base_type_id = i;
+	for (type_id i = base_type_id; i != NO_TYPE; i = previous_type_with_name[i]) {
+		if (types[i].array_size == t->unresolved.array_size) {
+			found = i;
 		}
 	}
 
+	if (found != NO_TYPE) {
+		return found;
+	}
+
 	if (base_type_id != NO_TYPE) {
 		type_id new_type_id  = add_type(t->unresolved.name);
 		type   *new_type     = get_type(new_type_id);
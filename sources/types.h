@@ -129,6 +129,8 @@ typedef struct type {
 } type;
 
 void types_init(void);
+void types_snapshot(void);
+void types_restore(void);
 
 type_id add_type(name_id name);
 
@@ -0,0 +1,120 @@
+// Compiles a directory of Kongruent code a number of times and prints the best and the mean wall time. When --timings is
+// passed on to kongruent, the mean of every phase it logs is printed as well. On Linux one more run measures the peak memory.
+//
+// Usage: node tools/benchmark.js <kongruent> <directory> [runs] [kongruent options]
+//
+// The scaling figures are measured on generated programs of growing size:
+//   for n in 1000 4000 16000; do
+//     node tools/generate.js /tmp/kong_$n $n
+//     node tools/benchmark.js build/release/kongruent /tmp/kong_$n 5 -p linux -a opengl
+//   done
+//
+// The phase breakdown uses a library of 5000 functions, 1250 structs and 800 constants:
+//   node tools/generate.js /tmp/kong_library 5000
+//   node tools/benchmark.js build/release/kongruent /tmp/kong_library 5 -p linux -a opengl -j 1 --timings
+//
+// The SPIR-V export is measured on 200 pipelines:
+//   node tools/generate.js /tmp/kong_pipelines 1000 200
+//   node tools/benchmark.js build/release/kongruent /tmp/kong_pipelines 15 -p linux -a vulkan
+
+const child_process = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+function run(kongruent, directory, output, options) {
+	fs.rmSync(output, {recursive: true, force: true});
+	fs.mkdirSync(output, {recursive: true});
+
+	const start = process.hrtime.bigint();
+	const result = child_process.spawnSync(kongruent, ['-i', directory, '-o', output, ...options], {encoding: 'utf8'});
+	const time = Number(process.hrtime.bigint() - start) / 1000000;
+
+	if (result.status !== 0) {
+		console.log(result.stderr);
+		console.log('kongruent failed with ' + (result.status !== null ? 'exit code ' + result.status : result.signal) + '.');
+		process.exit(1);
+	}
+
+	return {time: time, log: result.stdout};
+}
+
+// the phase lines of --timings look like "  resolve types:        11.23 ms"
+function addPhases(phases, log) {
+	for (const line of log.split('\n')) {
+		const match = /^  ([a-z ,]+):\s+([0-9.]+) ms$/.exec(line);
+		if (match !== null) {
+			phases[match[1]] = (phases[match[1]] || 0) + parseFloat(match[2]);
+		}
+	}
+}
+
+// Polls /proc while kongruent runs. This keeps a core busy so it is a separate run. The peak resident and virtual sizes
+// are kept by the kernel, the last values read before the process turns into a zombie are the final ones.
+function measureMemory(kongruent, directory, output, options, callback) {
+	fs.rmSync(output, {recursive: true, force: true});
+	fs.mkdirSync(output, {recursive: true});
+
+	const child = child_process.spawn(kongruent, ['-i', directory, '-o', output, ...options], {stdio: 'ignore'});
+
+	let resident = 0;
+	let virtual = 0;
+	for (;;) {
+		let status;
+		try {
+			status = fs.readFileSync('/proc/' + child.pid + '/status', 'utf8');
+		}
+		catch (error) {
+			break;
+		}
+
+		const residentMatch = /VmHWM:\s+([0-9]+) kB/.exec(status);
+		const virtualMatch = /VmPeak:\s+([0-9]+) kB/.exec(status);
+		if (residentMatch === null || virtualMatch === null) {
+			break;
+		}
+		resident = parseInt(residentMatch[1]);
+		virtual = parseInt(virtualMatch[1]);
+	}
+
+	child.on('exit', () => {
+		callback(resident, virtual);
+	});
+}
+
+if (process.argv.length < 4) {
+	console.log('Usage: node tools/benchmark.js <kongruent> <directory> [runs] [kongruent options]');
+	process.exit(1);
+}
+
+const kongruent = path.resolve(process.argv[2]);
+const directory = process.argv[3];
+const runs = process.argv.length > 4 ? parseInt(process.argv[4]) : 5;
+const options = process.argv.slice(5);
+const output = fs.mkdtempSync(path.join(os.tmpdir(), 'kong_benchmark_'));
+
+const times = [];
+const phases = {};
+for (let i = 0; i < runs; ++i) {
+	const result = run(kongruent, directory, output, options);
+	times.push(result.time);
+	addPhases(phases, result.log);
+}
+
+const best = Math.min(...times);
+const mean = times.reduce((sum, time) => sum + time, 0) / times.length;
+console.log(directory + ': best ' + best.toFixed(1) + ' ms, mean ' + mean.toFixed(1) + ' ms of ' + runs + ' runs');
+
+for (const phase in phases) {
+	console.log('  ' + (phase + ':').padEnd(21) + (phases[phase] / runs).toFixed(2).padStart(10) + ' ms');
+}
+
+if (process.platform === 'linux') {
+	measureMemory(kongruent, directory, output, options, (resident, virtual) => {
+		fs.rmSync(output, {recursive: true, force: true});
+		console.log('  peak resident ' + (resident / 1024).toFixed(1) + ' MiB, peak virtual ' + (virtual / 1024).toFixed(1) + ' MiB');
+	});
+}
+else {
+	fs.rmSync(output, {recursive: true, force: true});
+}
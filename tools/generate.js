@@ -0,0 +1,72 @@
+// Writes a synthetic Kongruent program for the benchmarks: a number of functions, a quarter as many structs and up to 800
+// constants. Every function fills a struct, reads a constant and calls the two functions before it. The functions go into
+// files of 100 functions each. Like a shader library most of it is not used, the pipelines only reach the first 16
+// functions because a shader can not reference more than 256 globals. The pipelines share their vertex shader, pipelines
+// with different shaders are grouped apart and there can only be 64 groups.
+//
+// Usage: node tools/generate.js <directory> <functions> [pipelines]
+
+const fs = require('fs');
+const path = require('path');
+
+const functionsPerFile = 100;
+
+function generate(directory, functionsCount, pipelinesCount) {
+	const structsCount = Math.max(1, Math.floor(functionsCount / 4));
+	const constantsCount = Math.min(800, functionsCount);
+
+	fs.mkdirSync(directory, {recursive: true});
+
+	let structs = '';
+	for (let i = 0; i < structsCount; ++i) {
+		structs += 'struct data' + i + ' {\n    value: float4;\n    scale: float;\n}\n\n';
+	}
+	fs.writeFileSync(path.join(directory, 'structs.kong'), structs);
+
+	let constants = '';
+	for (let i = 0; i < constantsCount; ++i) {
+		constants += 'const constant' + i + ': float = ' + i + '.5;\n';
+	}
+	fs.writeFileSync(path.join(directory, 'constants.kong'), constants);
+
+	for (let file = 0; file * functionsPerFile < functionsCount; ++file) {
+		let code = '';
+		for (let i = file * functionsPerFile; i < Math.min((file + 1) * functionsPerFile, functionsCount); ++i) {
+			code += 'fun function' + i + '(input: float4): float4 {\n';
+			code += '    var data: data' + (i % structsCount) + ';\n';
+			code += '    data.value = input * constant' + (i % constantsCount) + ';\n';
+			code += '    data.scale = input.x + ' + i + '.0;\n';
+			code += '    var result: float4 = data.value * data.scale;\n';
+			for (let callee = Math.max(0, i - 2); callee < i; ++callee) {
+				code += '    result += function' + callee + '(result);\n';
+			}
+			code += '    return result;\n';
+			code += '}\n\n';
+		}
+		fs.writeFileSync(path.join(directory, 'functions' + file + '.kong'), code);
+	}
+
+	const reachableCount = Math.min(functionsCount, 16);
+
+	let main = 'struct generated_vertex_in {\n    position: float3;\n}\n\n';
+	main += 'struct generated_vertex_out {\n    position: float4;\n}\n\n';
+	main += 'fun generated_vertex(input: generated_vertex_in): generated_vertex_out {\n';
+	main += '    var output: generated_vertex_out;\n';
+	main += '    output.position = float4(input.position, 1.0);\n';
+	main += '    return output;\n';
+	main += '}\n\n';
+	for (let i = 0; i < pipelinesCount; ++i) {
+		main += 'fun generated_pixel' + i + '(input: generated_vertex_out): float4 {\n';
+		main += '    return function' + (reachableCount - 1 - (i % reachableCount)) + '(input.position * constant' + (i % constantsCount) + ');\n';
+		main += '}\n\n';
+		main += '#[pipe]\nstruct generated_pipeline' + i + ' {\n    vertex = generated_vertex;\n    fragment = generated_pixel' + i + ';\n}\n\n';
+	}
+	fs.writeFileSync(path.join(directory, 'main.kong'), main);
+}
+
+if (process.argv.length < 4) {
+	console.log('Usage: node tools/generate.js <directory> <functions> [pipelines]');
+	process.exit(1);
+}
+
+generate(process.argv[2], parseInt(process.argv[3]), process.argv.length > 4 ? parseInt(process.argv[4]) : 1);
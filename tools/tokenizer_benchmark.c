@@ -0,0 +1,104 @@
+// Measures the tokenizer throughput in MB/s. All .kong files of the input directory are tokenized over and over until
+// about 20 MB went through the tokenizer, the best of five runs is printed.
+//
+// Built from the repository root against the compiler in library mode:
+//   gcc -O2 -DKONG_LIBRARY -o tokenizer_benchmark tools/tokenizer_benchmark.c $(find sources -name '*.c') -lm -lpthread
+//   ./tokenizer_benchmark tests/in
+
+#include "../sources/dir.h"
+#include "../sources/names.h"
+#include "../sources/tokenizer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#define CORPUS_SIZE (20 * 1024 * 1024)
+#define RUNS 5
+#define MAX_FILES 1024
+
+static double milliseconds(void) {
+#ifdef _WIN32
+	int64_t counter;
+	int64_t frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter * 1000.0 / (double)frequency;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1000000.0;
+#endif
+}
+
+static bool ends_with(const char *str, const char *end) {
+	size_t str_length = strlen(str);
+	size_t end_length = strlen(end);
+	return str_length >= end_length && strcmp(&str[str_length - end_length], end) == 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		printf("Usage: tokenizer_benchmark <directory>\n");
+		return 1;
+	}
+
+	names_init();
+
+	static char        paths[MAX_FILES][1024];
+	static mapped_file files[MAX_FILES];
+	size_t             files_count = 0;
+	size_t             size        = 0;
+
+	directory dir  = open_dir(argv[1]);
+	file      file = read_next_file(&dir);
+	while (file.valid && files_count < MAX_FILES) {
+		if (ends_with(file.name, ".kong")) {
+			snprintf(paths[files_count], sizeof(paths[files_count]), "%s/%s", argv[1], file.name);
+			if (map_file(paths[files_count], &files[files_count])) {
+				size += files[files_count].size;
+				files_count += 1;
+			}
+		}
+		file = read_next_file(&dir);
+	}
+	close_dir(&dir);
+
+	if (size == 0) {
+		printf("No .kong files found in %s.\n", argv[1]);
+		return 1;
+	}
+
+	size_t passes = CORPUS_SIZE / size + 1;
+	double best   = 0.0;
+
+	for (int run = 0; run < RUNS; ++run) {
+		double start = milliseconds();
+
+		for (size_t pass = 0; pass < passes; ++pass) {
+			for (size_t i = 0; i < files_count; ++i) {
+				tokens tokens = tokenize(paths[i], files[i].data, files[i].size);
+				free(tokens.t);
+			}
+		}
+
+		double seconds = (milliseconds() - start) / 1000.0;
+		double mbs     = (double)(passes * size) / (1024.0 * 1024.0) / seconds;
+		if (mbs > best) {
+			best = mbs;
+		}
+	}
+
+	printf("%zu files, %.1f MB per run, best of %i: %.1f MB/s\n", files_count, (double)(passes * size) / (1024.0 * 1024.0), RUNS, best);
+
+	for (size_t i = 0; i < files_count; ++i) {
+		unmap_file(&files[i]);
+	}
+
+	return 0;
+}